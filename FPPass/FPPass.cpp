@@ -1,4 +1,5 @@
 #include <unordered_map>
+#include <unordered_set>
 #include <set>
 #include <string>
 #include <vector>
@@ -7,12 +8,16 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/DebugInfo.h"
 #include "llvm/Pass.h"
@@ -22,6 +27,19 @@ using namespace std;
 
 using namespace llvm;
 
+cl::opt<bool> IIDMask("iid-mask", cl::desc("Guard each callback with a per-IID enable bit set at run time"));
+
+cl::opt<bool> CountIC("count-ic", cl::desc("Only count the executions of floating-point basic blocks, for a .ic profile"));
+
+cl::opt<string> ProfileFilename("profile", cl::desc("Instrument only the hot instructions of a .ic profile"),
+								cl::value_desc("filename"));
+
+cl::opt<unsigned> ProfileTop("profile-top", cl::desc("Number of hot instructions to instrument with -profile"),
+							 cl::init(100));
+
+cl::opt<bool> InlineShadow("inline-shadow",
+						   cl::desc("Compute the low-precision shadows as SSA values next to the original operations"));
+
 class scope_guard {
 	function<void()> end;
 
@@ -38,19 +56,30 @@ Function* getFunction(string fname, FunctionType* ftype, Instruction* instr) {
 	return dyn_cast<Function>(instr->getParent()->getParent()->getParent()->getOrInsertFunction(fname, ftype));
 }
 
+// Number of IIDs handed out so far.
+unsigned iidCount = 0;
+
 Constant* getIID(Value* v) {
 	static ostringstream output;
+	static ostringstream functions;
 	static scope_guard _([]() {}, []() {
 		ofstream fout("debug.bin");
 		fout << output.str();
+		if (IIDMask) {
+			ofstream ffout("functions.bin");
+			ffout << functions.str();
+		}
 	});
 
-	static unsigned id = 0;
+	unsigned& id = iidCount;
 	static unordered_map<Value*, unsigned> encountered;
 	if (encountered.find(v) == encountered.end()) {
 		MDNode* node = nullptr;
 		Instruction* inst = nullptr;
-		if ((inst = dyn_cast<Instruction>(v)) && (node = inst->getMetadata("dbg"))) {
+		if ((inst = dyn_cast<Instruction>(v))) {
+			functions << "IID: " << id << " function: " << inst->getParent()->getParent()->getName().str() << '\n';
+		}
+		if (inst && (node = inst->getMetadata("dbg"))) {
 			DILocation loc(node);
 			output << "IID: " << id << " file: " << loc.getFilename().str() << " line: " << loc.getLineNumber()
 				   << " column: " << loc.getColumnNumber() << '\n';
@@ -87,6 +116,65 @@ CastInst* castToVoid(Value* v, Instruction* i) {
 	return ci;
 }
 
+// Calls to be guarded by the enable bit of their IID, see insertIIDMask. Only
+// the callbacks that compute shadow values (fbinop, fcmp, math calls and
+// fblame) are guarded: loads, stores, phis and call results also keep the
+// runtime's IID translation and pointer tables up to date, and skipping them
+// would leave later enabled sites reading stale entries.
+vector<pair<CallInst*, unsigned>> guarded;
+
+void guard(CallInst* ci, Constant* iid) {
+	int64_t id = cast<ConstantInt>(iid)->getSExtValue();
+	if (IIDMask && id >= 0) {
+		guarded.push_back(make_pair(ci, (unsigned)id));
+	}
+}
+
+// Emit the number of IIDs fppass_iid_count, so that the runtime can size its
+// IID-indexed tables up front.
+void insertIIDCount(Module& M) {
+	Type* int32Ty = Type::getInt32Ty(M.getContext());
+	new GlobalVariable(M, int32Ty, true, GlobalValue::ExternalLinkage, ConstantInt::get(int32Ty, iidCount),
+					   "fppass_iid_count");
+}
+
+// Emit the enable bitmap fppass_iid_mask (all sites enabled), then put every
+// guarded call behind a test of its bit:
+//
+//   if (fppass_iid_mask[iid / 8] & (1 << iid % 8)) call
+//
+// The runtime clears bits at startup to disable sites.
+void insertIIDMask(Module& M) {
+	LLVMContext& cx = M.getContext();
+	Type* int8Ty = Type::getInt8Ty(cx);
+	Type* int32Ty = Type::getInt32Ty(cx);
+
+	ArrayType* maskType = ArrayType::get(int8Ty, (iidCount + 7) / 8);
+	vector<Constant*> ones(maskType->getNumElements(), ConstantInt::get(int8Ty, 0xff));
+	GlobalVariable* mask = new GlobalVariable(M, maskType, false, GlobalValue::ExternalLinkage,
+			ConstantArray::get(maskType, ones), "fppass_iid_mask");
+
+	for (auto& g : guarded) {
+		CallInst* ci = g.first;
+		unsigned iid = g.second;
+
+		BasicBlock* head = ci->getParent();
+		BasicBlock::iterator next = ci;
+		++next;
+		BasicBlock* tail = head->splitBasicBlock(next);
+		BasicBlock* then = head->splitBasicBlock(ci);
+
+		TerminatorInst* term = head->getTerminator();
+		Constant* idx[] = {ConstantInt::get(int32Ty, 0), ConstantInt::get(int32Ty, iid / 8)};
+		LoadInst* byte = new LoadInst(ConstantExpr::getInBoundsGetElementPtr(mask, idx), "", term);
+		Value* bit = BinaryOperator::CreateAnd(byte, ConstantInt::get(int8Ty, 1 << (iid % 8)), "", term);
+		Value* on = new ICmpInst(term, ICmpInst::ICMP_NE, bit, ConstantInt::get(int8Ty, 0));
+		BranchInst::Create(then, tail, on, term);
+		term->eraseFromParent();
+	}
+	guarded.clear();
+}
+
 bool useful(FCmpInst* fci) {
 	switch (fci->getPredicate()) {
 		case CmpInst::Predicate::FCMP_OEQ:
@@ -140,6 +228,7 @@ void _handle(FCmpInst* fci_instr, Function* f) {
 						  };
 	CallInst* ci = llvm::CallInst::Create(f, args);
 	ci->insertAfter(fci_instr);
+	guard(ci, iid);
 }
 
 
@@ -197,6 +286,7 @@ void _handle(BinaryOperator* bin_instr, Function* f) {
 
 	CallInst* ci = llvm::CallInst::Create(f, args);
 	ci->insertAfter(last);
+	guard(ci, iid);
 }
 
 bool useful(CallInst*) {
@@ -259,6 +349,7 @@ bool _handleMathCall(CallInst* call_inst, Function* f) {
 
 		CallInst* ci = llvm::CallInst::Create(f, args);
 		ci->insertAfter(last);
+		guard(ci, iid);
 
 		return true;
 	}
@@ -279,11 +370,44 @@ FunctionType* to_function_type_after_call(CallInst* instr) {
 	return FunctionType::get(Type::getVoidTy(cx), vector<Type*>({Type::getInt32Ty(cx), Type::getDoubleTy(cx)}), false);
 }
 
+// A call whose floating-point arguments or result the runtime tracks gets a
+// frame on the shadow call stack, pushed before its llvm_arg calls and popped
+// after its llvm_after_call.
+bool needsFrame(CallInst* ci) {
+	if (useful_after_call(ci)) {
+		return true;
+	}
+	for (unsigned i = 0; i < ci->getNumArgOperands(); i++) {
+		if (ci->getArgOperand(i)->getType()->isFloatingPointTy()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+FunctionType* to_function_type_frame(CallInst* instr) {
+	return FunctionType::get(Type::getVoidTy(instr->getContext()), false);
+}
+
+// llvm_push_frame takes the called function, which llvm_return matches.
+FunctionType* to_function_type_push(CallInst* instr) {
+	LLVMContext& cx = instr->getContext();
+	return FunctionType::get(Type::getVoidTy(cx), vector<Type*>({PointerType::get(Type::getVoidTy(cx), 0)}), false);
+}
+
 void _handle(CallInst* call_inst, Function* f) {
 	if (_handleMathCall(call_inst, f)) {
 		return;
 	}
 
+	if (needsFrame(call_inst)) {
+		Value* callee = castToVoid(call_inst->getCalledValue(), call_inst);
+		Function* f_push = getFunction("llvm_push_frame", to_function_type_push(call_inst), call_inst);
+		llvm::CallInst::Create(f_push, vector<Value*>({callee}))->insertBefore(call_inst);
+		Function* f_pop = getFunction("llvm_pop_frame", to_function_type_frame(call_inst), call_inst);
+		llvm::CallInst::Create(f_pop)->insertAfter(call_inst);
+	}
+
 	for (unsigned i = 0; i < call_inst->getNumArgOperands(); i++) {
 		Argument* arg = (Argument*)call_inst->getArgOperand(i);
 		if (!arg->getType()->isFloatingPointTy()) {
@@ -351,13 +475,17 @@ string to_function_name(ReturnInst*) {
 
 FunctionType* to_function_type(ReturnInst* instr) {
 	LLVMContext& cx = instr->getContext();
-	return FunctionType::get(Type::getVoidTy(cx), vector<Type*>({Type::getInt32Ty(cx)}), false);
+	return FunctionType::get(Type::getVoidTy(cx),
+							 vector<Type*>({PointerType::get(Type::getVoidTy(cx), 0), Type::getInt32Ty(cx)}), false);
 }
 
+// The returning function is passed along, so that the runtime only binds
+// the return to a frame pushed by a call to it.
 void _handle(ReturnInst* return_inst, Function* f) {
 	Value* v = return_inst->getReturnValue();
 	auto iid = getIID(v);
-	vector<Value*> args = {iid};
+	Value* function = castToVoid(return_inst->getParent()->getParent(), return_inst);
+	vector<Value*> args = {function, iid};
 	CallInst* ci = llvm::CallInst::Create(f, args);
 	ci->insertBefore(return_inst);
 }
@@ -454,6 +582,618 @@ void _handle(PHINode* phi_inst, Function* f) {
 	}
 }
 
+// ***** Inline shadow mode ***** //
+//
+// With -inline-shadow, the shadow of every float or double value is kept in
+// SSA values next to the value itself: the IID the value is blamed on and
+// the value in float and in the two truncated double precisions of the blame
+// analysis (the double precision shadow is the value itself). Shadows flow
+// through phi nodes and selects. At loads and stores the instrumented code
+// reads and writes the shadow memory of the runtime directly, and at call
+// boundaries it passes the shadows in thread-local slots of the runtime. The
+// runtime is only called to record blame decisions and to materialize pages
+// of shadow memory. With -profile, only the hot operations compute shadows
+// and record blame; the others start fresh shadows.
+
+// Mantissa bits of the truncated precisions, see PRECISION_BITS in the blame
+// analysis runtime.
+const int SHADOW_DOUBLE_MANTISSA = 52;
+const int SHADOW_BITS_19 = 19;
+const int SHADOW_BITS_27 = 27;
+
+// Layout of the shadow memory (AddressShadow and ShadowDirectory of the
+// runtime), the number of argument slots (LLVM_SHADOW_ARGS) and the fields of
+// a slot (StoredShadow, whose writer is the IID + 1, 0 when empty).
+const unsigned SHADOW_PAGE_BITS = 22;
+const unsigned SHADOW_COLUMN_BITS = 2;
+const unsigned SHADOW_GRANULE_BITS = 2;
+const unsigned SHADOW_ARGS = 16;
+enum { SLOT_WRITER, SLOT_F, SLOT_B19, SLOT_B27, SLOT_VALUE };
+
+bool isShadowed(Type* type) {
+	return type->isFloatTy() || type->isDoubleTy();
+}
+
+// The same as clearBits in the blame analysis runtime.
+double clearBitsConstant(double v, int shift) {
+	if (std::isnan(v) || std::isinf(v)) {
+		return v;
+	}
+	uint64_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	bits &= ~0ull << shift;
+	memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+int toMathFunc(CallInst* ci) {
+	// MATHFUNC of the blame analysis runtime
+	static const unordered_map<string, int> funcs = {{"sin", 0}, {"acos", 1}, {"sqrt", 2}, {"fabs", 3},
+		{"cos", 4}, {"log", 5}, {"exp", 6}, {"floor", 7}
+	};
+	if (ci->getCalledFunction() == nullptr || ci->getNumArgOperands() != 1) {
+		return -1;
+	}
+	auto it = funcs.find(ci->getCalledFunction()->getName());
+	return it == funcs.end() ? -1 : it->second;
+}
+
+int toBinOp(BinaryOperator* bi) {
+	// FBINOP of the blame analysis runtime
+	switch (bi->getOpcode()) {
+		case Instruction::FAdd:
+			return 0;
+		case Instruction::FSub:
+			return 1;
+		case Instruction::FMul:
+			return 2;
+		case Instruction::FDiv:
+			return 3;
+		default:
+			return -1;
+	}
+}
+
+int toCmpOp(FCmpInst* fci) {
+	// CMPOP of the blame analysis runtime
+	switch (fci->getPredicate()) {
+		case CmpInst::Predicate::FCMP_OEQ:
+			return 0;
+		case CmpInst::Predicate::FCMP_OGT:
+			return 1;
+		case CmpInst::Predicate::FCMP_OGE:
+			return 2;
+		case CmpInst::Predicate::FCMP_OLT:
+			return 3;
+		case CmpInst::Predicate::FCMP_OLE:
+			return 4;
+		case CmpInst::Predicate::FCMP_ONE:
+			return 5;
+		default:
+			return -1;
+	}
+}
+
+// Whether the shadows of the arguments and of the result of ci are passed in
+// the slots of the runtime: the callee is instrumented, or may be.
+bool passesShadows(CallInst* ci) {
+	Function* callee = ci->getCalledFunction();
+	return toMathFunc(ci) == -1 && (callee == nullptr || !callee->isDeclaration());
+}
+
+bool profiled(Instruction* inst);
+
+struct Shadow {
+	Value* iid;
+	Value* f;
+	Value* b19;
+	Value* b27;
+};
+
+class ShadowBuilder {
+	Function& F;
+	Module& M;
+	LLVMContext& cx;
+	Type* int32Ty;
+	Type* int64Ty;
+	Type* floatTy;
+	Type* doubleTy;
+	Type* voidPtrTy;
+	StructType* slotTy;  // StoredShadow of the runtime
+	PointerType* slotPtrTy;
+	unordered_map<Value*, Shadow> shadows;
+	Value* directory = nullptr;  // pages of the shadow memory, see shadowDirectory
+
+public:
+	ShadowBuilder(Function& F)
+		: F(F), M(*F.getParent()), cx(F.getContext()), int32Ty(Type::getInt32Ty(cx)), int64Ty(Type::getInt64Ty(cx)),
+		  floatTy(Type::getFloatTy(cx)), doubleTy(Type::getDoubleTy(cx)),
+		  voidPtrTy(PointerType::get(Type::getInt8Ty(cx), 0)) {
+		slotTy = StructType::get(int32Ty, floatTy, doubleTy, doubleTy, doubleTy, nullptr);
+		slotPtrTy = PointerType::getUnqual(slotTy);
+	}
+
+	void run() {
+		vector<Instruction*> insts;
+		for (BasicBlock& BB : F) {
+			for (Instruction& inst : BB) {
+				insts.push_back(&inst);
+			}
+		}
+
+		// parameters, passed by instrumented callers
+		IRBuilder<> entry(F.getEntryBlock().getFirstInsertionPt());
+		unsigned i = 0;
+		for (Argument& arg : F.getArgumentList()) {
+			if (isShadowed(arg.getType())) {
+				shadows[&arg] = i < SHADOW_ARGS ? take(entry, argSlot(entry, i), &arg) : fresh(entry, &arg);
+			}
+			i++;
+		}
+
+		// phi nodes first, so that loops can refer to them
+		vector<PHINode*> phis;
+		for (Instruction* inst : insts) {
+			PHINode* phi = dyn_cast<PHINode>(inst);
+			if (phi && isShadowed(phi->getType())) {
+				IRBuilder<> b(phi);
+				unsigned n = phi->getNumIncomingValues();
+				shadows[phi] = {b.CreatePHI(int32Ty, n), b.CreatePHI(floatTy, n), b.CreatePHI(doubleTy, n),
+								b.CreatePHI(doubleTy, n)
+							   };
+				phis.push_back(phi);
+			}
+		}
+
+		for (Instruction* inst : insts) {
+			if (isShadowed(inst->getType()) && !isa<InvokeInst>(inst)) {
+				getShadow(inst, inst);
+			}
+
+			if (StoreInst* si = dyn_cast<StoreInst>(inst)) {
+				Value* v = si->getValueOperand();
+				if (isShadowed(v->getType())) {
+					store(si, getShadow(v, si));
+				}
+			} else if (ReturnInst* ri = dyn_cast<ReturnInst>(inst)) {
+				Value* v = ri->getReturnValue();
+				if (v && isShadowed(v->getType())) {
+					IRBuilder<> b(ri);
+					write(b, retSlot(), getShadow(v, ri), toDouble(b, v));
+				}
+			} else if (FCmpInst* fci = dyn_cast<FCmpInst>(inst)) {
+				int op = toCmpOp(fci);
+				if (op != -1 && profiled(fci) && isShadowed(fci->getOperand(0)->getType())) {
+					IRBuilder<> b(fci);
+					Value* l = fci->getOperand(0);
+					Value* r = fci->getOperand(1);
+					blame(b, "llvm_fblame_fcmp", getIID(fci), op, getShadow(l, fci), toDouble(b, l), getShadow(r, fci),
+						  toDouble(b, r));
+				}
+			} else if (CallInst* ci = dyn_cast<CallInst>(inst)) {
+				if (passesShadows(ci)) {
+					IRBuilder<> b(ci);
+					for (unsigned inx = 0; inx < ci->getNumArgOperands() && inx < SHADOW_ARGS; inx++) {
+						Value* arg = ci->getArgOperand(inx);
+						if (isShadowed(arg->getType())) {
+							write(b, argSlot(b, inx), getShadow(arg, ci), toDouble(b, arg));
+						}
+					}
+				}
+			}
+		}
+
+		for (PHINode* phi : phis) {
+			Shadow& s = shadows[phi];
+			for (unsigned i = 0; i < phi->getNumIncomingValues(); i++) {
+				BasicBlock* in = phi->getIncomingBlock(i);
+				Shadow is = getShadow(phi->getIncomingValue(i), in->getTerminator());
+				cast<PHINode>(s.iid)->addIncoming(is.iid, in);
+				cast<PHINode>(s.f)->addIncoming(is.f, in);
+				cast<PHINode>(s.b19)->addIncoming(is.b19, in);
+				cast<PHINode>(s.b27)->addIncoming(is.b27, in);
+			}
+		}
+	}
+
+private:
+	Function* runtime(const char* name, vector<Type*> types, Type* result = nullptr) {
+		FunctionType* type = FunctionType::get(result ? result : Type::getVoidTy(cx), types, false);
+		return cast<Function>(M.getOrInsertFunction(name, type));
+	}
+
+	GlobalVariable* global(const char* name, Type* type, bool threadLocal = false) {
+		if (GlobalVariable* g = M.getGlobalVariable(name)) {
+			return g;
+		}
+		return new GlobalVariable(M, type, false, GlobalValue::ExternalLinkage, nullptr, name, nullptr,
+								  threadLocal ? GlobalVariable::GeneralDynamicTLSModel : GlobalVariable::NotThreadLocal);
+	}
+
+	Value* argSlot(IRBuilder<>& b, unsigned inx) {
+		return b.CreateConstInBoundsGEP2_32(global("llvm_shadow_args", ArrayType::get(slotTy, SHADOW_ARGS), true), 0,
+											inx);
+	}
+
+	Value* retSlot() {
+		return global("llvm_shadow_ret", slotTy, true);
+	}
+
+	Value* toDouble(IRBuilder<>& b, Value* v) {
+		return v->getType()->isDoubleTy() ? v : b.CreateFPExt(v, doubleTy);
+	}
+
+	Value* clearBits(IRBuilder<>& b, Value* v, int bits) {
+		Value* masked = b.CreateAnd(b.CreateBitCast(v, int64Ty),
+									ConstantInt::get(int64Ty, ~0ull << (SHADOW_DOUBLE_MANTISSA - bits)));
+		// NaN payloads are kept as they are
+		return b.CreateSelect(b.CreateFCmpUNO(v, v), v, b.CreateBitCast(masked, doubleTy));
+	}
+
+	// Call the runtime to record the blame of an operation on l and r, of
+	// values lv and rv.
+	CallInst* blame(IRBuilder<>& b, const char* name, Value* iid, int op, const Shadow& l, Value* lv, const Shadow& r,
+					Value* rv) {
+		vector<Type*> types = {int32Ty, int32Ty, int32Ty, floatTy, doubleTy, doubleTy, doubleTy,
+							   int32Ty, floatTy, doubleTy, doubleTy, doubleTy
+							  };
+		vector<Value*> args = {iid, ConstantInt::get(int32Ty, op), l.iid, l.f, l.b19, l.b27, lv,
+							   r.iid, r.f, r.b19, r.b27, rv
+							  };
+		CallInst* ci = b.CreateCall(runtime(name, types), args);
+		guard(ci, cast<Constant>(iid));
+		return ci;
+	}
+
+	// The directory of the shadow memory, asked from the runtime once per
+	// function at its entry. The runtime creates the shadow memory on first
+	// use, so instrumented code run by static constructors finds it too.
+	Value* shadowDirectory() {
+		if (directory == nullptr) {
+			IRBuilder<> b(F.getEntryBlock().getFirstInsertionPt());
+			directory = b.CreateCall(runtime("llvm_shadow_pages", {}, PointerType::getUnqual(slotPtrTy)));
+		}
+		return directory;
+	}
+
+	// The page of the shadow memory holding addr, or null.
+	Value* page(IRBuilder<>& b, Value* addr) {
+		Value* row = b.CreateShl(b.CreateLShr(addr, SHADOW_PAGE_BITS), SHADOW_COLUMN_BITS);
+		return b.CreateLoad(b.CreateGEP(shadowDirectory(), row));
+	}
+
+	Value* slotInPage(IRBuilder<>& b, Value* page, Value* addr) {
+		Value* offset = b.CreateAnd(addr, ConstantInt::get(int64Ty, (1ull << SHADOW_PAGE_BITS) - 1));
+		return b.CreateGEP(page, b.CreateLShr(offset, SHADOW_GRANULE_BITS));
+	}
+
+	// The shadow in slot if it holds one for the value v, else s.
+	Shadow read(IRBuilder<>& b, Value* slot, Value* v, const Shadow& s) {
+		Value* writer = b.CreateLoad(b.CreateStructGEP(slot, SLOT_WRITER));
+		Value* stored = b.CreateICmpNE(writer, ConstantInt::get(int32Ty, 0));
+		Value* same = b.CreateFCmpOEQ(b.CreateLoad(b.CreateStructGEP(slot, SLOT_VALUE)), v);
+		Value* valid = b.CreateAnd(stored, same);
+		return {b.CreateSelect(valid, b.CreateSub(writer, ConstantInt::get(int32Ty, 1)), s.iid),
+				b.CreateSelect(valid, b.CreateLoad(b.CreateStructGEP(slot, SLOT_F)), s.f),
+				b.CreateSelect(valid, b.CreateLoad(b.CreateStructGEP(slot, SLOT_B19)), s.b19),
+				b.CreateSelect(valid, b.CreateLoad(b.CreateStructGEP(slot, SLOT_B27)), s.b27)
+			   };
+	}
+
+	// Read the argument or result slot for v and release it.
+	Shadow take(IRBuilder<>& b, Value* slot, Value* v) {
+		Shadow s = read(b, slot, toDouble(b, v), fresh(b, v));
+		b.CreateStore(ConstantInt::get(int32Ty, 0), b.CreateStructGEP(slot, SLOT_WRITER));
+		return s;
+	}
+
+	void write(IRBuilder<>& b, Value* slot, const Shadow& s, Value* v) {
+		b.CreateStore(b.CreateAdd(s.iid, ConstantInt::get(int32Ty, 1)), b.CreateStructGEP(slot, SLOT_WRITER));
+		b.CreateStore(s.f, b.CreateStructGEP(slot, SLOT_F));
+		b.CreateStore(s.b19, b.CreateStructGEP(slot, SLOT_B19));
+		b.CreateStore(s.b27, b.CreateStructGEP(slot, SLOT_B27));
+		b.CreateStore(v, b.CreateStructGEP(slot, SLOT_VALUE));
+	}
+
+	// Shadow of the value loaded by li; where no page exists yet, the empty
+	// slot llvm_shadow_none is read instead.
+	Shadow load(IRBuilder<>& b, LoadInst* li) {
+		Value* addr = b.CreatePtrToInt(li->getPointerOperand(), int64Ty);
+		Value* p = page(b, addr);
+		Value* slot = b.CreateSelect(b.CreateIsNull(p), global("llvm_shadow_none", slotTy), slotInPage(b, p, addr));
+		return read(b, slot, toDouble(b, li), fresh(b, li));
+	}
+
+	// Write the shadow s of the value stored by si. A missing page is
+	// materialized by the runtime, off the straight-line path:
+	//
+	//   head: page = directory[addr >> PAGE_BITS]; br page == null, slow, tail
+	//   slow: materialized = llvm_shadow_slot(ptr); br tail
+	//   tail: slot = phi(head: page + offset, slow: materialized); write; si
+	void store(StoreInst* si, const Shadow& s) {
+		IRBuilder<> b(si);
+		Value* v = toDouble(b, si->getValueOperand());
+		Value* ptr = si->getPointerOperand();
+		Value* addr = b.CreatePtrToInt(ptr, int64Ty);
+		Value* p = page(b, addr);
+		Value* slot = slotInPage(b, p, addr);
+		Value* missing = b.CreateIsNull(p);
+
+		BasicBlock* head = si->getParent();
+		BasicBlock* tail = head->splitBasicBlock(si);
+		BasicBlock* slow = BasicBlock::Create(cx, "", &F, tail);
+		TerminatorInst* term = head->getTerminator();
+		BranchInst::Create(slow, tail, missing, term);
+		term->eraseFromParent();
+
+		IRBuilder<> sb(slow);
+		Value* materialized = sb.CreateCall(runtime("llvm_shadow_slot", {voidPtrTy}, slotPtrTy),
+											sb.CreatePointerCast(ptr, voidPtrTy));
+		sb.CreateBr(tail);
+
+		IRBuilder<> tb(si);
+		PHINode* merged = tb.CreatePHI(slotPtrTy, 2);
+		merged->addIncoming(slot, head);
+		merged->addIncoming(materialized, slow);
+		write(tb, merged, s, v);
+	}
+
+	// Shadow of a value without shadow computation: the value itself, rounded
+	// to each precision.
+	Shadow fresh(IRBuilder<>& b, Value* v) {
+		Value* d = toDouble(b, v);
+		Value* f = v->getType()->isFloatTy() ? v : b.CreateFPTrunc(v, floatTy);
+		return {getIID(v), f, clearBits(b, d, SHADOW_BITS_19), clearBits(b, d, SHADOW_BITS_27)};
+	}
+
+	Shadow constant(ConstantFP* c) {
+		double d = c->getType()->isFloatTy() ? c->getValueAPF().convertToFloat() : c->getValueAPF().convertToDouble();
+		return {getIID(c), ConstantFP::get(floatTy, (float)d),
+				ConstantFP::get(doubleTy, clearBitsConstant(d, SHADOW_DOUBLE_MANTISSA - SHADOW_BITS_19)),
+				ConstantFP::get(doubleTy, clearBitsConstant(d, SHADOW_DOUBLE_MANTISSA - SHADOW_BITS_27))
+			   };
+	}
+
+	// Shadow of v for a use at instruction use.
+	Shadow getShadow(Value* v, Instruction* use) {
+		auto it = shadows.find(v);
+		if (it != shadows.end()) {
+			return it->second;
+		}
+
+		if (ConstantFP* c = dyn_cast<ConstantFP>(v)) {
+			return shadows[v] = constant(c);
+		}
+
+		Instruction* inst = dyn_cast<Instruction>(v);
+		if (inst == nullptr || isa<InvokeInst>(inst)) {
+			// computed at the use
+			IRBuilder<> b(use);
+			return fresh(b, v);
+		}
+
+		// right after the definition
+		BasicBlock::iterator next = inst;
+		++next;
+		IRBuilder<> b(next);
+		return shadows[v] = define(b, inst);
+	}
+
+	// The math function of ci applied to the shadow of its argument, in float
+	// and in double rounded to each precision, as shadowFEval of the runtime.
+	Shadow mathCall(IRBuilder<>& b, CallInst* ci, int func) {
+		Value* arg = ci->getArgOperand(0);
+		Shadow a = getShadow(arg, ci);
+		string name = ci->getCalledFunction()->getName();
+		Constant* fn = M.getOrInsertFunction(name, doubleTy, doubleTy, nullptr);
+		Constant* fnf = M.getOrInsertFunction(name + "f", floatTy, floatTy, nullptr);
+
+		Shadow s = {getIID(ci), b.CreateCall(fnf, a.f), clearBits(b, b.CreateCall(fn, a.b19), SHADOW_BITS_19),
+					clearBits(b, b.CreateCall(fn, a.b27), SHADOW_BITS_27)
+				   };
+
+		IRBuilder<> before(ci);
+		vector<Type*> types = {int32Ty, int32Ty, int32Ty, floatTy, doubleTy, doubleTy, doubleTy};
+		vector<Value*> args = {s.iid, ConstantInt::get(int32Ty, func), a.iid, a.f, a.b19, a.b27, toDouble(before, arg)};
+		guard(b.CreateCall(runtime("llvm_fblame_call", types), args), cast<Constant>(s.iid));
+		return s;
+	}
+
+	Shadow define(IRBuilder<>& b, Instruction* inst) {
+		if (BinaryOperator* bi = dyn_cast<BinaryOperator>(inst)) {
+			int op = toBinOp(bi);
+			if (op != -1 && profiled(bi)) {
+				Shadow l = getShadow(bi->getOperand(0), bi);
+				Shadow r = getShadow(bi->getOperand(1), bi);
+				Instruction::BinaryOps opcode = bi->getOpcode();
+
+				Shadow s = {getIID(bi), b.CreateBinOp(opcode, l.f, r.f),
+							clearBits(b, b.CreateBinOp(opcode, l.b19, r.b19), SHADOW_BITS_19),
+							clearBits(b, b.CreateBinOp(opcode, l.b27, r.b27), SHADOW_BITS_27)
+						   };
+
+				IRBuilder<> before(bi);
+				blame(b, "llvm_fblame", s.iid, op, l, toDouble(before, bi->getOperand(0)), r,
+					  toDouble(before, bi->getOperand(1)));
+				return s;
+			}
+		} else if (LoadInst* li = dyn_cast<LoadInst>(inst)) {
+			return load(b, li);
+		} else if (CallInst* ci = dyn_cast<CallInst>(inst)) {
+			int func = toMathFunc(ci);
+			if (func != -1 && profiled(ci)) {
+				return mathCall(b, ci, func);
+			} else if (passesShadows(ci)) {
+				return take(b, retSlot(), ci);
+			}
+		} else if (isa<FPExtInst>(inst) || isa<FPTruncInst>(inst)) {
+			// a conversion between float and double carries the shadow of its
+			// operand
+			Value* op = inst->getOperand(0);
+			if (isShadowed(op->getType())) {
+				return getShadow(op, inst);
+			}
+		} else if (SelectInst* si = dyn_cast<SelectInst>(inst)) {
+			Shadow t = getShadow(si->getTrueValue(), si);
+			Shadow f = getShadow(si->getFalseValue(), si);
+			Value* c = si->getCondition();
+			return {b.CreateSelect(c, t.iid, f.iid), b.CreateSelect(c, t.f, f.f), b.CreateSelect(c, t.b19, f.b19),
+					b.CreateSelect(c, t.b27, f.b27)
+				   };
+		}
+
+		return fresh(b, inst);
+	}
+};
+
+// ***** Profiles ***** //
+//
+// A profile is only meaningful if every run of the pass gives the same IIDs
+// to the same instructions, whatever the mode. So every instruction the pass
+// may instrument is numbered up front, in module order. The IIDs of other
+// values (constants, arguments) are assigned lazily as usual.
+
+template <typename T> bool usefulAs(Instruction* inst) {
+	T* value = dyn_cast<T>(inst);
+	return value && useful(value);
+}
+
+bool usefulInst(Instruction* inst) {
+	return usefulAs<BinaryOperator>(inst) || usefulAs<FCmpInst>(inst) || usefulAs<CallInst>(inst) ||
+		   usefulAs<LoadInst>(inst) || usefulAs<StoreInst>(inst) || usefulAs<PHINode>(inst) ||
+		   usefulAs<ReturnInst>(inst);
+}
+
+void numberInstructions(Module& M) {
+	for (Function& F : M) {
+		for (BasicBlock& BB : F) {
+			for (Instruction& inst : BB) {
+				if (usefulInst(&inst)) {
+					getIID(&inst);
+				}
+			}
+		}
+	}
+}
+
+// Emit the block counters fppass_ic_counts and the table fppass_ic_iids of
+// (block, IID) pairs read by the instruction counter of the runtime.
+unordered_map<BasicBlock*, unsigned> countedBlocks;
+GlobalVariable* blockCounts = nullptr;
+
+void insertCounterTables(Module& M) {
+	LLVMContext& cx = M.getContext();
+	Type* int32Ty = Type::getInt32Ty(cx);
+	Type* int64Ty = Type::getInt64Ty(cx);
+
+	vector<Constant*> pairs;
+	for (Function& F : M) {
+		for (BasicBlock& BB : F) {
+			bool counted = false;
+			for (Instruction& inst : BB) {
+				if (!usefulInst(&inst)) {
+					continue;
+				}
+				if (!counted) {
+					unsigned id = countedBlocks.size();
+					countedBlocks[&BB] = id;
+					counted = true;
+				}
+				pairs.push_back(ConstantInt::get(int32Ty, countedBlocks[&BB]));
+				pairs.push_back(getIID(&inst));
+			}
+		}
+	}
+
+	ArrayType* countsType = ArrayType::get(int64Ty, countedBlocks.size());
+	blockCounts = new GlobalVariable(M, countsType, false, GlobalValue::ExternalLinkage,
+									 ConstantAggregateZero::get(countsType), "fppass_ic_counts");
+	ArrayType* iidsType = ArrayType::get(int32Ty, pairs.size());
+	new GlobalVariable(M, iidsType, true, GlobalValue::ExternalLinkage, ConstantArray::get(iidsType, pairs),
+					   "fppass_ic_iids");
+	new GlobalVariable(M, int32Ty, true, GlobalValue::ExternalLinkage, ConstantInt::get(int32Ty, pairs.size() / 2),
+					   "fppass_ic_size");
+}
+
+void countBlock(BasicBlock& BB) {
+	auto it = countedBlocks.find(&BB);
+	if (it == countedBlocks.end()) {
+		return;
+	}
+	IRBuilder<> b(BB.getFirstInsertionPt());
+	Value* counter = b.CreateConstInBoundsGEP2_32(blockCounts, 0, it->second);
+	b.CreateStore(b.CreateAdd(b.CreateLoad(counter), b.getInt64(1)), counter);
+}
+
+// Instructions selected by -profile: the ProfileTop most executed ones and
+// the instructions their operands come from.
+unordered_set<Instruction*> hot;
+
+void readProfile(Module& M) {
+	unordered_map<int64_t, Instruction*> byIID;
+	for (Function& F : M) {
+		for (BasicBlock& BB : F) {
+			for (Instruction& inst : BB) {
+				if (usefulInst(&inst)) {
+					byIID[cast<ConstantInt>(getIID(&inst))->getSExtValue()] = &inst;
+				}
+			}
+		}
+	}
+
+	ifstream fin(ProfileFilename.c_str());
+	if (!fin.is_open()) {
+		cerr << "Cannot open profile " << ProfileFilename << "; instrumenting everything" << endl;
+		for (auto& entry : byIID) {
+			hot.insert(entry.second);
+		}
+		return;
+	}
+	vector<pair<uint64_t, int64_t>> counts;
+	int64_t iid;
+	uint64_t count;
+	while (fin >> iid >> count) {
+		if (count > 0 && byIID.count(iid)) {
+			counts.push_back(make_pair(count, iid));
+		}
+	}
+	sort(counts.begin(), counts.end(), greater<pair<uint64_t, int64_t>>());
+	if (counts.size() > ProfileTop) {
+		counts.resize(ProfileTop);
+	}
+
+	vector<Instruction*> worklist;
+	for (auto& entry : counts) {
+		worklist.push_back(byIID[entry.second]);
+	}
+	while (!worklist.empty()) {
+		Instruction* inst = worklist.back();
+		worklist.pop_back();
+		if (!hot.insert(inst).second) {
+			continue;
+		}
+		for (User::op_iterator op = inst->op_begin(); op != inst->op_end(); ++op) {
+			Instruction* def = dyn_cast<Instruction>(*op);
+			if (def && usefulInst(def)) {
+				worklist.push_back(def);
+			}
+		}
+	}
+}
+
+// Calls and returns keep the shadow call stack of the runtime balanced and
+// pass the bindings of arguments and results, so they are instrumented
+// whether they are hot or not. Math calls are operations of the analysis
+// and follow the profile.
+bool callProtocol(Instruction* inst) {
+	CallInst* ci = dyn_cast<CallInst>(inst);
+	return isa<ReturnInst>(inst) || (ci && !usefulMathCall(ci));
+}
+
+bool profiled(Instruction* inst) {
+	return ProfileFilename.empty() || hot.count(inst) || callProtocol(inst);
+}
+
 vector<function<void()>> todo;
 
 template <typename T> bool handle(Instruction* inst) {
@@ -462,7 +1202,7 @@ template <typename T> bool handle(Instruction* inst) {
 		return false;
 	}
 
-	if (useful(value)) {
+	if (useful(value) && profiled(value)) {
 		todo.push_back([value]() {
 			// these really should be in one function, but C++ makes multiple return
 			// values painful
@@ -484,45 +1224,66 @@ cl::opt<string> ExcludeFilename("exclude", cl::desc("Specify include file name")
 
 namespace {
 
-struct FPPass : public BasicBlockPass {
+struct FPPass : public FunctionPass {
 	static char ID;
-	bool instrument;
 
-	FPPass() : BasicBlockPass(ID) {}
-	using Pass::doInitialization;
-	using Pass::doFinalization;
-	bool doInitialization(Function& F) {
-		string name = F.getName();
+	// Functions named in the -exclude file.
+	set<string> excluded;
+
+	FPPass() : FunctionPass(ID) {}
+
+	bool doInitialization(Module& M) {
 		ifstream infile(ExcludeFilename.c_str());
-		if (infile.is_open()) {
-			string line;
-			while (getline(infile, line)) {
-				if (line.compare(name) == 0) {
-					instrument = false;
-					cout << "Exclude: " << name << endl;
-					return true;
-				}
-			}
-			instrument = true;
-		} else {
-			instrument = true;
+		string line;
+		while (getline(infile, line)) {
+			excluded.insert(line);
 		}
-		return true;
+
+		numberInstructions(M);
+		if (CountIC) {
+			insertCounterTables(M);
+			return true;
+		}
+		if (!ProfileFilename.empty()) {
+			readProfile(M);
+		}
+		return false;
 	}
 
-	bool doFinalization(Function&) {
+	bool doFinalization(Module& M) {
+		insertIIDCount(M);
+		if (IIDMask) {
+			insertIIDMask(M);
+		}
 		return true;
 	}
 
-	bool runOnBasicBlock(BasicBlock& BB) {
-		if (!instrument) {
+	bool runOnFunction(Function& F) {
+		if (excluded.count(F.getName())) {
+			cout << "Exclude: " << F.getName().str() << endl;
+			return false;
+		}
+		if (CountIC) {
+			bool counted = false;
+			for (BasicBlock& BB : F) {
+				countBlock(BB);
+				counted = counted || countedBlocks.count(&BB) != 0;
+			}
+			return counted;
+		}
+		if (InlineShadow) {
+			// the shadows flow across blocks
+			ShadowBuilder(F).run();
 			return true;
 		}
 		bool ret = false;
-		for (Instruction& inst : BB) {
-			if (handle<BinaryOperator>(&inst) || handle<FCmpInst>(&inst) || handle<CallInst>(&inst) ||
-					handle<LoadInst>(&inst) || handle<StoreInst>(&inst) || handle<PHINode>(&inst) || handle<ReturnInst>(&inst)) {
-				ret = true;
+		for (BasicBlock& BB : F) {
+			for (Instruction& inst : BB) {
+				if (handle<BinaryOperator>(&inst) || handle<FCmpInst>(&inst) || handle<CallInst>(&inst) ||
+						handle<LoadInst>(&inst) || handle<StoreInst>(&inst) || handle<PHINode>(&inst) ||
+						handle<ReturnInst>(&inst)) {
+					ret = true;
+				}
 			}
 		}
 		if (ret) {
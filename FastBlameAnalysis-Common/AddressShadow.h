@@ -0,0 +1,124 @@
+#ifndef _ADDRESS_SHADOW_H_
+#define _ADDRESS_SHADOW_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sys/mman.h>
+
+// The directory shared by all address shadows of the process: one row per
+// page of the user address space, and in it one entry per shadow (its
+// column), so the shadows of an address share a line of the directory. It
+// is reserved once, with mmap(MAP_NORESERVE), on first use.
+class ShadowDirectory {
+public:
+	static const unsigned ADDRESS_BITS = 48;
+	static const unsigned PAGE_BITS = 22;
+	static const unsigned COLUMN_BITS = 2;
+	static const unsigned COLUMNS = 1 << COLUMN_BITS;
+
+	// Report a failure of the shadow memory and abort; the analysis cannot go
+	// on without it, in any build.
+	static void fail(const char* message, const void* ptr) {
+		fprintf(stderr, "Address shadow: %s (%p).\n", message, ptr);
+		abort();
+	}
+
+	static void* reserve(size_t size) {
+		void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (mem == MAP_FAILED) {
+			fail("cannot reserve the shadow memory", NULL);
+		}
+		return mem;
+	}
+
+	// The directory entries of a new shadow: entry (addr >> PAGE_BITS) <<
+	// COLUMN_BITS of the result.
+	static void** column() {
+		static void** const directory =
+			static_cast<void**>(reserve(sizeof(void*) << (ADDRESS_BITS - PAGE_BITS + COLUMN_BITS)));
+		static std::atomic<unsigned> columns(0);
+
+		unsigned c = columns.fetch_add(1);
+		if (c >= COLUMNS) {
+			fail("too many address shadows", NULL);
+		}
+		return directory + c;
+	}
+};
+
+// Shadow of the application memory, indexed directly by address: a column of
+// the ShadowDirectory and pages of slots, one slot per 4-byte granule. Pages
+// are reserved with mmap(MAP_NORESERVE), so only the parts that are touched
+// are backed by memory, and every slot starts out zeroed. A lookup is two
+// loads instead of a hash lookup, and a sweep over an array walks its slots
+// linearly.
+//
+// T must be trivially copyable and valid when all its bytes are zero.
+template <typename T> class AddressShadow {
+private:
+	static const unsigned PAGE_BITS = ShadowDirectory::PAGE_BITS;
+	static const unsigned COLUMN_BITS = ShadowDirectory::COLUMN_BITS;
+	static const unsigned GRANULE_BITS = 2;
+	static const uint64_t PAGE_MASK = (1ULL << PAGE_BITS) - 1;
+
+	std::atomic<T*>* directory;
+	std::mutex lock;  // protects page allocation
+
+	static_assert(sizeof(std::atomic<T*>) == sizeof(void*), "Directory entries are not plain pointers.");
+
+	static uint64_t address(const void* ptr) {
+		uint64_t addr = (uint64_t)ptr;
+		if (addr >> ShadowDirectory::ADDRESS_BITS != 0) {
+			ShadowDirectory::fail("address outside of the shadowed address space", ptr);
+		}
+		return addr;
+	}
+
+	std::atomic<T*>& entry(uint64_t addr) const {
+		return directory[(addr >> PAGE_BITS) << COLUMN_BITS];
+	}
+
+public:
+	AddressShadow() {
+		directory = reinterpret_cast<std::atomic<T*>*>(ShadowDirectory::column());
+	}
+
+	AddressShadow(const AddressShadow&) = delete;
+	AddressShadow& operator=(const AddressShadow&) = delete;
+
+	// The column of the directory: entry (addr >> PAGE_BITS) << COLUMN_BITS
+	// points to the page of addr, or is null, and the slot of addr is at
+	// (addr & PAGE_MASK) >> GRANULE_BITS in it. For code that looks slots up
+	// inline (FPPass -inline-shadow).
+	T* const* pages() const {
+		return reinterpret_cast<T* const*>(directory);
+	}
+
+	// The slot of ptr, or nullptr if nothing near ptr was ever written.
+	const T* find(const void* ptr) const {
+		uint64_t addr = address(ptr);
+		T* page = entry(addr).load(std::memory_order_acquire);
+		return page ? &page[(addr & PAGE_MASK) >> GRANULE_BITS] : nullptr;
+	}
+
+	// The slot of ptr, materializing its page.
+	T& operator[](const void* ptr) {
+		uint64_t addr = address(ptr);
+		std::atomic<T*>& e = entry(addr);
+		T* page = e.load(std::memory_order_acquire);
+		if (page == nullptr) {
+			std::lock_guard<std::mutex> guard(lock);
+			page = e.load(std::memory_order_relaxed);
+			if (page == nullptr) {
+				page = static_cast<T*>(ShadowDirectory::reserve(sizeof(T) << (PAGE_BITS - GRANULE_BITS)));
+				e.store(page, std::memory_order_release);
+			}
+		}
+		return page[(addr & PAGE_MASK) >> GRANULE_BITS];
+	}
+};
+
+#endif
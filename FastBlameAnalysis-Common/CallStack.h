@@ -0,0 +1,86 @@
+#ifndef _CALL_STACK_H_
+#define _CALL_STACK_H_
+
+#include <cassert>
+#include <vector>
+
+#include "DebugInfo.h"
+
+// IID bound to an argument slot or to the return value of a call.
+struct Binding {
+	IID iid;
+	bool bound;
+};
+
+// One call in progress: the function called, the IIDs the caller passed in
+// the floating-point argument slots, and the IID the callee returned.
+struct CallFrame {
+	const void* callee;
+	std::vector<Binding> args;
+	Binding ret;
+};
+
+// Shadow of the call stack of the instrumented program. FPPass brackets
+// every call with floating-point arguments or result by llvm_push_frame and
+// llvm_pop_frame, so nested and recursive calls each get their own argument
+// and return bindings. The bottom frame is always there and collects the
+// argument bindings of code that was instrumented without the brackets.
+// Frames are reused once popped, so calls do not allocate after warm-up.
+//
+// A return is only bound to the top frame if that frame was pushed by a
+// call to the returning function. Functions entered from code without the
+// brackets (main, callbacks of uninstrumented libraries) would otherwise
+// overwrite the return of a call further up that is still in progress.
+class CallStack {
+private:
+	std::vector<CallFrame> frames;
+	size_t depth;
+
+public:
+	CallStack() : frames(1), depth(0) {
+		frames[0].callee = nullptr;
+		frames[0].ret = {0, false};
+	}
+
+	void push(const void* callee) {
+		if (++depth == frames.size()) {
+			frames.emplace_back();
+		}
+		frames[depth].callee = callee;
+		frames[depth].args.clear();
+		frames[depth].ret = {0, false};
+	}
+
+	void pop() {
+		assert(depth > 0 && "Unbalanced call frames.");
+		depth--;
+	}
+
+	CallFrame& top() {
+		return frames[depth];
+	}
+
+	void bindArg(unsigned argInx, IID iid) {
+		std::vector<Binding>& args = frames[depth].args;
+		if (argInx >= args.size()) {
+			args.resize(argInx + 1, {0, false});
+		}
+		args[argInx] = {iid, true};
+	}
+
+	// Bind the value returned by function, if the top frame is a call to it.
+	void bindReturn(const void* function, IID iid) {
+		CallFrame& frame = frames[depth];
+		if (depth > 0 && frame.callee == function) {
+			frame.ret = {iid, true};
+		}
+	}
+
+	// The binding of argument slot argInx of the top frame, or nullptr.
+	const Binding* arg(unsigned argInx) const {
+		const std::vector<Binding>& args = frames[depth].args;
+		return argInx < args.size() && args[argInx].bound ? &args[argInx] : nullptr;
+	}
+};
+
+#endif
@@ -0,0 +1,17 @@
+#include <cstdlib>
+
+#include "DebugInfo.h"
+
+std::istream& operator>>(std::istream& input, DebugInfo& dbg) {
+	std::string _;
+	input >> _ >> dbg.file >> _ >> dbg.line >> _ >> dbg.column;
+	return input;
+}
+
+std::string debugFile(const std::string& name) {
+	const char* dir = getenv("BA_DEBUG_DIR");
+	if (dir == NULL || *dir == '\0') {
+		return name;
+	}
+	return std::string(dir) + "/" + name;
+}
@@ -0,0 +1,26 @@
+#ifndef _DEBUG_INFO_H_
+#define _DEBUG_INFO_H_
+
+#include <cstdint>
+#include <istream>
+#include <string>
+
+// Declarations shared by the blame analysis runtimes (libba2, libba3 and
+// libba-noshadow).
+
+typedef int32_t IID;
+
+struct DebugInfo {
+	std::string file;
+	unsigned line, column;
+	DebugInfo() : file("n/a"), line(0), column(0) {}
+};
+
+std::istream& operator>>(std::istream& input, DebugInfo& dbg);
+
+// Path of a file written by FPPass at instrumentation time (debug.bin,
+// functions.bin). The files are looked up in $BA_DEBUG_DIR when it is set, in
+// the current directory otherwise.
+std::string debugFile(const std::string& name);
+
+#endif
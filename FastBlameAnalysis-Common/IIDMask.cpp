@@ -0,0 +1,96 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <set>
+#include <unistd.h>
+
+#include "IIDMask.h"
+
+using namespace std;
+
+string IIDMask::readSelection() {
+	if (const char* env = getenv("BA_IID_MASK")) {
+		return env;
+	}
+
+	char buff[1024];
+	ssize_t len = ::readlink("/proc/self/exe", buff, sizeof(buff) - 1);
+	if (len == -1) {
+		return "";
+	}
+	buff[len] = '\0';
+
+	ifstream fin(string(buff) + ".mask");
+	ostringstream selection;
+	selection << fin.rdbuf();
+	return selection.str();
+}
+
+IIDMask::IIDMask() {
+	uint8_t* mask = fppass_iid_mask;
+	if (mask == nullptr) {
+		return;
+	}
+
+	string selection = readSelection();
+	for (char& c : selection) {
+		if (c == ',') {
+			c = ' ';
+		}
+	}
+
+	set<IID> iids;
+	set<string> functions, files;
+	istringstream entries(selection);
+	string entry;
+	while (entries >> entry) {
+		size_t colon = entry.find(':');
+		string kind = entry.substr(0, colon);
+		string name = colon == string::npos ? "" : entry.substr(colon + 1);
+		if (kind == "iid") {
+			iids.insert(atoi(name.c_str()));
+		} else if (kind == "function") {
+			functions.insert(name);
+		} else if (kind == "file") {
+			files.insert(name);
+		} else {
+			cerr << "[IIDMask] Ignoring unknown entry " << entry << endl;
+		}
+	}
+	if (iids.empty() && functions.empty() && files.empty()) {
+		return;
+	}
+
+	if (!functions.empty()) {
+		ifstream fin(debugFile("functions.bin"));
+		string _, function;
+		IID iid;
+		while (fin >> _ >> iid >> _ >> function) {
+			if (functions.count(function)) {
+				iids.insert(iid);
+			}
+		}
+	}
+	if (!files.empty()) {
+		ifstream fin(debugFile("debug.bin"));
+		string _;
+		IID iid;
+		DebugInfo dbg;
+		while (fin >> _ >> iid >> dbg) {
+			if (files.count(dbg.file)) {
+				iids.insert(iid);
+			}
+		}
+	}
+
+	memset(mask, 0, (fppass_iid_count + 7) / 8);
+	for (IID iid : iids) {
+		if (iid >= 0 && (uint32_t)iid < fppass_iid_count) {
+			mask[iid / 8] |= 1 << iid % 8;
+		}
+	}
+}
+
+static IIDMask iidMask;
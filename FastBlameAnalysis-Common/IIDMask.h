@@ -0,0 +1,43 @@
+#ifndef _IID_MASK_H_
+#define _IID_MASK_H_
+
+#include <cstdint>
+#include <string>
+
+#include "DebugInfo.h"
+
+// Enable bitmap emitted by FPPass when run with -iid-mask. Every guarded
+// callback in the instrumented program (fbinop, fcmp, math calls and fblame)
+// first tests the bit of its IID, so a cleared bit removes the whole call, not
+// just the analysis work behind it. Loads, stores, phis and call results are
+// never guarded, they keep the IID translation tables of the runtime current.
+// Both symbols are weak so that the runtime also links with programs
+// instrumented without the mask.
+extern "C" {
+	extern uint8_t fppass_iid_mask[] __attribute__((weak));
+	extern const uint32_t fppass_iid_count __attribute__((weak));
+}
+
+// Restrict instrumentation to a subset of the program at startup.
+//
+// The selection is read from BA_IID_MASK in the environment, or else from
+// the file <program>.mask. It is a list of entries separated by commas or
+// white space:
+//
+//   iid:N          the instruction with IID N
+//   function:NAME  every instruction in function NAME (from functions.bin)
+//   file:NAME      every instruction from source file NAME (from debug.bin)
+//
+// functions.bin and debug.bin are found as described at debugFile.
+//
+// Without a selection, or when the program has no mask, all call sites stay
+// enabled.
+class IIDMask {
+private:
+	static std::string readSelection();
+
+public:
+	IIDMask();
+};
+
+#endif
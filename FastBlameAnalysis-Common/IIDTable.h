@@ -0,0 +1,73 @@
+#ifndef _IID_TABLE_H_
+#define _IID_TABLE_H_
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "DebugInfo.h"
+
+// Number of IIDs handed out by FPPass. Weak so that the runtime also links
+// with programs instrumented by an older pass.
+extern "C" {
+	extern const uint32_t fppass_iid_count __attribute__((weak));
+}
+
+// A table indexed by IID. FPPass hands out dense IIDs starting at 0, so the
+// entries live in a flat array with one presence bit each, preallocated to
+// fppass_iid_count. Lookups are a single indexed load instead of a hash
+// lookup; IIDs beyond the preallocated range grow the table. Shared by the
+// blame analysis runtimes.
+template <typename T> class IIDTable {
+private:
+	std::vector<T> entries;
+	std::vector<bool> present;
+
+	void grow(IID iid) {
+		size_t size = entries.size() * 2 > (size_t)iid ? entries.size() * 2 : (size_t)iid + 1;
+		entries.resize(size);
+		present.resize(size, false);
+	}
+
+public:
+	IIDTable() {
+		size_t size = &fppass_iid_count != nullptr ? fppass_iid_count : 0;
+		entries.resize(size);
+		present.resize(size, false);
+	}
+
+	// One past the largest IID the table has room for.
+	IID size() const {
+		return (IID)entries.size();
+	}
+
+	bool contains(IID iid) const {
+		return iid >= 0 && (size_t)iid < present.size() && present[iid];
+	}
+
+	// The entry of iid, or nullptr if there is none.
+	T* find(IID iid) {
+		return contains(iid) ? &entries[iid] : nullptr;
+	}
+
+	// The entry of iid; value initialized if there was none.
+	T& operator[](IID iid) {
+		assert(iid >= 0 && "IIDs are not negative.");
+		if ((size_t)iid >= entries.size()) {
+			grow(iid);
+		}
+		if (!present[iid]) {
+			present[iid] = true;
+			entries[iid] = T();
+		}
+		return entries[iid];
+	}
+
+	void erase(IID iid) {
+		if (contains(iid)) {
+			present[iid] = false;
+		}
+	}
+};
+
+#endif
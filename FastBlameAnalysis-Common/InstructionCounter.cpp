@@ -0,0 +1,29 @@
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "InstructionCounter.h"
+
+using namespace std;
+
+InstructionCounter::~InstructionCounter() {
+	if (fppass_ic_counts == nullptr) {
+		return;
+	}
+
+	char buff[1024];
+	ssize_t len = ::readlink("/proc/self/exe", buff, sizeof(buff) - 1);
+	if (len == -1) {
+		return;
+	}
+	buff[len] = '\0';
+
+	ofstream fout(string(buff) + ".ic");
+	for (int32_t i = 0; i < fppass_ic_size; i++) {
+		int32_t block = fppass_ic_iids[2 * i];
+		int32_t iid = fppass_ic_iids[2 * i + 1];
+		fout << iid << " " << fppass_ic_counts[block] << '\n';
+	}
+}
+
+static InstructionCounter instructionCounter;
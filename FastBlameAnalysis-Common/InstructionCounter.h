@@ -0,0 +1,26 @@
+#ifndef _INSTRUCTION_COUNTER_H_
+#define _INSTRUCTION_COUNTER_H_
+
+#include <cstdint>
+
+// Block counters emitted by FPPass when run with -count-ic. Every basic
+// block with floating-point instructions increments its counter on entry;
+// fppass_ic_iids holds fppass_ic_size pairs (block, IID) that attribute the
+// block count to each of its instructions. The symbols are weak so that the
+// runtime also links with fully instrumented programs.
+extern "C" {
+	extern uint64_t fppass_ic_counts[] __attribute__((weak));
+	extern const int32_t fppass_ic_iids[] __attribute__((weak));
+	extern const int32_t fppass_ic_size __attribute__((weak));
+}
+
+// Write the per-IID counts to <program>.ic at exit, one "iid count" line per
+// instruction, for FPPass -profile and the startTrack cutoff of the
+// runtimes. Linked into every blame analysis runtime, so that any of them can
+// run a -count-ic program.
+class InstructionCounter {
+public:
+	~InstructionCounter();
+};
+
+#endif
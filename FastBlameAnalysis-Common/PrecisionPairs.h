@@ -0,0 +1,165 @@
+#ifndef _PRECISION_PAIRS_H_
+#define _PRECISION_PAIRS_H_
+
+#include <cstdint>
+#include <cstring>
+
+#include "BlameUtilities.h"
+
+// Batched searches over pairs of operand precisions, shared by the blame
+// analysis runtimes and built against the precision ladder of the runtime
+// that includes it (its BlameUtilities.h). Bit i * PRECISION_NO + j of a
+// PairMask stands for the pair (i, j), so the first pair in (i, j) order that
+// passes is the lowest bit set. The operator and the special cases are
+// switched on once per batch, which leaves straight-line lane loops the
+// compiler vectorizes.
+typedef uint64_t PairMask;
+
+static_assert(PRECISION_NO * PRECISION_NO <= 64, "The precision pairs do not fit in a PairMask.");
+
+// The pairs (i, j) with i >= min_i and j >= min_j.
+inline PairMask precisionPairs(PRECISION min_i, PRECISION min_j) {
+	PairMask row = ((PairMask(1) << PRECISION_NO) - 1) & ~((PairMask(1) << min_j) - 1);
+	PairMask pairs = 0;
+	for (PRECISION i = min_i; i < PRECISION_NO; i = PRECISION(i + 1)) {
+		pairs |= row << (i * PRECISION_NO);
+	}
+	return pairs;
+}
+
+// The pair (i, j) of the lowest bit set in mask. The mask is empty when the
+// search starts above every pair that reproduces the result, because an
+// earlier execution needed higher precisions. The operands are then blamed
+// at double precision, the most conservative blame, and false is returned.
+inline bool firstPair(PairMask mask, PRECISION& i, PRECISION& j) {
+	if (mask == 0) {
+		i = j = PRECISION(PRECISION_NO - 1);
+		return false;
+	}
+	unsigned k = __builtin_ctzll(mask);
+	i = PRECISION(k / PRECISION_NO);
+	j = PRECISION(k % PRECISION_NO);
+	return true;
+}
+
+template <typename F> inline void evalPairs(const HIGHPRECISION* l, const HIGHPRECISION* r, HIGHPRECISION* out, F f) {
+	for (unsigned i = 0; i < PRECISION_NO; i++) {
+		for (unsigned j = 0; j < PRECISION_NO; j++) {
+			out[i * PRECISION_NO + j] = f(l[i], r[j]);
+		}
+	}
+}
+
+// candidates[i * PRECISION_NO + j] = l[i] op r[j], rounded to precision p.
+inline void pairCandidates(const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op, PRECISION p,
+						   HIGHPRECISION* candidates) {
+	switch (op) {
+		case FADD:
+			evalPairs(l, r, candidates, [](HIGHPRECISION a, HIGHPRECISION b) {
+				return a + b;
+			});
+			break;
+		case FSUB:
+			evalPairs(l, r, candidates, [](HIGHPRECISION a, HIGHPRECISION b) {
+				return a - b;
+			});
+			break;
+		case FMUL:
+			evalPairs(l, r, candidates, [](HIGHPRECISION a, HIGHPRECISION b) {
+				return a * b;
+			});
+			break;
+		case FDIV:
+			evalPairs(l, r, candidates, [](HIGHPRECISION a, HIGHPRECISION b) {
+				return a / b;
+			});
+			break;
+		default:
+			assert(false && "Unsuppored floating-point binary operator.");
+	}
+	for (unsigned k = 0; k < PRECISION_NO * PRECISION_NO; k++) {
+		candidates[k] = clearBits(candidates[k], DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]);
+	}
+}
+
+// The mantissa of v as compared by equalWithinPrecision: the top mantissa
+// bits, sign-extended from the highest one, without the drop lowest ones.
+inline int64_t comparedMantissa(HIGHPRECISION v, unsigned drop) {
+	uint64_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	return (int64_t)(bits << (DOUBLE_EXPONENT_LENGTH + 1)) >> (DOUBLE_EXPONENT_LENGTH + 1 + drop);
+}
+
+// Bit k is set when equalWithinPrecision(result, candidates[k], p), for the
+// n candidates.
+inline PairMask equalMask(HIGHPRECISION result, const HIGHPRECISION* candidates, unsigned n, PRECISION p) {
+	PairMask mask = 0;
+	if (std::isnan(result)) {
+		for (unsigned k = 0; k < n; k++) {
+			mask |= PairMask(candidates[k] != candidates[k]) << k;
+		}
+	} else if (std::isinf(result)) {
+		for (unsigned k = 0; k < n; k++) {
+			mask |= PairMask(std::fabs(candidates[k]) == HUGE_VAL) << k;
+		}
+	} else if (p == BITS_DOUBLE) {
+		for (unsigned k = 0; k < n; k++) {
+			mask |= PairMask(candidates[k] == result) << k;
+		}
+	} else {
+		unsigned drop = DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p] - 1;
+		int64_t r = comparedMantissa(result, drop);
+		for (unsigned k = 0; k < n; k++) {
+			// the mantissas differ by at most one
+			uint64_t d = comparedMantissa(candidates[k], drop) - r + 1;
+			mask |= PairMask(d <= 2) << k;
+		}
+	}
+	return mask;
+}
+
+template <typename F> inline PairMask comparePairs(const HIGHPRECISION* l, const HIGHPRECISION* r, bool truthVal, F f) {
+	PairMask mask = 0;
+	for (unsigned i = 0; i < PRECISION_NO; i++) {
+		for (unsigned j = 0; j < PRECISION_NO; j++) {
+			mask |= PairMask(f(l[i], r[j]) == truthVal) << (i * PRECISION_NO + j);
+		}
+	}
+	return mask;
+}
+
+// The pairs for which l[i] op r[j] evaluates to truthVal.
+inline PairMask fcmpMask(const HIGHPRECISION* l, const HIGHPRECISION* r, CMPOP op, bool truthVal) {
+	switch (op) {
+		case OEQ:
+			return comparePairs(l, r, truthVal, [](HIGHPRECISION a, HIGHPRECISION b) {
+				return a == b;
+			});
+		case OGT:
+			return comparePairs(l, r, truthVal, [](HIGHPRECISION a, HIGHPRECISION b) {
+				return a > b;
+			});
+		case OGE:
+			return comparePairs(l, r, truthVal, [](HIGHPRECISION a, HIGHPRECISION b) {
+				return a >= b;
+			});
+		case OLT:
+			return comparePairs(l, r, truthVal, [](HIGHPRECISION a, HIGHPRECISION b) {
+				return a < b;
+			});
+		case OLE:
+			return comparePairs(l, r, truthVal, [](HIGHPRECISION a, HIGHPRECISION b) {
+				return a <= b;
+			});
+		case ONE:
+			return comparePairs(l, r, truthVal, [](HIGHPRECISION a, HIGHPRECISION b) {
+				return a != b;
+			});
+		default:
+			assert(false && "Unsupported floating-point comparision operator.");
+	}
+
+	return 0;
+}
+
+#endif
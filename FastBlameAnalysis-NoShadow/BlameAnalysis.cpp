@@ -4,7 +4,7 @@ using namespace std;
 /*** HELPER FUNCTIONS ***/
 
 std::unordered_map<IID, DebugInfo> BlameAnalysis::readDebugInfo() {
-	ifstream fin("debug.bin");
+	ifstream fin(debugFile("debug.bin"));
 	std::unordered_map<IID, DebugInfo> debugInfoMap;
 	while (fin) {
 		IID id;
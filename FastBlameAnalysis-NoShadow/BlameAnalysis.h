@@ -33,7 +33,7 @@ private:
 
 	string get_selfpath();
 
-	// Read debug information from $GLOG_log_dir/debug.bin and wrap into a
+	// Read debug information from debug.bin (see debugFile) and wrap into a
 	// mapping from instruction IID to DebugInfo struct. The file debug.bin is
 	// constructed during instrumentation phase.
 	//
@@ -6,15 +6,8 @@
 #include <unordered_map>
 #include <istream>
 
-struct DebugInfo {
-	std::string file;
-	unsigned line, column;
-	DebugInfo() : file("n/a"), line(0), column(0) {}
-};
-
-std::istream& operator>>(std::istream& input, DebugInfo& dbg);
+#include "DebugInfo.h"
 
-typedef int32_t IID;
 typedef double HIGHPRECISION;
 typedef float LOWPRECISION;
 
@@ -2,14 +2,14 @@
 #include <iostream>
 #include "Glue.h"
 #include "BlameAnalysis.h"
+#include "CallStack.h"
 
 using std::unordered_map;
 using std::cout;
 using std::endl;
 
-unordered_map<unsigned, IID> arg_to_real_iid;
+CallStack call_stack;
 unordered_map<void*, IID> ptr_to_iid;
-IID return_iid;
 
 void llvm_fadd(IID iidf, double v, IID l, double lo, IID r, double ro) {
 	BlameAnalysis::get().fadd(iidf, l, r, v, lo, ro);
@@ -75,8 +75,9 @@ void llvm_fstore(IID iidV, double, IID iid, void* vptr) {
 	}
 
 	if (iidV < 0) {
-		assert(arg_to_real_iid.find(-iidV) != arg_to_real_iid.end());
-		iidV = arg_to_real_iid[-iidV];
+		const Binding* arg = call_stack.arg(-iidV);
+		assert(arg && "Argument was not passed by an instrumented call.");
+		iidV = arg->iid;
 	}
 
 	ptr_to_iid[vptr] = iidV;
@@ -116,15 +117,24 @@ void llvm_call_pow(IID iidf, double, IID operand01, double operandValue01, IID o
 	BlameAnalysis::get().call_pow(iidf, operand01, operandValue01, operand02, operandValue02);
 }
 
+void llvm_push_frame(void* callee) {
+	call_stack.push(callee);
+}
+
+void llvm_pop_frame() {
+	call_stack.pop();
+}
+
 void llvm_arg(unsigned argInx, IID iid) {
-	arg_to_real_iid[argInx] = iid;
+	call_stack.bindArg(argInx, iid);
 }
 
-void llvm_return(IID iid) {
-	return_iid = iid;
+void llvm_return(void* function, IID iid) {
+	call_stack.bindReturn(function, iid);
 }
 
 void llvm_after_call(IID iid, double v) {
-	BlameAnalysis::get().fafter_call(iid, v, return_iid);
-	return_iid = -1;  // invalidate this return id
+	Binding& ret = call_stack.top().ret;
+	BlameAnalysis::get().fafter_call(iid, v, ret.bound ? ret.iid : -1);
+	ret.bound = false;  // invalidate this return id
 }
@@ -5,14 +5,21 @@
 #include <fstream>
 #include <set>
 #include <queue>
+#include <algorithm>
 
 #include "BlameAnalysis.h"
+#include "ShadowKernels.h"
 using namespace std;
 
 /*** HELPER FUNCTIONS ***/
 
+// The shadow object of an EVENT_SHADOW record, for an operand of value v.
+static inline BlameShadowObject shadowObject(const Event& shadow, HIGHPRECISION v) {
+	return BlameShadowObject(shadow.iid, {{shadow.f, shadow.lv, shadow.rv, v}});
+}
+
 std::unordered_map<IID, DebugInfo> BlameAnalysis::readDebugInfo() {
-	ifstream fin("debug.bin");
+	ifstream fin(debugFile("debug.bin"));
 	std::unordered_map<IID, DebugInfo> debugInfoMap;
 	while (fin) {
 		IID id;
@@ -37,16 +44,12 @@ std::string BlameAnalysis::get_selfpath() {
 }
 
 const BlameShadowObject BlameAnalysis::getShadowObject(IID iid, HIGHPRECISION v) {
-	if (trace.find(iid) != trace.end()) {
-		return trace[iid];
+	if (const BlameShadowObject* BSO = trace.find(iid)) {
+		return *BSO;
 	}
 
 	std::array<HIGHPRECISION, PRECISION_NO> values;
-	values[BITS_FLOAT] = (LOWPRECISION)v;
-
-	for (PRECISION i = PRECISION(BITS_FLOAT + 1); i < PRECISION_NO; i = PRECISION(i + 1)) {
-		values[i] = clearBits(v, DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[i]);
-	}
+	shadowRound(v, values.data());
 
 	return BlameShadowObject(iid, values);
 }
@@ -54,11 +57,7 @@ const BlameShadowObject BlameAnalysis::getShadowObject(IID iid, HIGHPRECISION v)
 const BlameShadowObject BlameAnalysis::shadowFEval(IID iid, const BlameShadowObject& lBSO,
 		const BlameShadowObject& rBSO, FBINOP op) {
 	std::array<HIGHPRECISION, PRECISION_NO> values;
-	values[BITS_FLOAT] = feval<LOWPRECISION>(lBSO.values[0], rBSO.values[0], op);
-	for (PRECISION p = PRECISION(BITS_FLOAT + 1); p < PRECISION_NO; p = PRECISION(p + 1)) {
-		values[p] =
-			clearBits(feval<HIGHPRECISION>(lBSO.values[p], rBSO.values[p], op), DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]);
-	}
+	shadowBinop(lBSO.values.data(), rBSO.values.data(), op, values.data());
 
 	return BlameShadowObject(iid, values);
 }
@@ -67,47 +66,42 @@ const BlameShadowObject BlameAnalysis::shadowFEval(IID iid, const BlameShadowObj
 	std::array<HIGHPRECISION, PRECISION_NO> values;
 	values[BITS_FLOAT] = mathLibEval<LOWPRECISION>(argBSO.values[0], func);
 	for (PRECISION p = PRECISION(BITS_FLOAT + 1); p < PRECISION_NO; p = PRECISION(p + 1)) {
-		values[p] =
-			clearBits(mathLibEval<HIGHPRECISION>(argBSO.values[p], func), DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]);
+		values[p] = mathLibEval<HIGHPRECISION>(argBSO.values[p], func);
 	}
+	shadowClear(values.data());
 
 	return BlameShadowObject(iid, values);
 }
 
 void BlameAnalysis::computeBlameSummary(const BlameShadowObject& BSO, const BlameShadowObject& lBSO,
 										const BlameShadowObject& rBSO, FBINOP op) {
-	std::array<BlameNode, PRECISION_NO> blames;
-	blames[BITS_FLOAT] =
-		BlameNode(BSO.id, BITS_FLOAT, false, false, {BlameNodeID(lBSO.id, BITS_FLOAT), BlameNodeID(rBSO.id, BITS_FLOAT)});
+	std::array<BlameNode, PRECISION_NO>& blames = blameSummary[BSO.id];
+	blames[BITS_FLOAT].set(BSO.id, BITS_FLOAT, false, false, BlameNodeID(lBSO.id, BITS_FLOAT),
+						   BlameNodeID(rBSO.id, BITS_FLOAT));
 
 	for (PRECISION p = PRECISION(BITS_FLOAT + 1); p < PRECISION_NO; p = PRECISION(p + 1)) {
-		blames[p] = computeBlameInformation(BSO, lBSO, rBSO, op, p);
-		BlameNode bn = blames[p];
+		computeBlameInformation(blames[p], BSO, lBSO, rBSO, op, p);
 	}
-
-	blameSummary[BSO.id] = blames;
 }
 
 void BlameAnalysis::computeBlameSummary(const BlameShadowObject& BSO, const BlameShadowObject& argBSO, MATHFUNC func) {
-	std::array<BlameNode, PRECISION_NO> blames;
-	blames[BITS_FLOAT] = BlameNode(BSO.id, BITS_FLOAT, false, false, {BlameNodeID(argBSO.id, BITS_FLOAT)});
+	std::array<BlameNode, PRECISION_NO>& blames = blameSummary[BSO.id];
+	blames[BITS_FLOAT].set(BSO.id, BITS_FLOAT, false, false, BlameNodeID(argBSO.id, BITS_FLOAT));
 
 	for (PRECISION p = PRECISION(BITS_FLOAT + 1); p < PRECISION_NO; p = PRECISION(p + 1)) {
-		blames[p] = computeBlameInformation(BSO, argBSO, func, p);
+		computeBlameInformation(blames[p], BSO, argBSO, func, p);
 	}
-
-	blameSummary[BSO.id] = blames;
 }
 
-BlameNode BlameAnalysis::computeBlameInformation(const BlameShadowObject& BSO, const BlameShadowObject& argBSO,
-		MATHFUNC func, PRECISION p) {
+void BlameAnalysis::computeBlameInformation(BlameNode& node, const BlameShadowObject& BSO,
+		const BlameShadowObject& argBSO, MATHFUNC func, PRECISION p) {
 	HIGHPRECISION val = BSO.values[p];
 	bool requireHigherPrecision = val != (LOWPRECISION)val;
 	bool requireHigherPrecisionOperator = true;
 
-	// Compute the minimal blame information.
-	PRECISION min_i =
-		blameSummary.find(BSO.id) != blameSummary.end() ? blameSummary[BSO.id][p].children[0].precision : BITS_FLOAT;
+	// Compute the minimal blame information, starting from the blame of the
+	// previous execution (BITS_FLOAT for a fresh node).
+	PRECISION min_i = node.child(0).precision;
 
 	assert(min_i >= BITS_FLOAT && min_i <= BITS_DOUBLE && "ERROR: precision out or range.");
 
@@ -122,55 +116,34 @@ BlameNode BlameAnalysis::computeBlameInformation(const BlameShadowObject& BSO, c
 	}
 
 	assert(i != PRECISION_NO && "Minimal blames cannot be found!");
-	return BlameNode(BSO.id, p, requireHigherPrecision, requireHigherPrecisionOperator, {BlameNodeID(argBSO.id, i)});
+	node.set(BSO.id, p, requireHigherPrecision, requireHigherPrecisionOperator, BlameNodeID(argBSO.id, i));
 }
 
-BlameNode BlameAnalysis::computeBlameInformation(const BlameShadowObject& BSO, const BlameShadowObject& lBSO,
-		const BlameShadowObject& rBSO, FBINOP op, PRECISION p) {
+void BlameAnalysis::computeBlameInformation(BlameNode& node, const BlameShadowObject& BSO,
+		const BlameShadowObject& lBSO, const BlameShadowObject& rBSO, FBINOP op, PRECISION p) {
 	HIGHPRECISION val = BSO.values[p];
 	bool requireHigherPrecision = val != (LOWPRECISION)val;
 	bool requireHigherPrecisionOperator = true;
 
-	// Compute the minimal blame information.
-	bool found = false;
-	PRECISION min_i = BITS_FLOAT;
-	PRECISION min_j = BITS_FLOAT;
-	if (blameSummary.find(BSO.id) != blameSummary.end()) {
-		BlameNode& bn = blameSummary[BSO.id][p];
-		min_i = bn.children[0].precision;
-		min_j = bn.children[1].precision;
-	}
+	// Compute the minimal blame information, starting from the blame of the
+	// previous execution (BITS_FLOAT for a fresh node).
+	PRECISION min_i = node.child(0).precision;
+	PRECISION min_j = node.child(1).precision;
 
 	assert(min_i >= BITS_FLOAT && min_i <= BITS_DOUBLE && "ERROR: precision out or range.");
 	assert(min_j >= BITS_FLOAT && min_j <= BITS_DOUBLE && "ERROR: precision out or range.");
 
-	PRECISION i = min_i;
-	PRECISION j = min_j;
-	// Try all combination of i and j to find the blame that works.
-	for (i = min_i; i < PRECISION_NO; i = PRECISION(i + 1)) {
-		for (j = min_j; j < PRECISION_NO; j = PRECISION(j + 1)) {
-			if (!canBlame(val, lBSO.values[i], rBSO.values[j], op, p)) {
-				continue;
-			}
-
-			found = true;
-			requireHigherPrecisionOperator = isRequiredHigherPrecisionOperator(val, lBSO.values[i], rBSO.values[j], op, p);
-			break;
-		}
-		if (found) {
-			break;
-		}
+	// Try all combination of i and j in one batch; the first one that works
+	// is the lowest bit set. Without one, the operands are blamed at double
+	// precision.
+	PairMask pass = blameMask(val, lBSO.values.data(), rBSO.values.data(), op, p) & precisionPairs(min_i, min_j);
+	PRECISION i, j;
+	if (firstPair(pass, i, j)) {
+		requireHigherPrecisionOperator = isRequiredHigherPrecisionOperator(val, lBSO.values[i], rBSO.values[j], op, p);
 	}
 
-	assert(found && "Minimal blames cannot be found!");
-	return BlameNode(BSO.id, p, requireHigherPrecision, requireHigherPrecisionOperator,
-	{BlameNodeID(lBSO.id, i), BlameNodeID(rBSO.id, j)});
-}
-
-inline bool BlameAnalysis::canBlame(HIGHPRECISION result, HIGHPRECISION lop, HIGHPRECISION rop, FBINOP op,
-									PRECISION p) {
-	return equalWithinPrecision(
-			   result, clearBits(feval<HIGHPRECISION>(lop, rop, op), DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]), p);
+	node.set(BSO.id, p, requireHigherPrecision, requireHigherPrecisionOperator, BlameNodeID(lBSO.id, i),
+			 BlameNodeID(rBSO.id, j));
 }
 
 inline bool BlameAnalysis::canBlame(HIGHPRECISION result, HIGHPRECISION arg, MATHFUNC func, PRECISION p) {
@@ -184,9 +157,20 @@ inline bool BlameAnalysis::isRequiredHigherPrecisionOperator(HIGHPRECISION resul
 			   result, clearBits(feval<LOWPRECISION>(lop, rop, op), DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]), p);
 }
 
+void BlameAnalysis::computeDivergeNode(const BlameShadowObject& lBSO, const BlameShadowObject& rBSO, CMPOP op) {
+	bool truthVal = fcmp_eval<HIGHPRECISION>(lBSO.values[BITS_DOUBLE], rBSO.values[BITS_DOUBLE], op);
+	PRECISION i, j;
+	if (firstPair(fcmpMask(lBSO.values.data(), rBSO.values.data(), op, truthVal), i, j)) {
+		diverge.insert(BlameNodeID(lBSO.id, i));
+		diverge.insert(BlameNodeID(rBSO.id, j));
+	}
+}
+
 void BlameAnalysis::copyBlameSummary(IID dest, IID src) {
-	if (blameSummary.find(src) != blameSummary.end()) {
-		blameSummary[dest] = blameSummary[src];
+	if (const std::array<BlameNode, PRECISION_NO>* summary = blameSummary.find(src)) {
+		// copy first; the insert may grow the table
+		std::array<BlameNode, PRECISION_NO> blames = *summary;
+		blameSummary[dest] = blames;
 	}
 }
 
@@ -220,6 +204,27 @@ void BlameAnalysis::call_lib(IID iid, IID argiid, HIGHPRECISION argv, MATHFUNC f
 	_iid = iid;
 }
 
+void BlameAnalysis::blame(IID iid, const BlameShadowObject& lBSO, const BlameShadowObject& rBSO, FBINOP op) {
+	const BlameShadowObject BSO = shadowFEval(iid, lBSO, rBSO, op);
+	trace[iid] = BSO;
+	computeBlameSummary(BSO, lBSO, rBSO, op);
+	_iid = iid;
+}
+
+void BlameAnalysis::blame(IID iid, const BlameShadowObject& argBSO, MATHFUNC func) {
+	const BlameShadowObject BSO = shadowFEval(iid, argBSO, func);
+	trace[iid] = BSO;
+	computeBlameSummary(BSO, argBSO, func);
+	_iid = iid;
+}
+
+void BlameAnalysis::fcmp(IID, const BlameShadowObject& lBSO, const BlameShadowObject& rBSO, CMPOP op) {
+	if (fcmp_eval<HIGHPRECISION>(lBSO.values[BITS_DOUBLE], rBSO.values[BITS_DOUBLE], op) !=
+			fcmp_eval<LOWPRECISION>(lBSO.values[BITS_FLOAT], rBSO.values[BITS_FLOAT], op)) {
+		computeDivergeNode(lBSO, rBSO, op);
+	}
+}
+
 void BlameAnalysis::fadd(IID iid, IID liid, IID riid, HIGHPRECISION lv, HIGHPRECISION rv) {
 	fbinop(iid, liid, riid, lv, rv, FADD);
 }
@@ -261,15 +266,71 @@ void BlameAnalysis::call_exp(IID iid, IID argIID, HIGHPRECISION argv) {
 	call_lib(iid, argIID, argv, EXP);
 }
 
+void BlameAnalysis::fload(IID iid, IID ptrIID, void* vptr) {
+	const MemoryShadow* shadow = trace_ptr.find(vptr);
+	if (shadow && shadow->writer == ptrIID + 1) {
+		BlameShadowObject& BSO = trace[ptrIID];
+		BSO.id = ptrIID;
+		BSO.values[BITS_FLOAT] = shadow->f;
+		std::copy(shadow->values, shadow->values + PRECISION_NO - 1, BSO.values.begin() + 1);
+	} else {
+		trace.erase(iid);
+	}
+}
+
+void BlameAnalysis::fstore(IID iid, void* vptr) {
+	if (const BlameShadowObject* BSO = trace.find(iid)) {
+		MemoryShadow& shadow = trace_ptr[vptr];
+		shadow.writer = iid + 1;
+		shadow.f = BSO->values[BITS_FLOAT];
+		std::copy(BSO->values.begin() + 1, BSO->values.end(), shadow.values);
+	}
+}
+
+void BlameAnalysis::process(const Event* events, size_t n) {
+	for (const Event* e = events; e != events + n; e++) {
+		switch (e->kind) {
+			case EVENT_FBINOP:
+				fbinop(e->iid, e->liid, e->riid, e->lv, e->rv, FBINOP(e->op));
+				break;
+			case EVENT_CALL_LIB:
+				call_lib(e->iid, e->liid, e->lv, MATHFUNC(e->op));
+				break;
+			case EVENT_FLOAD:
+				fload(e->iid, e->liid, e->ptr);
+				break;
+			case EVENT_FSTORE:
+				fstore(e->iid, e->ptr);
+				break;
+			case EVENT_FBLAME:
+				blame(e->iid, shadowObject(e[1], e->lv), shadowObject(e[2], e->rv), FBINOP(e->op));
+				e += 2;
+				break;
+			case EVENT_FBLAME_CALL:
+				blame(e->iid, shadowObject(e[1], e->lv), MATHFUNC(e->op));
+				e += 1;
+				break;
+			case EVENT_FCMP:
+				fcmp(e->iid, shadowObject(e[1], e->lv), shadowObject(e[2], e->rv), CMPOP(e->op));
+				e += 2;
+				break;
+			default:
+				assert(false && "Unknown event kind!");
+		}
+	}
+}
+
 void BlameAnalysis::post_analysis() {
 	std::ofstream tracefile;
 	tracefile.open(_selfpath + ".trace");
 	// Print the trace
 	tracefile << "====== execution trace ======" << endl;
-	for (auto& it : trace) {
-		IID iid = it.first;
+	for (IID iid = 0; iid < trace.size(); iid++) {
+		if (!trace.contains(iid)) {
+			continue;
+		}
 		DebugInfo dbg = debugInfoMap.at(iid);
-		BlameShadowObject bso = it.second;
+		BlameShadowObject bso = *trace.find(iid);
 		tracefile << "At file " << dbg.file << ", line " << dbg.line << ", column " << dbg.column << ", id " << iid << endl;
 		tracefile << "\t";
 		for (PRECISION i = BITS_FLOAT; i < PRECISION_NO; i = PRECISION(i + 1)) {
@@ -304,15 +365,21 @@ void BlameAnalysis::post_analysis() {
 	std::set<BlameNode> visited;
 	std::queue<BlameNode> workList;
 	workList.push(blameSummary[_iid][_precision]);
+	for (const BlameNodeID& nodeid : diverge) {
+		// diverge nodes prevent divergence
+		if (blameSummary.contains(nodeid.iid)) {
+			workList.push(blameSummary[nodeid.iid][nodeid.precision]);
+		}
+	}
 
 	while (!workList.empty()) {
 		// Find more blame node and add to the queue.
 		const BlameNode& node = workList.front();
-		logfile2 << "(" << node.id.iid << "," << PRECISION_BITS[node.id.precision] << ") : ";
-		for (auto it = node.children.begin(); it != node.children.end(); it++) {
-			const BlameNodeID blameNodeID = *it;
+		logfile2 << "(" << node.id().iid << "," << PRECISION_BITS[node.id().precision] << ") : ";
+		for (unsigned c = 0; c < node.childCount(); c++) {
+			const BlameNodeID blameNodeID = node.child(c);
 			logfile2 << "(" << blameNodeID.iid << "," << PRECISION_BITS[blameNodeID.precision] << ") ";
-			if (blameSummary.find(blameNodeID.iid) == blameSummary.end()) {
+			if (!blameSummary.contains(blameNodeID.iid)) {
 				// Children are either a constant or alloca.
 				continue;
 			}
@@ -325,10 +392,10 @@ void BlameAnalysis::post_analysis() {
 		logfile2 << endl;
 
 		// Interpret the result for the current blame node.
-		if (debugInfoMap.find(node.id.iid) == debugInfoMap.end()) {
+		if (debugInfoMap.find(node.id().iid) == debugInfoMap.end()) {
 			continue;
 		}
-		DebugInfo dbg = debugInfoMap.at(node.id.iid);
+		DebugInfo dbg = debugInfoMap.at(node.id().iid);
 		if (node.requireHigherPrecision || node.requireHigherPrecisionOperator) {
 			logfile << "File " << dbg.file << ", Line " << dbg.line << ", Column " << dbg.column
 					<< ", HigherPrecision: " << node.requireHigherPrecision
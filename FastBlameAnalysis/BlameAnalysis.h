@@ -1,21 +1,36 @@
 #ifndef _BLAME_ANALYSIS_H_
 #define _BLAME_ANALYSIS_H_
 
+#include <set>
 #include <unordered_map>
 
 #include "BlameUtilities.h"
 #include "BlameNode.h"
 #include "BlameShadowObject.h"
-
-namespace std {
-template <> struct hash<pair<void*, IID>> {
-	size_t operator()(const pair<void*, IID>& p) const {
-		hash<void*> vh;
-		hash<IID> vi;
-		return vh(p.first) ^ vi(p.second);
-	}
+#include "EventBuffer.h"
+#include "IIDTable.h"
+#include "AddressShadow.h"
+
+// Shadow of a floating-point value in memory: the shadow object of the last
+// instrumented store to its address.
+//
+// The slot is 32 bytes per 4-byte granule, 8 times a float and, since a
+// double only uses the slot of its first granule, 8 times a double too. The
+// shadow object itself is the bulk of it: the value at the four precisions
+// takes 28 bytes with BITS_FLOAT kept as a float, and the writer the last 4,
+// without padding. Holding the shadow objects out of
+// line would save the slots of the second granules but add a lookup and an
+// allocation per store. The cost is paid only on the pages of memory that
+// hold stored floating-point values, see AddressShadow.
+struct MemoryShadow {
+	// The IID of the instruction whose shadow object this is, + 1; 0 in an
+	// empty slot, so that a zeroed page holds no shadow.
+	IID writer;
+	LOWPRECISION f;
+	HIGHPRECISION values[PRECISION_NO - 1];  // BITS_FLOAT + 1 and up
 };
-}
+
+static_assert(sizeof(MemoryShadow) == 32, "MemoryShadow is one slot per 4-byte granule, keep it small.");
 
 class BlameAnalysis {
 private:
@@ -31,7 +46,7 @@ private:
 
 	std::string get_selfpath();
 
-	// Read debug information from $GLOG_log_dir/debug.bin and wrap into a
+	// Read debug information from debug.bin (see debugFile) and wrap into a
 	// mapping from instruction IID to DebugInfo struct. The file debug.bin is
 	// constructed during instrumentation phase.
 	//
@@ -44,7 +59,12 @@ private:
 	// Debug information includes the LoC, column and file of the instruction.
 	const std::unordered_map<IID, DebugInfo> debugInfoMap = readDebugInfo();
 
-	std::unordered_map<IID, std::array<BlameNode, PRECISION_NO>> blameSummary;
+	IIDTable<std::array<BlameNode, PRECISION_NO>> blameSummary;
+
+	// Operands of comparisons whose outcome differs at low precision, at the
+	// lowest precisions that keep the outcome. They are analyzed along with the
+	// starting point.
+	std::set<BlameNodeID> diverge;
 
 	// Global information about the starting point of the analysis.
 	PRECISION _precision;
@@ -58,8 +78,8 @@ private:
 	}
 
 public:
-	std::unordered_map<IID, BlameShadowObject> trace;
-	std::unordered_map<std::pair<void*, IID>, BlameShadowObject> trace_ptr;
+	IIDTable<BlameShadowObject> trace;
+	AddressShadow<MemoryShadow> trace_ptr;
 
 	static BlameAnalysis& get() {
 		static BlameAnalysis global;
@@ -67,6 +87,7 @@ public:
 	}
 
 	~BlameAnalysis() {
+		EventBuffer::shutdown();
 		post_analysis();
 	}
 
@@ -84,6 +105,18 @@ public:
 	void fmul(IID iid, IID liid, IID riid, HIGHPRECISION lv, HIGHPRECISION rv);
 	void fdiv(IID iid, IID liid, IID riid, HIGHPRECISION lv, HIGHPRECISION rv);
 
+	void fload(IID iid, IID ptrIID, void* vptr);
+	void fstore(IID iid, void* vptr);
+
+	// Replay a batch of recorded events in order.
+	void process(const Event* events, size_t n);
+
+	// Record the blame of an operation whose shadows were computed by the
+	// instrumented code (FPPass -inline-shadow).
+	void blame(IID iid, const BlameShadowObject& lBSO, const BlameShadowObject& rBSO, FBINOP op);
+	void blame(IID iid, const BlameShadowObject& argBSO, MATHFUNC func);
+	void fcmp(IID iid, const BlameShadowObject& lBSO, const BlameShadowObject& rBSO, CMPOP op);
+
 	void load(IID viid, IID piid, HIGHPRECISION v);
 	void store(IID viid, IID piid, HIGHPRECISION v);
 	void getelementptr(IID aiid, IID eiid, HIGHPRECISION v);
@@ -102,13 +135,12 @@ private:
 
 	void computeBlameSummary(const BlameShadowObject& BSO, const BlameShadowObject& argBSO, MATHFUNC func);
 
-	BlameNode computeBlameInformation(const BlameShadowObject& BSO, const BlameShadowObject& lBSO,
-									  const BlameShadowObject& rBSO, FBINOP op, PRECISION p);
+	// Update node, the blame of BSO at precision p, in place.
+	void computeBlameInformation(BlameNode& node, const BlameShadowObject& BSO, const BlameShadowObject& lBSO,
+								 const BlameShadowObject& rBSO, FBINOP op, PRECISION p);
 
-	BlameNode computeBlameInformation(const BlameShadowObject& BSO, const BlameShadowObject& argBSO, MATHFUNC func,
-									  PRECISION p);
-
-	bool canBlame(HIGHPRECISION result, HIGHPRECISION lop, HIGHPRECISION rop, FBINOP op, PRECISION p);
+	void computeBlameInformation(BlameNode& node, const BlameShadowObject& BSO, const BlameShadowObject& argBSO,
+								 MATHFUNC func, PRECISION p);
 
 	bool isRequiredHigherPrecisionOperator(HIGHPRECISION result, HIGHPRECISION lop, HIGHPRECISION rop, FBINOP op,
 										   PRECISION p);
@@ -120,6 +152,8 @@ private:
 	void call_lib(IID iid, IID argIID, HIGHPRECISION v, MATHFUNC func);
 
 	void copyBlameSummary(IID dest, IID src);
+
+	void computeDivergeNode(const BlameShadowObject& lBSO, const BlameShadowObject& rBSO, CMPOP op);
 };
 
 #endif
@@ -1,7 +1,7 @@
 #ifndef _BLAME_NODE_H_
 #define _BLAME_NODE_H_
 
-#include <vector>
+#include <cstdint>
 
 struct BlameNodeID {
 	IID iid;
@@ -23,26 +23,62 @@ public:
 	;
 };
 
+// Blame nodes have at most two children (binary operations and math calls),
+// so the children are stored inline with the precisions packed into bytes.
+// A node takes 16 bytes and is updated in place in the blame summary,
+// without any allocation.
 struct BlameNode {
-	BlameNodeID id;
-	std::vector<BlameNodeID> children;
+	static const unsigned MAX_CHILDREN = 2;
+
+private:
+	IID _iid;
+	IID _childIID[MAX_CHILDREN];
+	uint8_t _precision;
+	uint8_t _childPrecision[MAX_CHILDREN];
+	uint8_t _childCount : 2;
+
+public:
 	bool requireHigherPrecision : 1;
 	bool requireHigherPrecisionOperator : 1;
 
-public:
 	BlameNode()
-		: id(BlameNodeID()), children({
-	}),
-	requireHigherPrecision(false), requireHigherPrecisionOperator(false) {}
-	;
-	BlameNode(IID i, PRECISION p, bool rhp, bool rhpo,
-			  const std::vector<BlameNodeID>& c)
-		: id(BlameNodeID(i, p)), children(c), requireHigherPrecision(rhp),
-		  requireHigherPrecisionOperator(rhpo) {}
+		: _iid(0), _childIID{0, 0}, _precision(BITS_FLOAT), _childPrecision{BITS_FLOAT, BITS_FLOAT}, _childCount(0),
+		  requireHigherPrecision(false), requireHigherPrecisionOperator(false) {}
 	;
 
+	BlameNodeID id() const {
+		return BlameNodeID(_iid, PRECISION(_precision));
+	}
+
+	unsigned childCount() const {
+		return _childCount;
+	}
+
+	// The i-th child; BITS_FLOAT of IID 0 for a child the node does not have,
+	// which is the least precision a fresh node starts the search from.
+	BlameNodeID child(unsigned i) const {
+		return BlameNodeID(_childIID[i], PRECISION(_childPrecision[i]));
+	}
+
+	void set(IID i, PRECISION p, bool rhp, bool rhpo, BlameNodeID c) {
+		_iid = i;
+		_precision = p;
+		requireHigherPrecision = rhp;
+		requireHigherPrecisionOperator = rhpo;
+		_childIID[0] = c.iid;
+		_childPrecision[0] = c.precision;
+		_childCount = 1;
+	}
+
+	void set(IID i, PRECISION p, bool rhp, bool rhpo, BlameNodeID l, BlameNodeID r) {
+		set(i, p, rhp, rhpo, l);
+		_childIID[1] = r.iid;
+		_childPrecision[1] = r.precision;
+		_childCount = 2;
+	}
+
 	bool operator<(const BlameNode& rhs) const {
-		return id < rhs.id;
+		return id() < rhs.id();
 	}
 	;
 };
@@ -1,20 +1,15 @@
 #ifndef _BLAME_UTILITIES_H_
 #define _BLAME_UTILITIES_H_
 
+#include <array>
 #include <assert.h>
 #include <cmath>
+#include <cstdlib>
 #include <unordered_map>
 #include <istream>
 
-struct DebugInfo {
-	std::string file;
-	unsigned line, column;
-	DebugInfo() : file("n/a"), line(0), column(0) {}
-};
-
-std::istream& operator>>(std::istream& input, DebugInfo& dbg);
+#include "DebugInfo.h"
 
-typedef int32_t IID;
 typedef double HIGHPRECISION;
 typedef float LOWPRECISION;
 
@@ -34,6 +29,16 @@ typedef enum {
 	FBINOP_NO
 } FBINOP;
 
+typedef enum {
+	OEQ,
+	OGT,
+	OGE,
+	OLT,
+	OLE,
+	ONE,
+	CMPOP_NO
+} CMPOP;
+
 typedef enum {
 	SIN,
 	ACOS,
@@ -100,7 +105,7 @@ inline bool equalWithinPrecision(double v1, double v2, PRECISION p) {
 			(DOUBLE_MANTISSA_LENGTH - PRECISION_BITS.at(p) - 1);
 
 	// Return true if the two mantissa offset less than or equal to 1.
-	return abs(*ptr1 - *ptr2) <= 1;
+	return std::abs(*ptr1 - *ptr2) <= 1;
 }
 
 // Template function to perform the floating-point binary operator on
@@ -147,4 +152,25 @@ template <typename T> T mathLibEval(T val, MATHFUNC func) {
 	return 0;
 }
 
+template <typename T> bool fcmp_eval(T val01, T val02, CMPOP op) {
+	switch (op) {
+		case OEQ:
+			return val01 == val02;
+		case OGT:
+			return val01 > val02;
+		case OGE:
+			return val01 >= val02;
+		case OLT:
+			return val01 < val02;
+		case OLE:
+			return val01 <= val02;
+		case ONE:
+			return val01 != val02;
+		default:
+			assert(false && "Unsupported floating-point comparision operator.");
+	}
+
+	return false;
+}
+
 #endif
@@ -0,0 +1,214 @@
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+#include "EventBuffer.h"
+#include "BlameAnalysis.h"
+
+// Serializes the batches of all threads when they are processed by the
+// threads that filled them, and the batches of the analysis thread with
+// those; BlameAnalysis itself is not thread-safe.
+static std::mutex consumer;
+
+// Set by EventBuffer::shutdown under consumer: post_analysis is about to
+// run, and batches that come in later are dropped.
+static bool closed = false;
+
+// Dedicated thread that maintains the analysis state. Batches are passed from
+// the instrumented threads through a bounded multi-producer single-consumer
+// ring: a producer claims a slot by advancing head and publishes it through
+// the sequence number of the slot, so producers never take a lock. The
+// analysis thread sleeps on a condition variable while the ring is empty
+// instead of spinning, and producers only sleep while it is full.
+class AnalysisThread {
+public:
+	static const size_t SLOTS = 64;
+
+	// Never destroyed: BlameAnalysis stops the thread through
+	// EventBuffer::shutdown, whatever the order of the static destructors.
+	static AnalysisThread& get() {
+		static AnalysisThread* global = new AnalysisThread();
+		return *global;
+	}
+
+	// Move the events into the ring and leave an empty buffer in their place.
+	// Blocks while the ring is full. Returns false, and leaves the events
+	// alone, once the thread has been stopped.
+	bool push(std::vector<Event>& events) {
+		// announce the producer before looking at stopping, so that the analysis
+		// thread does not quit while a batch is on its way
+		producers.fetch_add(1, std::memory_order_seq_cst);
+		if (stopping.load(std::memory_order_seq_cst)) {
+			// the analysis thread may have seen this producer and gone back to
+			// sleep; the last producer out wakes it up to quit
+			if (producers.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+				std::lock_guard<std::mutex> lock(wait);
+				ready.notify_one();
+			}
+			return false;
+		}
+
+		size_t pos = head.load(std::memory_order_relaxed);
+		Slot* slot;
+		while (true) {
+			slot = &slots[pos % SLOTS];
+			size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			if (sequence == pos) {
+				if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (sequence < pos) {
+				waitForSpace(slot, pos);
+				pos = head.load(std::memory_order_relaxed);
+			} else {
+				pos = head.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->events.swap(events);
+		slot->sequence.store(pos + 1, std::memory_order_seq_cst);
+		producers.fetch_sub(1, std::memory_order_seq_cst);
+		if (sleeping.load(std::memory_order_seq_cst)) {
+			std::lock_guard<std::mutex> lock(wait);
+			ready.notify_one();
+		}
+		return true;
+	}
+
+	// Process every queued batch and join the thread. Later batches are
+	// rejected by push.
+	void stop() {
+		if (stopping.exchange(true)) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(wait);
+			ready.notify_one();
+		}
+		worker.join();
+	}
+
+private:
+	struct Slot {
+		// pos while the slot is free for the producer of position pos, pos + 1
+		// once that producer has published its batch
+		std::atomic<size_t> sequence;
+		std::vector<Event> events;
+	};
+
+	AnalysisThread() : head(0), tail(0), sleeping(false), waitingProducers(0), producers(0), stopping(false) {
+		for (size_t i = 0; i < SLOTS; i++) {
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		worker = std::thread(&AnalysisThread::run, this);
+	}
+
+	bool published(size_t pos) const {
+		return slots[pos % SLOTS].sequence.load(std::memory_order_seq_cst) == pos + 1;
+	}
+
+	void waitForSpace(Slot* slot, size_t pos) {
+		std::unique_lock<std::mutex> lock(wait);
+		waitingProducers.fetch_add(1, std::memory_order_seq_cst);
+		space.wait(lock, [slot, pos]() { return slot->sequence.load(std::memory_order_seq_cst) >= pos; });
+		waitingProducers.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	void run() {
+		while (true) {
+			if (!published(tail)) {
+				std::unique_lock<std::mutex> lock(wait);
+				sleeping.store(true, std::memory_order_seq_cst);
+				ready.wait(lock, [this]() {
+					return published(tail) || (stopping.load(std::memory_order_seq_cst) &&
+											   producers.load(std::memory_order_seq_cst) == 0);
+				});
+				sleeping.store(false, std::memory_order_relaxed);
+				if (!published(tail)) {
+					return;
+				}
+			}
+
+			Slot& slot = slots[tail % SLOTS];
+			{
+				// uncontended until stop, when rejected batches are processed by
+				// the threads that filled them
+				std::lock_guard<std::mutex> lock(consumer);
+				BlameAnalysis::get().process(slot.events.data(), slot.events.size());
+			}
+			slot.events.clear();
+			slot.sequence.store(tail + SLOTS, std::memory_order_seq_cst);
+			tail++;
+			if (waitingProducers.load(std::memory_order_seq_cst) != 0) {
+				std::lock_guard<std::mutex> lock(wait);
+				space.notify_all();
+			}
+		}
+	}
+
+	std::array<Slot, SLOTS> slots;
+	std::atomic<size_t> head;
+	size_t tail;  // only used by the analysis thread
+
+	std::mutex wait;  // only taken to sleep and to wake up a sleeper
+	std::condition_variable ready;
+	std::condition_variable space;
+	std::atomic<bool> sleeping;
+	std::atomic<unsigned> waitingProducers;
+
+	std::atomic<unsigned> producers;  // threads inside push
+	std::atomic<bool> stopping;
+	std::thread worker;
+};
+
+const bool EventBuffer::asyncOn = getenv("BA_ASYNC") != NULL;
+const bool EventBuffer::bufferOn = getenv("BA_EVENT_BUFFER") != NULL || EventBuffer::asyncOn;
+thread_local EventBuffer* EventBuffer::current = nullptr;
+
+EventBuffer& EventBuffer::attach() {
+	// Construct the analysis before the first buffer so that it is destroyed,
+	// and post_analysis is run, only after all buffers have been flushed.
+	BlameAnalysis* analysis = &BlameAnalysis::get();
+	if (async()) {
+		AnalysisThread::get();
+	}
+	static thread_local EventBuffer buffer(analysis);
+	current = &buffer;
+	return buffer;
+}
+
+EventBuffer::~EventBuffer() {
+	flush();
+	current = nullptr;
+}
+
+void EventBuffer::flush() {
+	if (events.empty()) {
+		return;
+	}
+
+	if (async() && AnalysisThread::get().push(events)) {
+		events.reserve(CAPACITY);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(consumer);
+	if (!closed) {
+		analysis->process(events.data(), events.size());
+	}
+	events.clear();
+}
+
+void EventBuffer::shutdown() {
+	if (EventBuffer* buffer = current) {
+		buffer->flush();
+	}
+	if (async()) {
+		AnalysisThread::get().stop();
+	}
+	std::lock_guard<std::mutex> lock(consumer);
+	closed = true;
+}
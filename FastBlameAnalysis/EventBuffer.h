@@ -0,0 +1,125 @@
+#ifndef _EVENT_BUFFER_H_
+#define _EVENT_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BlameUtilities.h"
+
+typedef enum {
+	EVENT_FBINOP,
+	EVENT_CALL_LIB,
+	EVENT_FLOAD,
+	EVENT_FSTORE,
+	EVENT_FBLAME,
+	EVENT_FBLAME_CALL,
+	EVENT_FCMP,
+	EVENT_SHADOW,
+	EVENT_KIND_NO
+} EVENT_KIND;
+
+// Fixed-size record of one instrumented instruction. For EVENT_FBINOP op is a
+// FBINOP, for EVENT_CALL_LIB it is a MATHFUNC. Loads and stores carry the
+// address in ptr instead of the right operand value.
+//
+// The events of FPPass -inline-shadow come with the shadows the instrumented
+// code computed for their operands: EVENT_FBLAME (op is a FBINOP) and
+// EVENT_FCMP (a CMPOP) are followed by one EVENT_SHADOW record for each
+// operand, EVENT_FBLAME_CALL (a MATHFUNC) by one for its argument. A shadow
+// record holds the IID of the shadow in iid, its float value in f and its
+// BITS_19 and BITS_27 values in lv and rv; the double value is the operand
+// value of the leading record.
+struct Event {
+	IID iid;
+	IID liid;
+	union {
+		IID riid;
+		LOWPRECISION f;
+	};
+	uint16_t kind;
+	uint16_t op;
+	HIGHPRECISION lv;
+	union {
+		HIGHPRECISION rv;
+		void* ptr;
+	};
+};
+
+// Per-thread buffer of events. The instrumented code only appends records;
+// BlameAnalysis consumes them in one batch when the buffer is full and when
+// the thread exits, so that the analysis code and data stay in cache while
+// a batch is processed.
+//
+// The mode is opt-in: it is enabled when BA_EVENT_BUFFER is set in the
+// environment of the analyzed program. When BA_ASYNC is set, the batches are
+// consumed by a separate analysis thread instead of the thread that filled
+// them.
+class BlameAnalysis;
+
+class EventBuffer {
+public:
+	static const size_t CAPACITY = 4096;
+
+	static bool enabled() {
+		return bufferOn;
+	}
+
+	static bool async() {
+		return asyncOn;
+	}
+
+	// The buffer of the calling thread. Only the first call on a thread leaves
+	// this inline path.
+	static EventBuffer& local() {
+		EventBuffer* buffer = current;
+		return buffer != nullptr ? *buffer : attach();
+	}
+
+	inline void push(const Event& e) {
+		events.push_back(e);
+		if (events.size() == CAPACITY) {
+			flush();
+		}
+	}
+
+	// Append n records that must be processed in the same batch.
+	inline void push(const Event* e, size_t n) {
+		if (events.size() + n > CAPACITY) {
+			flush();
+		}
+		events.insert(events.end(), e, e + n);
+		if (events.size() == CAPACITY) {
+			flush();
+		}
+	}
+
+	void flush();
+
+	// Process the events buffered by the calling thread and everything queued
+	// for the analysis thread, then stop that thread. Called by BlameAnalysis
+	// before post_analysis, so that the result does not depend on the order in
+	// which statics and thread-locals are destroyed at exit. Once it returns,
+	// no batch is being processed, and batches flushed later by threads still
+	// running are dropped instead of racing with post_analysis.
+	static void shutdown();
+
+	~EventBuffer();
+
+private:
+	explicit EventBuffer(BlameAnalysis* analysis) : analysis(analysis) {
+		events.reserve(CAPACITY);
+	}
+
+	static EventBuffer& attach();
+
+	static const bool bufferOn;
+	static const bool asyncOn;
+	static thread_local EventBuffer* current;
+
+	// The analysis the events go to, looked up once per thread.
+	BlameAnalysis* const analysis;
+	std::vector<Event> events;
+};
+
+#endif
@@ -1,44 +1,89 @@
-#include <unordered_map>
 #include <iostream>
 #include "Glue.h"
 #include "BlameAnalysis.h"
+#include "AddressShadow.h"
+#include "CallStack.h"
+#include "IIDTable.h"
 
-using std::unordered_map;
-
-unordered_map<IID, IID> fake_to_real_iid;
-unordered_map<unsigned, IID> arg_to_real_iid;
-IID return_iid;
+// IIDs of loads, phis and call results map to the instruction that produced
+// their value.
+IIDTable<IID> fake_to_real_iid;
+CallStack call_stack;
 
 IID translate_to_real(IID val) {
-	auto it = fake_to_real_iid.find(val);
-	if (it == fake_to_real_iid.end()) {
-		return val;
+	const IID* real = fake_to_real_iid.find(val);
+	return real ? *real : val;
+}
+
+// Hand the event to the analysis, either right away or through the event
+// buffer of the current thread.
+inline void dispatch(const Event& e) {
+	if (EventBuffer::enabled()) {
+		EventBuffer::local().push(e);
+	} else {
+		BlameAnalysis::get().process(&e, 1);
 	}
-	return it->second;
+}
+
+// The same for the records of one event with shadowed operands.
+inline void dispatch(const Event* e, size_t n) {
+	if (EventBuffer::enabled()) {
+		EventBuffer::local().push(e, n);
+	} else {
+		BlameAnalysis::get().process(e, n);
+	}
+}
+
+inline void fbinop(IID iid, IID l, IID r, double lo, double ro, FBINOP op) {
+	Event e;
+	e.kind = EVENT_FBINOP;
+	e.op = op;
+	e.iid = iid;
+	e.liid = translate_to_real(l);
+	e.riid = translate_to_real(r);
+	e.lv = lo;
+	e.rv = ro;
+	dispatch(e);
+}
+
+inline void call_lib(IID iid, IID operand, double operandValue, MATHFUNC func) {
+	Event e;
+	e.kind = EVENT_CALL_LIB;
+	e.op = func;
+	e.iid = iid;
+	e.liid = translate_to_real(operand);
+	e.riid = 0;
+	e.lv = operandValue;
+	e.rv = 0;
+	dispatch(e);
+}
+
+inline void fmemop(EVENT_KIND kind, IID iid, IID ptrIID, void* vptr) {
+	Event e;
+	e.kind = kind;
+	e.op = 0;
+	e.iid = iid;
+	e.liid = ptrIID;
+	e.riid = 0;
+	e.lv = 0;
+	e.ptr = vptr;
+	dispatch(e);
 }
 
 void llvm_fadd(IID iidf, double, IID l, double lo, IID r, double ro) {
-	l = translate_to_real(l);
-	r = translate_to_real(r);
-	BlameAnalysis::get().fadd(iidf, l, r, lo, ro);
+	fbinop(iidf, l, r, lo, ro, FADD);
 }
 
 void llvm_fsub(IID iidf, double, IID l, double lo, IID r, double ro) {
-	l = translate_to_real(l);
-	r = translate_to_real(r);
-	BlameAnalysis::get().fsub(iidf, l, r, lo, ro);
+	fbinop(iidf, l, r, lo, ro, FSUB);
 }
 
 void llvm_fmul(IID iidf, double, IID l, double lo, IID r, double ro) {
-	l = translate_to_real(l);
-	r = translate_to_real(r);
-	BlameAnalysis::get().fmul(iidf, l, r, lo, ro);
+	fbinop(iidf, l, r, lo, ro, FMUL);
 }
 
 void llvm_fdiv(IID iidf, double, IID l, double lo, IID r, double ro) {
-	l = translate_to_real(l);
-	r = translate_to_real(r);
-	BlameAnalysis::get().fdiv(iidf, l, r, lo, ro);
+	fbinop(iidf, l, r, lo, ro, FDIV);
 }
 
 void llvm_frem(IID, double, IID, double, IID, double) {
@@ -46,28 +91,23 @@ void llvm_frem(IID, double, IID, double, IID, double) {
 	//	BlameAnalysis::get().frem(iidf, l, r, lo, ro);
 }
 
-unordered_map<void*, IID> ptr_to_iid;
+AddressShadow<IID> ptr_to_iid;
 void llvm_fload(IID iidf, double, IID, void* vptr) {
-	int real_iid = ptr_to_iid[vptr];
+	const IID* writer = ptr_to_iid.find(vptr);
+	int real_iid = writer ? *writer : 0;
 	fake_to_real_iid[iidf] = real_iid;
-	if (BlameAnalysis::get().trace_ptr.find({vptr, real_iid}) != BlameAnalysis::get().trace_ptr.end()) {
-		BlameAnalysis::get().trace[real_iid] = BlameAnalysis::get().trace_ptr[ {vptr, real_iid}];
-	}
-	else {
-		BlameAnalysis::get().trace.erase(iidf);
-	}
+	fmemop(EVENT_FLOAD, iidf, real_iid, vptr);
 	// BlameAnalysis::get().load(iidf, input, value);
 }
 
 void llvm_fstore(IID iidV, double, IID, void* vptr) {
 	if (iidV >= 0) {
 		ptr_to_iid[vptr] = iidV;
-		if (BlameAnalysis::get().trace.find(iidV) != BlameAnalysis::get().trace.end()) {
-			BlameAnalysis::get().trace_ptr[ {vptr, iidV}] = BlameAnalysis::get().trace[iidV];
-		}
+		fmemop(EVENT_FSTORE, iidV, iidV, vptr);
 	} else {
-		assert(arg_to_real_iid.find(-iidV) != arg_to_real_iid.end());
-		ptr_to_iid[vptr] = fake_to_real_iid[arg_to_real_iid[-iidV]];
+		const Binding* arg = call_stack.arg(-iidV);
+		assert(arg && "Argument was not passed by an instrumented call.");
+		ptr_to_iid[vptr] = arg->iid;
 	}
 	//	BlameAnalysis::get().store(iidV, ptr, value);
 }
@@ -78,47 +118,121 @@ void llvm_fphi(IID out, double, IID in) {
 
 // ***** Other Operations ***** //
 void llvm_call_fabs(IID iidf, double, IID operand, double operandValue) {
-	operand = translate_to_real(operand);
-	BlameAnalysis::get().call_fabs(iidf, operand, operandValue);
+	call_lib(iidf, operand, operandValue, FABS);
 }
 
 void llvm_call_exp(IID iidf, double, IID operand, double operandValue) {
-	operand = translate_to_real(operand);
-	BlameAnalysis::get().call_exp(iidf, operand, operandValue);
+	call_lib(iidf, operand, operandValue, EXP);
 }
 void llvm_call_sqrt(IID iidf, double, IID operand, double operandValue) {
-	operand = translate_to_real(operand);
-	BlameAnalysis::get().call_sqrt(iidf, operand, operandValue);
+	call_lib(iidf, operand, operandValue, SQRT);
 }
 void llvm_call_log(IID iidf, double, IID operand, double operandValue) {
-	operand = translate_to_real(operand);
-	BlameAnalysis::get().call_log(iidf, operand, operandValue);
+	call_lib(iidf, operand, operandValue, LOG);
 }
 void llvm_call_sin(IID iidf, double, IID operand, double operandValue) {
-	operand = translate_to_real(operand);
-	BlameAnalysis::get().call_sin(iidf, operand, operandValue);
+	call_lib(iidf, operand, operandValue, SIN);
 }
 void llvm_call_acos(IID iidf, double, IID operand, double operandValue) {
-	operand = translate_to_real(operand);
-	BlameAnalysis::get().call_acos(iidf, operand, operandValue);
+	call_lib(iidf, operand, operandValue, ACOS);
 }
 void llvm_call_cos(IID iidf, double, IID operand, double operandValue) {
-	operand = translate_to_real(operand);
-	BlameAnalysis::get().call_cos(iidf, operand, operandValue);
+	call_lib(iidf, operand, operandValue, COS);
 }
 void llvm_call_floor(IID iidf, double, IID operand, double operandValue) {
-	operand = translate_to_real(operand);
-	BlameAnalysis::get().call_floor(iidf, operand, operandValue);
+	call_lib(iidf, operand, operandValue, FLOOR);
+}
+
+void llvm_push_frame(void* callee) {
+	call_stack.push(callee);
+}
+
+void llvm_pop_frame() {
+	call_stack.pop();
 }
 
 void llvm_arg(unsigned argInx, IID iid) {
-	arg_to_real_iid[argInx] = iid;
+	call_stack.bindArg(argInx, translate_to_real(iid));
 }
 
-void llvm_return(IID iid) {
-	return_iid = iid;
+void llvm_return(void* function, IID iid) {
+	call_stack.bindReturn(function, translate_to_real(iid));
 }
 
 void llvm_after_call(IID iid) {
-	fake_to_real_iid[iid] = fake_to_real_iid[return_iid];
+	const Binding& ret = call_stack.top().ret;
+	if (ret.bound) {
+		fake_to_real_iid[iid] = ret.iid;
+	} else {
+		fake_to_real_iid.erase(iid);
+	}
+}
+
+// ***** Inline Shadow Operations ***** //
+
+// Created on first use, so that instrumented code run by static
+// constructors, before this file is initialized, finds it.
+AddressShadow<StoredShadow>& shadow_memory() {
+	static AddressShadow<StoredShadow> memory;
+	return memory;
+}
+
+thread_local StoredShadow llvm_shadow_args[LLVM_SHADOW_ARGS];
+thread_local StoredShadow llvm_shadow_ret;
+const StoredShadow llvm_shadow_none = StoredShadow();
+
+StoredShadow* const* llvm_shadow_pages() {
+	return shadow_memory().pages();
+}
+
+StoredShadow* llvm_shadow_slot(void* location) {
+	return &shadow_memory()[location];
+}
+
+// The leading record of an event with shadowed operands, see Event.
+inline Event blame_event(EVENT_KIND kind, int op, IID iid, IID l, double lo, IID r, double ro) {
+	Event e;
+	e.kind = kind;
+	e.op = op;
+	e.iid = iid;
+	e.liid = l;
+	e.riid = r;
+	e.lv = lo;
+	e.rv = ro;
+	return e;
+}
+
+inline Event shadow_event(IID iid, float f, double b19, double b27) {
+	Event e;
+	e.kind = EVENT_SHADOW;
+	e.op = 0;
+	e.iid = iid;
+	e.liid = 0;
+	e.f = f;
+	e.lv = b19;
+	e.rv = b27;
+	return e;
+}
+
+void llvm_fblame(IID iidf, int op, IID l, float lf, double l19, double l27, double lo, IID r, float rf, double r19,
+				 double r27, double ro) {
+	const Event e[] = {blame_event(EVENT_FBLAME, op, iidf, l, lo, r, ro), shadow_event(l, lf, l19, l27),
+					   shadow_event(r, rf, r19, r27)
+					  };
+	dispatch(e, 3);
+}
+
+void llvm_fblame_call(IID iidf, int func, IID operand, float f, double b19, double b27, double operandValue) {
+	const Event e[] = {blame_event(EVENT_FBLAME_CALL, func, iidf, operand, operandValue, 0, 0),
+					   shadow_event(operand, f, b19, b27)
+					  };
+	dispatch(e, 2);
+}
+
+void llvm_fblame_fcmp(IID iidf, int op, IID l, float lf, double l19, double l27, double lo, IID r, float rf,
+					  double r19, double r27, double ro) {
+	const Event e[] = {blame_event(EVENT_FCMP, op, iidf, l, lo, r, ro), shadow_event(l, lf, l19, l27),
+					   shadow_event(r, rf, r19, r27)
+					  };
+	dispatch(e, 3);
 }
@@ -24,8 +24,49 @@ extern "C" {
 	void llvm_call_cos(IID iidf, double output, IID operand, double operandValue);
 	void llvm_call_floor(IID iidf, double output, IID operand, double operandValue);
 
+	// ***** Inline Shadow Operations ***** //
+	// Used by FPPass -inline-shadow. The instrumented code reads and writes the
+	// StoredShadow slots below directly; their layout matches the slot struct
+	// of the pass. A slot is only valid while value is unchanged, otherwise the
+	// value was written without instrumentation and gets a fresh shadow.
+	// writer is the IID of the shadowed instruction + 1, and 0 in an empty
+	// slot, so that a zeroed page holds no shadow; that keeps a slot at 32
+	// bytes, the size of MemoryShadow.
+	struct StoredShadow {
+		IID writer;
+		float f;
+		double b19;
+		double b27;
+		double value;
+	};
+
+	static_assert(sizeof(StoredShadow) == 32, "StoredShadow does not match the slot struct of FPPass.");
+
+	// Slots of the floating-point arguments of the call being made and of the
+	// value being returned. The callee and the caller clear writer once they
+	// have read the slot.
+	const unsigned LLVM_SHADOW_ARGS = 16;
+	extern thread_local StoredShadow llvm_shadow_args[LLVM_SHADOW_ARGS];
+	extern thread_local StoredShadow llvm_shadow_ret;
+
+	// Pages of the shadow memory, see AddressShadow, and the slot read where
+	// no page exists yet.
+	StoredShadow* const* llvm_shadow_pages();
+	extern const StoredShadow llvm_shadow_none;
+
+	// The slot of location, materializing its page.
+	StoredShadow* llvm_shadow_slot(void* location);
+
+	void llvm_fblame(IID iidf, int op, IID l, float lf, double l19, double l27, double lo, IID r, float rf, double r19,
+					 double r27, double ro);
+	void llvm_fblame_call(IID iidf, int func, IID operand, float f, double b19, double b27, double operandValue);
+	void llvm_fblame_fcmp(IID iidf, int op, IID l, float lf, double l19, double l27, double lo, IID r, float rf,
+						  double r19, double r27, double ro);
+
 	// ***** Other Operations ***** //
+	void llvm_push_frame(void* callee);
+	void llvm_pop_frame();
 	void llvm_arg(unsigned argInx, IID iid);
-	void llvm_return(IID iid);
+	void llvm_return(void* function, IID iid);
 	void llvm_after_call(IID iid);
 }
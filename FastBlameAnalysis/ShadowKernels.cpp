@@ -0,0 +1,297 @@
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SHADOW_KERNELS_X86
+// AVX-512 intrinsics in target("avx512f") functions need a recent compiler.
+#if (defined(__clang__) && (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 9))) || \
+	(!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 5)
+#define SHADOW_KERNELS_AVX512
+#endif
+#endif
+
+#include "ShadowKernels.h"
+
+namespace {
+
+// Mask of the mantissa bits kept at precision p.
+inline int64_t precisionMask(PRECISION p) {
+	return (int64_t)(~0ull << (DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]));
+}
+
+typedef void (*BinopKernel)(const HIGHPRECISION*, const HIGHPRECISION*, FBINOP, HIGHPRECISION*);
+typedef void (*ClearKernel)(HIGHPRECISION*);
+
+// c[i * PRECISION_NO + j] = l[i] op r[j], rounded to precision p.
+typedef void (*PairsKernel)(const HIGHPRECISION*, const HIGHPRECISION*, FBINOP, PRECISION, HIGHPRECISION*);
+
+// The blame search, see blameMask.
+typedef PairMask (*BlameKernel)(HIGHPRECISION, const HIGHPRECISION*, const HIGHPRECISION*, FBINOP, PRECISION);
+
+// The blame search over the candidates of a pairs kernel.
+template <PairsKernel pairs>
+PairMask blameKernel(HIGHPRECISION result, const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op, PRECISION p) {
+	HIGHPRECISION candidates[PRECISION_NO * PRECISION_NO];
+	pairs(l, r, op, p, candidates);
+	return equalMask(result, candidates, PRECISION_NO * PRECISION_NO, p);
+}
+
+/*** Scalar ***/
+
+void binopScalar(const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op, HIGHPRECISION* values) {
+	for (PRECISION p = PRECISION(BITS_FLOAT + 1); p < PRECISION_NO; p = PRECISION(p + 1)) {
+		values[p] = clearBits(feval<HIGHPRECISION>(l[p], r[p], op), DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]);
+	}
+}
+
+void clearScalar(HIGHPRECISION* values) {
+	for (PRECISION p = PRECISION(BITS_FLOAT + 1); p < PRECISION_NO; p = PRECISION(p + 1)) {
+		values[p] = clearBits(values[p], DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]);
+	}
+}
+
+void pairsScalar(const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op, PRECISION p, HIGHPRECISION* c) {
+	pairCandidates(l, r, op, p, c);
+}
+
+#ifdef SHADOW_KERNELS_X86
+
+/*** SSE2 ***/
+//
+// Two vectors of two precisions each. The BITS_FLOAT lane is computed
+// along and overwritten by the caller.
+
+inline __m128d clearSSE2(__m128d v, __m128d mask) {
+	// NaN and infinity are kept as they are, as in clearBits
+	const __m128d inf = _mm_set1_pd(INFINITY);
+	const __m128d sign = _mm_set1_pd(-0.0);
+	__m128d special = _mm_or_pd(_mm_cmpunord_pd(v, v), _mm_cmpeq_pd(_mm_andnot_pd(sign, v), inf));
+	return _mm_or_pd(_mm_and_pd(special, v), _mm_andnot_pd(special, _mm_and_pd(v, mask)));
+}
+
+inline __m128d binopSSE2(__m128d l, __m128d r, FBINOP op) {
+	switch (op) {
+		case FADD:
+			return _mm_add_pd(l, r);
+		case FSUB:
+			return _mm_sub_pd(l, r);
+		case FMUL:
+			return _mm_mul_pd(l, r);
+		case FDIV:
+			return _mm_div_pd(l, r);
+		default:
+			assert(false && "Unsuppored floating-point binary operator.");
+	}
+	return l;
+}
+
+void binopKernelSSE2(const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op, HIGHPRECISION* values) {
+	const __m128d mask01 = _mm_castsi128_pd(_mm_set_epi64x(precisionMask(BITS_19), -1));
+	const __m128d mask23 = _mm_castsi128_pd(_mm_set_epi64x(precisionMask(BITS_DOUBLE), precisionMask(BITS_27)));
+	__m128d v01 = binopSSE2(_mm_loadu_pd(l), _mm_loadu_pd(r), op);
+	__m128d v23 = binopSSE2(_mm_loadu_pd(l + 2), _mm_loadu_pd(r + 2), op);
+	_mm_storeu_pd(values, clearSSE2(v01, mask01));
+	_mm_storeu_pd(values + 2, clearSSE2(v23, mask23));
+}
+
+void clearKernelSSE2(HIGHPRECISION* values) {
+	const __m128d mask01 = _mm_castsi128_pd(_mm_set_epi64x(precisionMask(BITS_19), -1));
+	const __m128d mask23 = _mm_castsi128_pd(_mm_set_epi64x(precisionMask(BITS_DOUBLE), precisionMask(BITS_27)));
+	_mm_storeu_pd(values, clearSSE2(_mm_loadu_pd(values), mask01));
+	_mm_storeu_pd(values + 2, clearSSE2(_mm_loadu_pd(values + 2), mask23));
+}
+
+void pairsKernelSSE2(const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op, PRECISION p, HIGHPRECISION* c) {
+	const __m128d mask = _mm_castsi128_pd(_mm_set1_epi64x(precisionMask(p)));
+	__m128d r01 = _mm_loadu_pd(r);
+	__m128d r23 = _mm_loadu_pd(r + 2);
+	for (unsigned i = 0; i < PRECISION_NO; i++) {
+		__m128d li = _mm_set1_pd(l[i]);
+		_mm_storeu_pd(c + i * PRECISION_NO, clearSSE2(binopSSE2(li, r01, op), mask));
+		_mm_storeu_pd(c + i * PRECISION_NO + 2, clearSSE2(binopSSE2(li, r23, op), mask));
+	}
+}
+
+/*** AVX ***/
+//
+// All four precisions in one vector.
+
+__attribute__((target("avx"))) inline __m256d clearAVX(__m256d v, __m256d mask) {
+	const __m256d inf = _mm256_set1_pd(INFINITY);
+	const __m256d sign = _mm256_set1_pd(-0.0);
+	__m256d special = _mm256_or_pd(_mm256_cmp_pd(v, v, _CMP_UNORD_Q),
+								   _mm256_cmp_pd(_mm256_andnot_pd(sign, v), inf, _CMP_EQ_OQ));
+	return _mm256_blendv_pd(_mm256_and_pd(v, mask), v, special);
+}
+
+__attribute__((target("avx"))) inline __m256d precisionMasksAVX() {
+	return _mm256_castsi256_pd(
+			   _mm256_set_epi64x(precisionMask(BITS_DOUBLE), precisionMask(BITS_27), precisionMask(BITS_19), -1));
+}
+
+__attribute__((target("avx"))) inline __m256d binopAVX(__m256d l, __m256d r, FBINOP op) {
+	switch (op) {
+		case FADD:
+			return _mm256_add_pd(l, r);
+		case FSUB:
+			return _mm256_sub_pd(l, r);
+		case FMUL:
+			return _mm256_mul_pd(l, r);
+		case FDIV:
+			return _mm256_div_pd(l, r);
+		default:
+			assert(false && "Unsuppored floating-point binary operator.");
+	}
+	return l;
+}
+
+__attribute__((target("avx"))) void binopKernelAVX(const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op,
+		HIGHPRECISION* values) {
+	__m256d v = binopAVX(_mm256_loadu_pd(l), _mm256_loadu_pd(r), op);
+	_mm256_storeu_pd(values, clearAVX(v, precisionMasksAVX()));
+}
+
+__attribute__((target("avx"))) void pairsKernelAVX(const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op,
+		PRECISION p, HIGHPRECISION* c) {
+	const __m256d mask = _mm256_castsi256_pd(_mm256_set1_epi64x(precisionMask(p)));
+	__m256d rv = _mm256_loadu_pd(r);
+	for (unsigned i = 0; i < PRECISION_NO; i++) {
+		_mm256_storeu_pd(c + i * PRECISION_NO, clearAVX(binopAVX(_mm256_set1_pd(l[i]), rv, op), mask));
+	}
+}
+
+__attribute__((target("avx"))) void clearKernelAVX(HIGHPRECISION* values) {
+	_mm256_storeu_pd(values, clearAVX(_mm256_loadu_pd(values), precisionMasksAVX()));
+}
+
+#endif
+
+#ifdef SHADOW_KERNELS_AVX512
+
+/*** AVX-512 ***/
+//
+// The operations on one shadow object take four lanes, one AVX vector, and
+// stay on AVX: a wider vector would only hold lanes of other objects. The
+// blame search takes all sixteen pairs of precisions, two rows of the pair
+// matrix per vector, and compares the candidates into mask registers
+// without storing them.
+
+__attribute__((target("avx512f"))) inline __m512d clearAVX512(__m512d v, __m512i mask) {
+	const __m512i abs = _mm512_set1_epi64(0x7fffffffffffffffll);
+	__m512d magnitude = _mm512_castsi512_pd(_mm512_and_epi64(_mm512_castpd_si512(v), abs));
+	__mmask8 special =
+		_mm512_cmp_pd_mask(v, v, _CMP_UNORD_Q) | _mm512_cmp_pd_mask(magnitude, _mm512_set1_pd(INFINITY), _CMP_EQ_OQ);
+	__m512d cleared = _mm512_castsi512_pd(_mm512_and_epi64(_mm512_castpd_si512(v), mask));
+	return _mm512_mask_blend_pd(special, cleared, v);
+}
+
+__attribute__((target("avx512f"))) inline __m512d binopAVX512(__m512d l, __m512d r, FBINOP op) {
+	switch (op) {
+		case FADD:
+			return _mm512_add_pd(l, r);
+		case FSUB:
+			return _mm512_sub_pd(l, r);
+		case FMUL:
+			return _mm512_mul_pd(l, r);
+		case FDIV:
+			return _mm512_div_pd(l, r);
+		default:
+			assert(false && "Unsuppored floating-point binary operator.");
+	}
+	return l;
+}
+
+// equalMask over the eight candidates of c.
+__attribute__((target("avx512f"))) inline __mmask8 equalMaskAVX512(HIGHPRECISION result, __m512d c, PRECISION p) {
+	if (std::isnan(result)) {
+		return _mm512_cmp_pd_mask(c, c, _CMP_UNORD_Q);
+	}
+	if (std::isinf(result)) {
+		const __m512i abs = _mm512_set1_epi64(0x7fffffffffffffffll);
+		__m512d magnitude = _mm512_castsi512_pd(_mm512_and_epi64(_mm512_castpd_si512(c), abs));
+		return _mm512_cmp_pd_mask(magnitude, _mm512_set1_pd(INFINITY), _CMP_EQ_OQ);
+	}
+	if (p == BITS_DOUBLE) {
+		return _mm512_cmp_pd_mask(c, _mm512_set1_pd(result), _CMP_EQ_OQ);
+	}
+	// comparedMantissa of every lane; the zero-masked shifts, with all lanes
+	// selected, have no undefined pass-through operand
+	const __mmask8 all = 0xff;
+	unsigned drop = DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p] - 1;
+	__m512i bits = _mm512_maskz_slli_epi64(all, _mm512_castpd_si512(c), DOUBLE_EXPONENT_LENGTH + 1);
+	__m512i mantissa = _mm512_maskz_sra_epi64(all, bits, _mm_cvtsi32_si128(DOUBLE_EXPONENT_LENGTH + 1 + drop));
+	// the mantissas differ by at most one
+	__m512i d = _mm512_sub_epi64(mantissa, _mm512_set1_epi64(comparedMantissa(result, drop) - 1));
+	return _mm512_cmple_epu64_mask(d, _mm512_set1_epi64(2));
+}
+
+__attribute__((target("avx512f"))) PairMask blameKernelAVX512(HIGHPRECISION result, const HIGHPRECISION* l,
+		const HIGHPRECISION* r, FBINOP op, PRECISION p) {
+	const __m512i mask = _mm512_set1_epi64(precisionMask(p));
+	// r in both halves, through the zero-masked broadcast: the plain one
+	// passes an undefined operand, which -Wall reports as uninitialized
+	__m512d rv = _mm512_maskz_broadcast_f64x4(0xff, _mm256_loadu_pd(r));
+	PairMask pairs = 0;
+	for (unsigned i = 0; i < PRECISION_NO; i += 2) {
+		__m512d li = _mm512_set_pd(l[i + 1], l[i + 1], l[i + 1], l[i + 1], l[i], l[i], l[i], l[i]);
+		__m512d c = clearAVX512(binopAVX512(li, rv, op), mask);
+		pairs |= PairMask(equalMaskAVX512(result, c, p)) << (i * PRECISION_NO);
+	}
+	return pairs;
+}
+
+#endif
+
+// The implementations picked for this CPU.
+struct Kernels {
+	BinopKernel binop;
+	ClearKernel clear;
+	BlameKernel blame;
+};
+
+Kernels selectKernels() {
+#ifdef SHADOW_KERNELS_X86
+	__builtin_cpu_init();
+#ifdef SHADOW_KERNELS_AVX512
+	if (__builtin_cpu_supports("avx512f")) {
+		return Kernels{binopKernelAVX, clearKernelAVX, blameKernelAVX512};
+	}
+#endif
+	if (__builtin_cpu_supports("avx")) {
+		return Kernels{binopKernelAVX, clearKernelAVX, blameKernel<pairsKernelAVX>};
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return Kernels{binopKernelSSE2, clearKernelSSE2, blameKernel<pairsKernelSSE2>};
+	}
+#endif
+	return Kernels{binopScalar, clearScalar, blameKernel<pairsScalar>};
+}
+
+// Selected once, by a thread-safe static initializer that also covers calls
+// from the static constructors of other files, and never changed after.
+inline const Kernels& kernels() {
+	static const Kernels selected = selectKernels();
+	return selected;
+}
+}
+
+void shadowRound(HIGHPRECISION v, HIGHPRECISION* values) {
+	for (PRECISION p = BITS_FLOAT; p < PRECISION_NO; p = PRECISION(p + 1)) {
+		values[p] = v;
+	}
+	kernels().clear(values);
+	values[BITS_FLOAT] = (LOWPRECISION)v;
+}
+
+void shadowBinop(const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op, HIGHPRECISION* values) {
+	kernels().binop(l, r, op, values);
+	values[BITS_FLOAT] = feval<LOWPRECISION>(l[BITS_FLOAT], r[BITS_FLOAT], op);
+}
+
+void shadowClear(HIGHPRECISION* values) {
+	kernels().clear(values);
+}
+
+PairMask blameMask(HIGHPRECISION result, const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op, PRECISION p) {
+	return kernels().blame(result, l, r, op, p);
+}
@@ -0,0 +1,34 @@
+#ifndef _SHADOW_KERNELS_H_
+#define _SHADOW_KERNELS_H_
+
+#include "BlameUtilities.h"
+#include "PrecisionPairs.h"
+
+// Kernels that compute a value at all precisions of a shadow object at once.
+// BITS_FLOAT is computed in float; every other precision is computed in
+// double and rounded with clearBits to PRECISION_BITS. The double precisions
+// are evaluated and masked as one vector. The implementation (AVX-512 for
+// the blame search, AVX, SSE2 or a scalar loop) is picked from the CPU
+// features once, on first use, and fixed after. Math library calls are
+// evaluated one precision at a time by the caller.
+
+// The vector layouts hold one shadow object in four lanes.
+static_assert(PRECISION_NO == 4, "The shadow kernels handle four precisions.");
+
+// The shadow of a value without shadow: v at every precision.
+void shadowRound(HIGHPRECISION v, HIGHPRECISION* values);
+
+// values[p] = l[p] op r[p], at every precision p.
+void shadowBinop(const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op, HIGHPRECISION* values);
+
+// Round values[p] to precision p for every precision but BITS_FLOAT, in
+// place.
+void shadowClear(HIGHPRECISION* values);
+
+// Blame search over all pairs of operand precisions in one batch: bit
+// i * PRECISION_NO + j of the result is set when l[i] op r[j], rounded to p,
+// equals result within precision p. The lowest set bit is the first pair
+// in (i, j) order, see firstPair.
+PairMask blameMask(HIGHPRECISION result, const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op, PRECISION p);
+
+#endif
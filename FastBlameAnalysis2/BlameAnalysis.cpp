@@ -1,10 +1,11 @@
 #include "BlameAnalysis.h"
+#include "PrecisionPairs.h"
 using namespace std;
 
 /*** HELPER FUNCTIONS ***/
 
 std::unordered_map<IID, DebugInfo> BlameAnalysis::readDebugInfo() {
-	ifstream fin("debug.bin");
+	ifstream fin(debugFile("debug.bin"));
 	std::unordered_map<IID, DebugInfo> debugInfoMap;
 	while (fin) {
 		IID id;
@@ -30,21 +31,22 @@ std::string BlameAnalysis::get_selfpath() {
 
 
 const BlameShadowObject BlameAnalysis::getShadowObject(IID iid, HIGHPRECISION v) {
-	if (trace.find(iid) == trace.end()) {
+	const BlameShadowObject* BSO = trace.find(iid);
+	if (BSO == nullptr) {
 		//    cout << "IID: " << iid << " is a constant." << endl;
 		return BlameShadowObject(iid, (LOWPRECISION)v, v);
 	}
 
-	if (trace[iid][0].highValue != v) {
+	if (BSO->highValue != v) {
 		cout << "Get Shadow" << endl;
 		cout << iid << endl;
-		cout << setprecision(10) << trace[iid][0].highValue << endl;
+		cout << setprecision(10) << BSO->highValue << endl;
 		cout << setprecision(10) << v << endl;
 		cout << "----" << endl;
 		exit(5);
 	}
 
-	return trace[iid][0];
+	return *BSO;
 }
 
 const BlameShadowObject BlameAnalysis::shadowFEval(IID iid, const BlameShadowObject& lBSO,
@@ -100,8 +102,8 @@ BlameNode BlameAnalysis::computeBlameInformation(const BlameShadowObject& BSO, c
 	}
 
 	// Compute the minimal blame information.
-	PRECISION min_i =
-		blameSummary.find(BSO.id) != blameSummary.end() ? blameSummary[BSO.id][p].children[0].precision : BITS_FLOAT;
+	const std::array<BlameNode, PRECISION_NO>* summary = blameSummary.find(BSO.id);
+	PRECISION min_i = summary ? (*summary)[p].children[0].precision : BITS_FLOAT;
 
 	// Try all i to find the blame that works.
 	PRECISION i;
@@ -134,34 +136,25 @@ BlameNode BlameAnalysis::computeBlameInformation(const BlameShadowObject& BSO, c
 	}
 
 	// Compute the minimal blame information.
-	bool found = false;
 	PRECISION min_i = BITS_FLOAT;
 	PRECISION min_j = BITS_FLOAT;
-	if (blameSummary.find(BSO.id) != blameSummary.end()) {
-		BlameNode& bn = blameSummary[BSO.id][p];
+	if (const std::array<BlameNode, PRECISION_NO>* summary = blameSummary.find(BSO.id)) {
+		const BlameNode& bn = (*summary)[p];
 		min_i = bn.children[0].precision;
 		min_j = bn.children[1].precision;
 	}
 
-	PRECISION i = min_i;
-	PRECISION j = min_j;
-	// Try all combination of i and j to find the blame that works.
-	for (i = min_i; i < PRECISION_NO; i = PRECISION(i + 1)) {
-		for (j = min_j; j < PRECISION_NO; j = PRECISION(j + 1)) {
-			if (!canBlame(val, lbsoVals[i], rbsoVals[j], op, p)) {
-				continue;
-			}
-
-			found = true;
-			requireHigherPrecisionOperator = isRequiredHigherPrecisionOperator(val, lbsoVals[i], rbsoVals[j], op, p);
-			break;
-		}
-		if (found) {
-			break;
-		}
+	// Try all combination of i and j in one batch; the first one that works
+	// is the lowest bit set. Without one, the operands are blamed at double
+	// precision.
+	HIGHPRECISION candidates[PRECISION_NO * PRECISION_NO];
+	pairCandidates(lbsoVals.data(), rbsoVals.data(), op, p, candidates);
+	PairMask pass = equalMask(val, candidates, PRECISION_NO * PRECISION_NO, p) & precisionPairs(min_i, min_j);
+	PRECISION i, j;
+	if (firstPair(pass, i, j)) {
+		requireHigherPrecisionOperator = isRequiredHigherPrecisionOperator(val, lbsoVals[i], rbsoVals[j], op, p);
 	}
 
-	assert(found && "Minimal blames cannot be found!");
 	return BlameNode(BSO.id, p, requireHigherPrecision, requireHigherPrecisionOperator,
 	{BlameNodeID(lBSO.id, i), BlameNodeID(rBSO.id, j)});
 }
@@ -186,8 +179,8 @@ BlameNode BlameAnalysis::computeBlameInformation(const BlameShadowObject& BSO, c
 	bool found = false;
 	PRECISION min_i = BITS_FLOAT;
 	PRECISION min_j = BITS_FLOAT;
-	if (blameSummary.find(BSO.id) != blameSummary.end()) {
-		BlameNode& bn = blameSummary[BSO.id][p];
+	if (const std::array<BlameNode, PRECISION_NO>* summary = blameSummary.find(BSO.id)) {
+		const BlameNode& bn = (*summary)[p];
 		min_i = bn.children[0].precision;
 		min_j = bn.children[1].precision;
 	}
@@ -215,12 +208,6 @@ BlameNode BlameAnalysis::computeBlameInformation(const BlameShadowObject& BSO, c
 	{BlameNodeID(lBSO.id, i), BlameNodeID(rBSO.id, j)});
 }
 
-inline bool BlameAnalysis::canBlame(HIGHPRECISION result, HIGHPRECISION lop, HIGHPRECISION rop, FBINOP op,
-									PRECISION p) {
-	return equalWithinPrecision(
-			   result, clearBits(feval<HIGHPRECISION>(lop, rop, op), DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]), p);
-}
-
 inline bool BlameAnalysis::canBlame(HIGHPRECISION result, HIGHPRECISION arg, MATHFUNC func, PRECISION p) {
 	return equalWithinPrecision(
 			   result, clearBits(mathLibEval<HIGHPRECISION>(arg, func), DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]), p);
@@ -232,13 +219,22 @@ bool BlameAnalysis::isRequiredHigherPrecisionOperator(HIGHPRECISION result, HIGH
 			   result, clearBits(feval<LOWPRECISION>(lop, rop, op), DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]), p);
 }
 
-inline void BlameAnalysis::copyShadowObject(IID dstIID, void* dstPtr, IID srcIID, void* srcPtr, double v) {
-	if (trace.find(srcIID) != trace.end() && trace[srcIID].find(srcPtr) != trace[srcIID].end()) {
-		BlameShadowObject bso = trace[srcIID][srcPtr];
-		trace[dstIID][dstPtr] = BlameShadowObject(dstIID, bso.lowValue, bso.highValue);
+inline void BlameAnalysis::copyShadowObject(IID dstIID, IID srcIID, void* srcPtr, double v) {
+	LOWPRECISION low = (LOWPRECISION)v;
+	HIGHPRECISION high = v;
+	if (srcPtr == nullptr) {
+		if (const BlameShadowObject* bso = trace.find(srcIID)) {
+			low = bso->lowValue;
+			high = bso->highValue;
+		}
 	} else {
-		trace[dstIID][dstPtr] = BlameShadowObject(dstIID, (LOWPRECISION)v, v);
+		const MemoryShadow* shadow = memory.find(srcPtr);
+		if (shadow && shadow->stored && shadow->iid == srcIID) {
+			low = shadow->lowValue;
+			high = shadow->highValue;
+		}
 	}
+	trace[dstIID] = BlameShadowObject(dstIID, low, high);
 }
 
 inline void BlameAnalysis::copyBlameSummary(IID dest, IID src) {
@@ -247,18 +243,21 @@ inline void BlameAnalysis::copyBlameSummary(IID dest, IID src) {
 
 inline void BlameAnalysis::computeDivergeNode(const BlameShadowObject& lBSO, const BlameShadowObject& rBSO, CMPOP op) {
 	bool truthVal = fcmp_eval<HIGHPRECISION>(lBSO.highValue, rBSO.highValue, op);
-	for (PRECISION i = BITS_FLOAT; i < PRECISION_NO; i = PRECISION(i + 1)) {
-		for (PRECISION j = BITS_FLOAT; j < PRECISION_NO; j = PRECISION(j + 1)) {
-			double left =
-				(i != BITS_FLOAT) ? clearBits(lBSO.highValue, DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[i]) : lBSO.lowValue;
-			double right =
-				(j != BITS_FLOAT) ? clearBits(rBSO.highValue, DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[j]) : rBSO.lowValue;
-			if (fcmp_eval<HIGHPRECISION>(left, right, op) == truthVal) {
-				diverge.insert(BlameNodeID(lBSO.id, i));
-				diverge.insert(BlameNodeID(rBSO.id, j));
-				return;
-			}
-		}
+	std::array<HIGHPRECISION, PRECISION_NO> left;
+	std::array<HIGHPRECISION, PRECISION_NO> right;
+	left[BITS_FLOAT] = lBSO.lowValue;
+	right[BITS_FLOAT] = rBSO.lowValue;
+	for (PRECISION i = PRECISION(BITS_FLOAT + 1); i < PRECISION_NO; i = PRECISION(i + 1)) {
+		left[i] = clearBits(lBSO.highValue, DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[i]);
+		right[i] = clearBits(rBSO.highValue, DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[i]);
+	}
+
+	// All combinations in one batch; the first one that agrees with the
+	// double precision outcome is the lowest bit set.
+	PRECISION i, j;
+	if (firstPair(fcmpMask(left.data(), right.data(), op, truthVal), i, j)) {
+		diverge.insert(BlameNodeID(lBSO.id, i));
+		diverge.insert(BlameNodeID(rBSO.id, j));
 	}
 }
 
@@ -312,7 +311,7 @@ void BlameAnalysis::fbinop(IID iid, IID liid, IID riid, HIGHPRECISION lv, HIGHPR
 	}
 
 	assert(BSO.highValue == feval<HIGHPRECISION>(lv, rv, op));
-	trace[iid][0] = BSO;
+	trace[iid] = BSO;
 	computeBlameSummary(BSO, lBSO, rBSO, op);
 }
 
@@ -322,7 +321,7 @@ void BlameAnalysis::call_lib(IID iid, IID argiid, HIGHPRECISION argv, MATHFUNC f
 	}
 	const BlameShadowObject argBSO = getShadowObject(argiid, argv);
 	const BlameShadowObject BSO = shadowFEval(iid, argBSO, func);
-	trace[iid][0] = BSO;
+	trace[iid] = BSO;
 	computeBlameSummary(BSO, argBSO, func);
 }
 
@@ -336,7 +335,7 @@ void BlameAnalysis::call_pow(IID iid, IID argiid01, HIGHPRECISION argv01, IID ar
 	// shadow function eval
 	const BlameShadowObject BSO =
 		BlameShadowObject(iid, pow(argBSO01.lowValue, argBSO02.lowValue), pow(argBSO01.highValue, argBSO02.highValue));
-	trace[iid][0] = BSO;
+	trace[iid] = BSO;
 
 	// compute blame summary
 	std::array<BlameNode, PRECISION_NO> blames;
@@ -416,8 +415,12 @@ void BlameAnalysis::fstore(IID iidV, IID, void* vptr) {
 	//  if (!startTrack(iid)) {
 	//    return;
 	//  }
-	if (trace.find(iidV) != trace.end()) {
-		trace[iidV][vptr] = trace[iidV][0];
+	if (const BlameShadowObject* bso = trace.find(iidV)) {
+		MemoryShadow& shadow = memory[vptr];
+		shadow.iid = iidV;
+		shadow.stored = true;
+		shadow.lowValue = bso->lowValue;
+		shadow.highValue = bso->highValue;
 	}
 }
 
@@ -425,7 +428,7 @@ void BlameAnalysis::fload(IID iidV, double v, IID iid, void* vptr) {
 	//  if (!startTrack(iidV)) {
 	//    return;
 	//  }
-	copyShadowObject(iidV, 0, iid, vptr, v);
+	copyShadowObject(iidV, iid, vptr, v);
 	copyBlameSummary(iidV, iid);
 }
 
@@ -433,7 +436,7 @@ void BlameAnalysis::fphi(IID out, double v, IID in) {
 	if (!startTrack(out)) {
 		return;
 	}
-	copyShadowObject(out, 0, in, 0, v);
+	copyShadowObject(out, in, nullptr, v);
 	copyBlameSummary(out, in);
 }
 
@@ -441,17 +444,19 @@ void BlameAnalysis::fafter_call(IID iid, double v, IID return_id) {
 	if (!startTrack(iid)) {
 		return;
 	}
-	copyShadowObject(iid, 0, return_id, 0, v);
+	copyShadowObject(iid, return_id, nullptr, v);
 	copyBlameSummary(iid, return_id);
 }
 
 void BlameAnalysis::dumpTrace() {
 	std::ofstream tracefile;
 	tracefile.open(_selfpath + ".trace");
-	for (auto& it : trace) {
-		IID iid = it.first;
+	for (IID iid = 0; iid < trace.size(); iid++) {
+		if (!trace.contains(iid)) {
+			continue;
+		}
 		DebugInfo dbg = debugInfoMap.at(iid);
-		BlameShadowObject bso = it.second[0];
+		BlameShadowObject bso = *trace.find(iid);
 		tracefile << "At file " << dbg.file << ", line " << dbg.line << ", column" << dbg.column << ", id " << iid << endl;
 		tracefile << bso.lowValue << ", " << bso.highValue << endl;
 	}
@@ -489,7 +494,7 @@ void BlameAnalysis::constructAliasBlame() {
 				bnids.push_back(BlameNodeID(iid, p));
 			}
 			for (auto iid : closeset) {
-				if (blameSummary.find(iid) == blameSummary.end()) {
+				if (!blameSummary.contains(iid)) {
 					continue;
 				}
 				requireHigherPrecision = requireHigherPrecision || blameSummary[iid][p].requireHigherPrecision;
@@ -605,7 +610,7 @@ void BlameAnalysis::post_analysis() {
 				if (blameNodeID.iid == -1) {
 					node.requireHigherPrecision = true;
 				}
-				if (blameSummary.find(blameNodeID.iid) == blameSummary.end()) {
+				if (!blameSummary.contains(blameNodeID.iid)) {
 					// Children are either a constant or alloca.
 					continue;
 				}
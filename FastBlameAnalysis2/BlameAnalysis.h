@@ -14,11 +14,22 @@
 #include "BlameUtilities.h"
 #include "BlameNode.h"
 #include "BlameShadowObject.h"
+#include "IIDTable.h"
+#include "AddressShadow.h"
 
 using std::unordered_map;
 using std::set;
 using std::string;
 
+// Shadow of a floating-point value in memory: the shadow object stored by
+// the instruction iid, if that instruction had one.
+struct MemoryShadow {
+	IID iid;
+	bool stored;
+	LOWPRECISION lowValue;
+	HIGHPRECISION highValue;
+};
+
 class BlameAnalysis {
 private:
 	// Return the file separator character depending on the underlying operating
@@ -33,7 +44,7 @@ private:
 
 	string get_selfpath();
 
-	// Read debug information from $GLOG_log_dir/debug.bin and wrap into a
+	// Read debug information from debug.bin (see debugFile) and wrap into a
 	// mapping from instruction IID to DebugInfo struct. The file debug.bin is
 	// constructed during instrumentation phase.
 	//
@@ -46,8 +57,9 @@ private:
 	// Debug information includes the LoC, column and file of the instruction.
 	const unordered_map<IID, DebugInfo> debugInfoMap = readDebugInfo();
 
-	unordered_map<IID, unordered_map<void*, BlameShadowObject>> trace;
-	unordered_map<IID, std::array<BlameNode, PRECISION_NO>> blameSummary;
+	IIDTable<BlameShadowObject> trace;
+	AddressShadow<MemoryShadow> memory;
+	IIDTable<std::array<BlameNode, PRECISION_NO>> blameSummary;
 	unordered_map<IID, std::set<IID>> alias;
 	set<BlameNodeID> diverge;
 	uint64_t inst_count;
@@ -152,8 +164,6 @@ private:
 	BlameNode computeBlameInformation(const BlameShadowObject& BSO, const BlameShadowObject& lBSO,
 									  const BlameShadowObject& rBSO, PRECISION p);
 
-	bool canBlame(HIGHPRECISION result, HIGHPRECISION lop, HIGHPRECISION rop, FBINOP op, PRECISION p);
-
 	bool isRequiredHigherPrecisionOperator(HIGHPRECISION result, HIGHPRECISION lop, HIGHPRECISION rop, FBINOP op,
 										   PRECISION p);
 
@@ -167,7 +177,9 @@ private:
 
 	void copyBlameSummary(IID dest, IID src);
 
-	void copyShadowObject(IID dstIID, void* dstPtr, IID srcIID, void* srcPtr, double v);
+	// Shadow dstIID with the shadow of srcIID, read from memory at srcPtr
+	// unless srcPtr is null; with v itself if there is none.
+	void copyShadowObject(IID dstIID, IID srcIID, void* srcPtr, double v);
 
 	void dumpTrace();
 
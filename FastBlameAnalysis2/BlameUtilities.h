@@ -1,20 +1,15 @@
 #ifndef _BLAME_UTILITIES_H_
 #define _BLAME_UTILITIES_H_
 
+#include <array>
 #include <assert.h>
 #include <cmath>
+#include <cstdlib>
 #include <unordered_map>
 #include <istream>
 
-struct DebugInfo {
-	std::string file;
-	unsigned line, column;
-	DebugInfo() : file("n/a"), line(0), column(0) {}
-};
-
-std::istream& operator>>(std::istream& input, DebugInfo& dbg);
+#include "DebugInfo.h"
 
-typedef int32_t IID;
 typedef double HIGHPRECISION;
 typedef float LOWPRECISION;
 
@@ -114,7 +109,7 @@ inline bool equalWithinPrecision(double v1, double v2, PRECISION p) {
 			(DOUBLE_MANTISSA_LENGTH - PRECISION_BITS.at(p) - 1);
 
 	// Return true if the two mantissa offset less than or equal to 1.
-	return abs(*ptr1 - *ptr2) <= 1;
+	return std::abs(*ptr1 - *ptr2) <= 1;
 }
 
 // Template function to perform the floating-point binary operator on
@@ -34,7 +34,9 @@ extern "C" {
 	void llvm_call_pow(IID iidf, double output, IID operand01, double operandValue01, IID operand02, double operandValue02);
 
 	// ***** Other Operations ***** //
+	void llvm_push_frame(void* callee);
+	void llvm_pop_frame();
 	void llvm_arg(unsigned argInx, IID iid);
-	void llvm_return(IID iid);
+	void llvm_return(void* function, IID iid);
 	void llvm_after_call(IID iid, double v);
 }
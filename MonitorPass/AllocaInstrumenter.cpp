@@ -59,11 +59,11 @@ bool AllocaInstrumenter::CheckAndInstrument(Instruction* inst) {
 				elemType = aryType->getElementType();
 			}
 
-			// pushing all struct flatten type if element is truct
+			// passing the struct layout if element is struct
 			elemKind = TypeToKind(elemType);
 			safe_assert(elemKind != INV_KIND);
 			if (elemKind == STRUCT_KIND) {
-				pushStructType((StructType*)elemType, instrs);
+				instrs.push_back(PUSH_TYPE_LAYOUT((StructType*)elemType));
 			}
 
 			// generating constant arguments for call back
@@ -77,7 +77,10 @@ bool AllocaInstrumenter::CheckAndInstrument(Instruction* inst) {
 		} else if (type->isStructTy()) {
 			// alloca for struct type
 			StructType* structType = (StructType*)type;
-			uint64_t size = pushStructType(structType, instrs);
+			vector<KIND> kinds;
+			FlattenType(structType, kinds);
+			uint64_t size = kinds.size();
+			instrs.push_back(PUSH_TYPE_LAYOUT(structType));
 
 			Constant* sizeC = INT64_CONSTANT(size, UNSIGNED);
 
@@ -99,58 +102,3 @@ bool AllocaInstrumenter::CheckAndInstrument(Instruction* inst) {
 		return false;
 	}
 }
-
-uint64_t AllocaInstrumenter::pushStructType(StructType* structType, InstrPtrVector& instrs) {
-	uint64_t size = structType->getNumElements();
-	uint64_t allocation = 0;
-	for (uint64_t i = 0; i < size; i++) {
-		Type* elemType = structType->getElementType(i);
-		KIND elemKind = TypeToKind(elemType);
-		if (elemKind == INV_KIND) {
-			elemType->dump();
-		}
-		safe_assert(elemKind != INV_KIND);
-		if (elemKind == ARRAY_KIND) {
-			allocation += pushStructType((ArrayType*)elemType, instrs);
-		} else if (elemKind == STRUCT_KIND) {
-			allocation += pushStructType((StructType*)elemType, instrs);
-		} else {
-			Constant* elemKindC = KIND_CONSTANT(elemKind);
-			Instruction* call = CALL_KIND("llvm_push_struct_type", elemKindC);
-			instrs.push_back(call);
-			allocation++;
-		}
-	}
-
-	return allocation;
-}
-
-uint64_t AllocaInstrumenter::pushStructType(ArrayType* arrayType, InstrPtrVector& instrs) {
-	Type* elemTy = arrayType;
-	int size = 1;
-	uint64_t allocation = 0;
-
-	while (dyn_cast<ArrayType>(elemTy)) {
-		size = size * ((ArrayType*)elemTy)->getNumElements();
-		elemTy = ((ArrayType*)elemTy)->getElementType();
-	}
-
-	KIND elemKind = TypeToKind(elemTy);
-	safe_assert(elemKind != INV_KIND);
-
-	if (elemKind == STRUCT_KIND) {
-		for (int i = 0; i < size; i++) {
-			allocation += pushStructType((StructType*)elemTy, instrs);
-		}
-	} else {
-		Constant* elemKindC = KIND_CONSTANT(elemKind);
-
-		for (int i = 0; i < size; i++) {
-			Instruction* call = CALL_KIND("llvm_push_struct_type", elemKindC);
-			instrs.push_back(call);
-			allocation++;
-		}
-	}
-
-	return allocation;
-}
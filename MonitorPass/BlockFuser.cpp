@@ -0,0 +1,207 @@
+/**
+ * @file BlockFuser.cpp
+ * @brief
+ */
+
+#include "BlockFuser.h"
+
+#include <algorithm>
+
+BlockFuser::BlockFuser() {
+#define BLOCK_CALLBACK(name) callbacks_.insert("llvm_" #name);
+	BLOCK_CALLBACKS(BLOCK_CALLBACK)
+#undef BLOCK_CALLBACK
+}
+
+bool BlockFuser::isFlushPoint(Instruction* inst) {
+	if (isa<DbgInfoIntrinsic>(inst)) {
+		return false;
+	}
+	return isa<TerminatorInst>(inst) || isa<CallInst>(inst) || inst->mayWriteToMemory();
+}
+
+bool BlockFuser::isSlotType(Type* type) {
+	return (type->isIntegerTy() && type->getIntegerBitWidth() <= 64) || type->isPointerTy() || type->isFloatTy() ||
+		   type->isDoubleTy();
+}
+
+bool BlockFuser::isFusable(CallInst* call) {
+	Function* callee = call->getCalledFunction();
+	if (callee == NULL || !call->getType()->isVoidTy() || !callbacks_.count(callee->getName().str())) {
+		return false;
+	}
+	for (unsigned i = 0; i < call->getNumArgOperands(); i++) {
+		if (!isSlotType(call->getArgOperand(i)->getType())) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void BlockFuser::closeRun(Run& run, Instruction* before) {
+	// a single callback is not worth a run
+	if (run.calls.size() >= 2) {
+		run.before = before;
+		runs_.push_back(run);
+	}
+	run.calls.clear();
+}
+
+void BlockFuser::collect(BasicBlock* block, const std::set<Instruction*>& original) {
+	Run run;
+
+	for (BasicBlock::iterator itr = block->begin(), end = block->end(); itr != end; ++itr) {
+		Instruction* inst = (Instruction*)itr;
+
+		if (original.count(inst)) {
+			if (isFlushPoint(inst)) {
+				closeRun(run, inst);
+			}
+			continue;
+		}
+
+		// instrumentation that is not a fusable callback stays in place; the
+		// callbacks before it are called before it has any effect
+		CallInst* call = dyn_cast<CallInst>(inst);
+		if (call != NULL && isFusable(call)) {
+			run.calls.push_back(call);
+		} else if (call != NULL || inst->mayWriteToMemory()) {
+			closeRun(run, inst);
+		}
+	}
+}
+
+void BlockFuser::finalize(Module& M) {
+	Type* slotType = Type::getInt64Ty(M.getContext());
+
+	// program values used by each run, and the largest run of each function
+	std::vector<std::vector<Value*> > values(runs_.size());
+	std::map<Function*, unsigned> bufferSizes;
+	for (unsigned r = 0; r < runs_.size(); r++) {
+		std::set<Value*> seen;
+		for (unsigned i = 0; i < runs_[r].calls.size(); i++) {
+			CallInst* call = runs_[r].calls[i];
+			for (unsigned j = 0; j < call->getNumArgOperands(); j++) {
+				Value* arg = call->getArgOperand(j);
+				if (!isa<Constant>(arg) && seen.insert(arg).second) {
+					values[r].push_back(arg);
+				}
+			}
+		}
+		unsigned& size = bufferSizes[runs_[r].before->getParent()->getParent()];
+		size = std::max(size, (unsigned)values[r].size());
+	}
+
+	// one static slot buffer per function
+	std::map<Function*, Value*> buffers;
+	for (std::map<Function*, unsigned>::iterator it = bufferSizes.begin(); it != bufferSizes.end(); ++it) {
+		Instruction* entry = &*it->first->getEntryBlock().getFirstInsertionPt();
+		buffers[it->first] = it->second == 0 ? (Value*)ConstantPointerNull::get(PointerType::getUnqual(slotType))
+							 : new AllocaInst(slotType, ConstantInt::get(Type::getInt32Ty(M.getContext()), it->second),
+											  "llvm_block_slots", entry);
+	}
+
+	for (unsigned r = 0; r < runs_.size(); r++) {
+		Run& run = runs_[r];
+		Value* buffer = buffers[run.before->getParent()->getParent()];
+
+		std::map<Value*, unsigned> slots;
+		for (unsigned k = 0; k < values[r].size(); k++) {
+			slots[values[r][k]] = k;
+		}
+
+		// pass the program values and call the run's handler
+		IRBuilder<> builder(run.before);
+		for (unsigned k = 0; k < values[r].size(); k++) {
+			builder.CreateStore(toSlot(builder, values[r][k]), builder.CreateConstGEP1_32(buffer, k));
+		}
+		builder.CreateCall(getHandler(M, run, slots), buffer);
+
+		for (unsigned i = 0; i < run.calls.size(); i++) {
+			run.calls[i]->eraseFromParent();
+		}
+	}
+	runs_.clear();
+	handlers_.clear();
+}
+
+Function* BlockFuser::getHandler(Module& M, const Run& run, std::map<Value*, unsigned>& slots) {
+	// runs that make the same calls with the same constants and slots share
+	// a handler; constants are uniqued, so they compare by address
+	HandlerKey key;
+	for (unsigned i = 0; i < run.calls.size(); i++) {
+		CallInst* call = run.calls[i];
+		key.push_back(std::make_pair(call->getCalledFunction(), -1));
+		for (unsigned j = 0; j < call->getNumArgOperands(); j++) {
+			Value* value = call->getArgOperand(j);
+			if (isa<Constant>(value)) {
+				key.push_back(std::make_pair(value, -1));
+			} else {
+				key.push_back(std::make_pair((Value*)NULL, (int)slots[value]));
+			}
+		}
+	}
+	Function*& handler = handlers_[key];
+	if (handler != NULL) {
+		return handler;
+	}
+
+	LLVMContext& context = M.getContext();
+	std::vector<Type*> argTypes;
+	argTypes.push_back(PointerType::getUnqual(Type::getInt64Ty(context)));
+	FunctionType* handlerType = FunctionType::get(Type::getVoidTy(context), ArrayRef<Type*>(argTypes), false);
+	handler = Function::Create(handlerType, GlobalValue::InternalLinkage, "llvm_block_handler", &M);
+
+	// the callbacks of the run, in order, with their program values reloaded
+	// from the slot buffer
+	IRBuilder<> builder(BasicBlock::Create(context, "", handler));
+	Value* buffer = &*handler->arg_begin();
+	std::map<unsigned, Value*> reloaded;
+	for (unsigned i = 0; i < run.calls.size(); i++) {
+		CallInst* call = run.calls[i];
+		std::vector<Value*> args;
+		for (unsigned j = 0; j < call->getNumArgOperands(); j++) {
+			Value* value = call->getArgOperand(j);
+			if (isa<Constant>(value)) {
+				args.push_back(value);
+				continue;
+			}
+			unsigned slot = slots[value];
+			if (reloaded.find(slot) == reloaded.end()) {
+				reloaded[slot] = fromSlot(builder, builder.CreateLoad(builder.CreateConstGEP1_32(buffer, slot)),
+										  value->getType());
+			}
+			args.push_back(reloaded[slot]);
+		}
+		builder.CreateCall(call->getCalledFunction(), ArrayRef<Value*>(args));
+	}
+	builder.CreateRetVoid();
+	return handler;
+}
+
+Value* BlockFuser::toSlot(IRBuilder<>& builder, Value* value) {
+	Type* type = value->getType();
+	Type* slotType = builder.getInt64Ty();
+
+	if (type->isPointerTy()) {
+		return builder.CreatePtrToInt(value, slotType);
+	} else if (type->isFloatTy()) {
+		return builder.CreateZExt(builder.CreateBitCast(value, builder.getInt32Ty()), slotType);
+	} else if (type->isDoubleTy()) {
+		return builder.CreateBitCast(value, slotType);
+	} else {
+		return builder.CreateZExtOrBitCast(value, slotType);
+	}
+}
+
+Value* BlockFuser::fromSlot(IRBuilder<>& builder, Value* slot, Type* type) {
+	if (type->isPointerTy()) {
+		return builder.CreateIntToPtr(slot, type);
+	} else if (type->isFloatTy()) {
+		return builder.CreateBitCast(builder.CreateTrunc(slot, builder.getInt32Ty()), type);
+	} else if (type->isDoubleTy()) {
+		return builder.CreateBitCast(slot, type);
+	} else {
+		return builder.CreateTruncOrBitCast(slot, type);
+	}
+}
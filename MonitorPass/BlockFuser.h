@@ -0,0 +1,85 @@
+/**
+ * @file BlockFuser.h
+ * @brief BlockFuser Declarations.
+ */
+
+#ifndef BLOCK_FUSER_H_
+#define BLOCK_FUSER_H_
+
+#include "Common.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+/**
+ * Replaces runs of straight-line callbacks with a single call to a generated
+ * handler, an internal function that makes the callbacks of the run in order.
+ *
+ * A run ends before every original instruction that may write memory or
+ * enter the runtime (stores, calls, terminators), so loads are still synced
+ * against the memory they read and calls see the callbacks before them. The
+ * program values the callbacks use are passed in a buffer of 64-bit slots,
+ * one entry-block alloca per function; constant arguments stay in the
+ * handler. Runs with the same callbacks, constants and slots share a handler.
+ *
+ * Runs are collected while the functions are instrumented and rewritten by
+ * finalize() from doFinalization, since a function pass may not add
+ * functions.
+ */
+class BlockFuser {
+  public:
+    BlockFuser();
+
+    /**
+     * Collect the runs of callbacks of an instrumented block.
+     *
+     * @param block the block
+     * @param original the instructions of the function before instrumentation
+     */
+    void collect(BasicBlock* block, const std::set<Instruction*>& original);
+
+    /**
+     * Replace the collected runs with calls to their handlers.
+     */
+    void finalize(Module& M);
+
+  private:
+    struct Run {
+      std::vector<CallInst*> calls;  // fused callbacks, in order
+      Instruction* before;  // where the handler is called
+    };
+
+    // callees and constant arguments of a run, in order, with the slot of
+    // each non-constant argument
+    typedef std::vector<std::pair<Value*, int> > HandlerKey;
+
+    std::vector<Run> runs_;
+
+    std::map<HandlerKey, Function*> handlers_;
+
+    std::set<std::string> callbacks_;  // names of the callbacks that may be fused
+
+    static bool isFlushPoint(Instruction* inst);
+
+    static bool isSlotType(Type* type);
+
+    bool isFusable(CallInst* call);
+
+    /**
+     * End the current run before instruction before.
+     */
+    void closeRun(Run& run, Instruction* before);
+
+    /**
+     * The handler of a run whose program values are in the given slots,
+     * created on first use.
+     */
+    Function* getHandler(Module& M, const Run& run, std::map<Value*, unsigned>& slots);
+
+    Value* toSlot(IRBuilder<>& builder, Value* value);
+
+    Value* fromSlot(IRBuilder<>& builder, Value* slot, Type* type);
+};
+
+#endif /* BLOCK_FUSER_H_ */
@@ -6,6 +6,24 @@
 #include "CallInstrumenter.h"
 #include "../src/IValue.h"
 
+// Heap allocation functions whose result gets a shadow block; the callback
+// is llvm_call_<name>.
+static bool isAllocation(Function* callee) {
+	return callee != NULL && (callee->getName() == "malloc" || callee->getName() == "calloc" ||
+							  callee->getName() == "realloc");
+}
+
+// Functions with a dedicated callback, which takes the arguments from the
+// argument stack.
+static bool hasCallback(Function* callee) {
+	if (callee == NULL) {
+		return false;
+	}
+	StringRef name = callee->getName();
+	return isAllocation(callee) || name == "free" || name == "sin" || name == "acos" || name == "sqrt" ||
+		   name == "fabs" || name == "cos" || name == "log" || name == "exp" || name == "floor";
+}
+
 bool CallInstrumenter::CheckAndInstrument(Instruction* I) {
 	CallInst* callInst = dyn_cast<CallInst>(I);
 
@@ -61,7 +79,7 @@ bool CallInstrumenter::CheckAndInstrument(Instruction* I) {
 	*/
 
 	// whether this call unwinds the stack
-	if (callee != NULL && callee->getName() == "malloc") {
+	if (isAllocation(callee) || (callee != NULL && callee->getName() == "free")) {
 		noUnwind = false;
 	}
 	Constant* noUnwindC = BOOL_CONSTANT(noUnwind);
@@ -79,6 +97,28 @@ bool CallInstrumenter::CheckAndInstrument(Instruction* I) {
 	unsigned numArgs = noUnwind ? 0 : callInst->getNumArgOperands();
 	unsigned i;
 
+	// arguments of a general call are described by a constant array passed to
+	// llvm_call_args
+	vector<Constant*> callArgs;
+	if (!hasCallback(callee)) {
+		for (i = 0; i < numArgs; i++) {
+			Value* arg = callInst->getArgOperand(i);
+			KIND argKind = TypeToKind(arg->getType());
+
+			if (argKind == INV_KIND || (!isa<Instruction>(arg) && !isa<Constant>(arg) && !isa<Argument>(arg))) {
+				return false;
+			}
+
+			vector<Constant*> fields;
+			fields.push_back(computeIndex(arg));
+			fields.push_back(INT32_CONSTANT(getScope(arg), NOSIGN));
+			fields.push_back(KIND_CONSTANT(argKind));
+			fields.push_back(isa<Constant>(arg) ? CONSTANT_VALUE((Constant*)arg, NOSIGN) : INTMAX_CONSTANT(0, UNSIGNED));
+			callArgs.push_back(ConstantStruct::get(CALLARG_TYPE(), ArrayRef<Constant*>(fields)));
+		}
+		numArgs = 0;
+	}
+
 	// push each arguments to the argument stack
 	for (i = 0; i < numArgs; i++) {
 		// fields to reconstruct KVALUE during interpretation
@@ -101,9 +141,8 @@ bool CallInstrumenter::CheckAndInstrument(Instruction* I) {
 
 	Instruction* call = NULL;
 
-	// the case for MALLOC
-	if (callInst->getCalledFunction() != NULL &&
-			callInst->getCalledFunction()->getName() == "malloc") {
+	// the case for MALLOC, CALLOC and REALLOC
+	if (isAllocation(callInst->getCalledFunction())) {
 		// Value* callValue = KVALUE_VALUE(callInst->getCalledValue(), instrs,
 		// NOSIGN);
 
@@ -138,11 +177,8 @@ bool CallInstrumenter::CheckAndInstrument(Instruction* I) {
 			kind = KIND_CONSTANT(returnKind);
 
 			if (TypeToKind(dest->getElementType()) == STRUCT_KIND) {
-				uint64_t allocation =
-					pushStructType((StructType*)dest->getElementType(), instrs);
-				cout << "After allocation: " << allocation << endl;
-
 				StructType* structType = (StructType*)dest->getElementType();
+				instrs.push_back(PUSH_TYPE_LAYOUT(structType));
 
 				// structType->dump();
 
@@ -183,12 +219,21 @@ bool CallInstrumenter::CheckAndInstrument(Instruction* I) {
 		}
 		instrsAfter.push_back(mallocAddress);
 
-		call = CALL_IID_BOOL_KIND_INT_INT_INT64("llvm_call_malloc", iid, noUnwindC,
+		string callback = "llvm_call_" + callee->getName().str();
+		call = CALL_IID_BOOL_KIND_INT_INT_INT64(callback.c_str(), iid, noUnwindC,
 												kind, size, inx, mallocAddress);
 		instrsAfter.push_back(call);
 
 		InsertAllBefore(instrs, callInst);
 		InsertAllAfter(instrsAfter, callInst);
+	} else if (callInst->getCalledFunction() != NULL &&
+			   callInst->getCalledFunction()->getName() == "free") {
+		// the case for FREE; the shadow block is released before the memory
+		// can be handed out again
+		call = CALL_IID_BOOL("llvm_call_free", iid, noUnwindC);
+		instrs.push_back(call);
+		InsertAllBefore(instrs, callInst);
+		return true;
 	} else if (callInst->getCalledFunction() != NULL &&
 			   callInst->getCalledFunction()->getName() == "sin") {
 		// the case for sin function
@@ -275,13 +320,15 @@ bool CallInstrumenter::CheckAndInstrument(Instruction* I) {
 	} else {
 		// the case for general function call
 		// kind is the return type of the function
-		call = CALL_IID_BOOL_KIND_INT("llvm_call", iid, noUnwindC, kind, inx);
+		Constant* countC = INT32_CONSTANT(callArgs.size(), NOSIGN);
+		Constant* argsC = callArgs.empty() ? ConstantPointerNull::get((PointerType*)CALLARGPTR_TYPE())
+						  : CONSTANT_ARRAY(CALLARG_TYPE(), callArgs, "llvm_call_args");
+		call = CALL_IID_BOOL_KIND_INT_INT_CALLARGS("llvm_call_args", iid, noUnwindC, kind, inx, countC, argsC);
 		instrs.push_back(call);
 		InsertAllBefore(instrs, callInst);
 	}
 
-	if (callInst->getCalledFunction() == NULL ||
-			callInst->getCalledFunction()->getName() != "malloc") {
+	if (!isAllocation(callInst->getCalledFunction())) {
 		Instruction* call = NULL;
 
 		if (returnType->isVoidTy()) {
@@ -311,60 +358,6 @@ bool CallInstrumenter::CheckAndInstrument(Instruction* I) {
 	return true;
 }
 
-uint64_t CallInstrumenter::pushStructType(StructType* structType,
-		InstrPtrVector& instrs) {
-	uint64_t size = structType->getNumElements();
-	uint64_t allocation = 0;
-	for (uint64_t i = 0; i < size; i++) {
-		Type* elemType = structType->getElementType(i);
-		KIND elemKind = TypeToKind(elemType);
-		safe_assert(elemKind != INV_KIND);
-		if (elemKind == ARRAY_KIND) {
-			allocation += pushStructType((ArrayType*)elemType, instrs);
-		} else if (elemKind == STRUCT_KIND) {
-			allocation += pushStructType((StructType*)elemType, instrs);
-		} else {
-			Constant* elemKindC = KIND_CONSTANT(elemKind);
-			Instruction* call = CALL_KIND("llvm_push_struct_type", elemKindC);
-			instrs.push_back(call);
-			allocation++;
-		}
-	}
-
-	return allocation;
-}
-
-uint64_t CallInstrumenter::pushStructType(ArrayType* arrayType,
-		InstrPtrVector& instrs) {
-	Type* elemTy = arrayType;
-	int size = 1;
-	uint64_t allocation = 0;
-
-	while (dyn_cast<ArrayType>(elemTy)) {
-		size = size * ((ArrayType*)elemTy)->getNumElements();
-		elemTy = ((ArrayType*)elemTy)->getElementType();
-	}
-
-	KIND elemKind = TypeToKind(elemTy);
-	safe_assert(elemKind != INV_KIND);
-
-	if (elemKind == STRUCT_KIND) {
-		for (int i = 0; i < size; i++) {
-			allocation += pushStructType((StructType*)elemTy, instrs);
-		}
-	} else {
-		Constant* elemKindC = KIND_CONSTANT(elemKind);
-
-		for (int i = 0; i < size; i++) {
-			Instruction* call = CALL_KIND("llvm_push_struct_type", elemKindC);
-			instrs.push_back(call);
-			allocation++;
-		}
-	}
-
-	return allocation;
-}
-
 unsigned CallInstrumenter::getFlatSize(ArrayType* arrayType) {
 	Type* elemTy;
 	int size;
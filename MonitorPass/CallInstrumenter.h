@@ -15,8 +15,6 @@ class CallInstrumenter : public Instrumenter {
     CallInstrumenter(std::string name, Instrumentation* instrumentation) : Instrumenter(name, instrumentation) {};
     bool CheckAndInstrument(Instruction* I);
   private:
-    uint64_t pushStructType(StructType* structType, InstrPtrVector& instrs);
-    uint64_t pushStructType(ArrayType* arrayType, InstrPtrVector& instrs);
     unsigned getFlatSize(ArrayType* arrayType);
     unsigned getFlatSize(StructType* structType);
 };
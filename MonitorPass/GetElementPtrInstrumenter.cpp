@@ -51,125 +51,56 @@ bool GetElementPtrInstrumenter::CheckAndInstrument(Instruction* inst) {
 	if (elemT->isArrayTy()) {
 		// this branch is the case for local array
 
-		Type* gepInstType;
-		KIND kind;
-		Constant* elementSizeC, *scopeInx[3], *valOrInxInx[3], *sizeC[2];
-		Instruction* call;
-		int elementSize, i;
-		queue<Value*> arrIndices;
-		queue<int64_t> arrSize;
-
-		// collecting all array indices
-		for (User::op_iterator idx = gepInst->idx_begin(); idx != gepInst->idx_end(); idx++) {
-			arrIndices.push((Value*)idx->get());
-		}
-
-		// Create constants for array indices. Because array is usually up to size
-		// 2, getelementptr usually has indices up to size 3. We cover this usual case,
-		// and put array indices as arguments to the callback for
-		// getelementptr_array. If the array is of dimension greater than two,
-		// push_getelementptr_in and push_array_size will be used to push the remaining indices
-		// and sizes
-		for (i = 0; i < 3; i++) {
-			if (!arrIndices.empty()) {
-				Value* value;
-				ActualValue av;
-
-				value = arrIndices.front();
-				av = getActualValue(value);
-				scopeInx[i] = INT32_CONSTANT(av.scope, SIGNED);
-				valOrInxInx[i] = av.valOrInx;
-				arrIndices.pop();
-			} else {
-				scopeInx[i] = INT32_CONSTANT(SCOPE_INVALID, SIGNED);
-				valOrInxInx[i] = INT64_CONSTANT(-1, SIGNED);
-			}
-		}
-
-		// adding callbacks for pushing array indices
-		while (!arrIndices.empty()) {
-			Constant* scope[5], *valOrInx[5];
-			Instruction* call;
-			int i;
-
-			for (i = 0; i < 5; i++) {
-				if (!arrIndices.empty()) {
-					Value* value;
-					ActualValue av;
-
-					value = arrIndices.front();
-					av = getActualValue(value);
-					scope[i] = INT32_CONSTANT(av.scope, SIGNED);
-					valOrInx[i] = av.valOrInx;
-					arrIndices.pop();
+		// Walk down the indexed type. Constant indices are folded into a byte
+		// offset; the other indices are described by a constant array of
+		// GEPINDEX entries, so any number of dimensions is supported.
+		User::op_iterator idx = gepInst->idx_begin();
+		Type* type = elemT;
+		int64_t constOffset = 0;
+		vector<Constant*> indices;
+
+		// the first index is for the pointer operand
+		ActualValue ptrIndex = getActualValue(idx->get());
+		idx++;
+
+		for (; idx != gepInst->idx_end(); idx++) {
+			Value* value = idx->get();
+
+			if (ArrayType* arrayType = dyn_cast<ArrayType>(type)) {
+				type = arrayType->getElementType();
+				int64_t stride = getFlatSize(type);
+
+				if (ConstantInt* cInt = dyn_cast<ConstantInt>(value)) {
+					constOffset += cInt->getSExtValue() * stride;
 				} else {
-					scope[i] = INT32_CONSTANT(SCOPE_INVALID, SIGNED);
-					valOrInx[i] = INT64_CONSTANT(-1, SIGNED);
+					ActualValue av = getActualValue(value);
+					vector<Constant*> fields;
+					fields.push_back(INT32_CONSTANT(av.scope, SIGNED));
+					fields.push_back(ConstantExpr::getIntegerCast(av.valOrInx, INT64_TYPE(), SIGNED));
+					fields.push_back(INT64_CONSTANT(stride, SIGNED));
+					indices.push_back(ConstantStruct::get(GEPINDEX_TYPE(), ArrayRef<Constant*>(fields)));
 				}
-			}
-
-			call = CALL_INT_INT_INT_INT_INT_INT64_INT64_INT64_INT64_INT64("llvm_push_getelementptr_inx5", scope[0], scope[1],
-					scope[2], scope[3], scope[4], valOrInx[0],
-					valOrInx[1], valOrInx[2], valOrInx[3], valOrInx[4]);
-			instrs.push_back(call);
-		}
-
-		// collecting all array sizes
-		while (dyn_cast<ArrayType>(elemT)) {
-			arrSize.push(((ArrayType*)elemT)->getNumElements());
-			elemT = ((ArrayType*)elemT)->getElementType();
-		}
-
-		// Create constants for array sizes. Array is usually up to two dimensions. We cover this usual case,
-		// and put array sizes as arguments to the callback for
-		// getelementptr_array. If the array is of dimension greater than two,
-		// push_getelementptr_in and push_array_size will be used to push the
-		// remain indices and sizes
-		for (i = 0; i < 2; i++) {
-			if (!arrSize.empty()) {
-				sizeC[i] = INT32_CONSTANT(arrSize.front(), SIGNED);
-				arrSize.pop();
-			} else {
-				sizeC[i] = INT32_CONSTANT(-1, SIGNED);
-			}
-		}
-
-		// adding callbacks for pushing array sizes
-		while (!arrSize.empty()) {
-			Constant* size[5];
-			Instruction* call;
-			int i;
-
-			for (i = 0; i < 5; i++) {
-				if (!arrSize.empty()) {
-					size[i] = INT32_CONSTANT(arrSize.front(), SIGNED);
-					arrSize.pop();
-				} else {
-					size[i] = INT32_CONSTANT(-1, SIGNED);
+			} else if (StructType* structType = dyn_cast<StructType>(type)) {
+				unsigned field = dyn_cast<ConstantInt>(value)->getZExtValue();
+				for (unsigned i = 0; i < field; i++) {
+					constOffset += getFlatSize(structType->getElementType(i));
 				}
+				type = structType->getElementType(field);
+			} else {
+				return false;
 			}
-
-			call = CALL_INT_INT_INT_INT_INT("llvm_push_array_size5", size[0], size[1], size[2], size[3], size[4]);
-			instrs.push_back(call);
 		}
 
+		Constant* elementSizeC = INT32_CONSTANT(getFlatSize(type), SIGNED);
+		Constant* countC = INT32_CONSTANT(indices.size(), SIGNED);
+		Constant* indicesC = indices.empty() ? ConstantPointerNull::get((PointerType*)GEPINDEXPTR_TYPE())
+							 : CONSTANT_ARRAY(GEPINDEX_TYPE(), indices, "llvm_gep_indices");
 
-		gepInstType = ((PointerType*)gepInst->getType())->getElementType();
-		kind = TypeToKind(gepInstType);
-
-		if (kind == ARRAY_KIND) {
-			elementSize = getFlatSize((ArrayType*)gepInstType);
-		} else if (kind == STRUCT_KIND) {
-			elementSize = getFlatSize((StructType*)gepInstType);
-		} else {
-			elementSize = KIND_GetSize(kind);
-		}
-
-		elementSizeC = INT32_CONSTANT(elementSize, SIGNED);
-
-		call = CALL_INT_INT_INT64_INT_INT_INT_INT_INT64_INT64_INT64_INT_INT_INT(
-				   "llvm_getelementptr_array", baseInx, baseScope, baseAddr, elementSizeC, scopeInx[0], scopeInx[1], scopeInx[2],
-				   valOrInxInx[0], valOrInxInx[1], valOrInxInx[2], sizeC[0], sizeC[1], inxC);
+		Instruction* call = CALL_INT_INT_INT64_INT_INT_INT64_INT64_INT_GEPINDICES_INT(
+								"llvm_getelementptr_strided", baseInx, baseScope, baseAddr, elementSizeC,
+								INT32_CONSTANT(ptrIndex.scope, SIGNED),
+								ConstantExpr::getIntegerCast(ptrIndex.valOrInx, INT64_TYPE(), SIGNED),
+								INT64_CONSTANT(constOffset, SIGNED), countC, indicesC, inxC);
 		instrs.push_back(call);
 
 	} else if (elemT->isStructTy()) {
@@ -201,7 +132,7 @@ bool GetElementPtrInstrumenter::CheckAndInstrument(Instruction* inst) {
 		*/
 		//////////////////////////
 
-		pushStructType(structType, instrs);
+		instrs.push_back(PUSH_TYPE_LAYOUT(structType));
 
 		for (User::op_iterator idx = gepInst->idx_begin(); idx != gepInst->idx_end(); idx++) {
 
@@ -216,9 +147,6 @@ bool GetElementPtrInstrumenter::CheckAndInstrument(Instruction* inst) {
 			instrs.push_back(call);
 		}
 
-		// size of struct elements
-		pushStructElementSize((StructType*)elemT, instrs);
-
 		Instruction* call =
 			CALL_IID_INT_INT_INT64_INT("llvm_getelementptr_struct", iidC, baseInx, baseScope, baseAddr, inxC);
 		instrs.push_back(call);
@@ -268,24 +196,16 @@ bool GetElementPtrInstrumenter::CheckAndInstrument(Instruction* inst) {
 	return true;
 }
 
-void GetElementPtrInstrumenter::pushStructElementSize(StructType* structType, InstrPtrVector& instrs) {
-	uint64_t size, i, allocation;
+uint64_t GetElementPtrInstrumenter::getFlatSize(Type* type) {
+	KIND kind = TypeToKind(type);
+	safe_assert(kind != INV_KIND);
 
-	size = structType->getNumElements();
-	for (i = 0; i < size; i++) {
-		Type* elemType = structType->getElementType(i);
-		KIND elemKind = TypeToKind(elemType);
-		safe_assert(elemKind != INV_KIND);
-		if (elemKind == ARRAY_KIND) {
-			allocation = getFlatLength((ArrayType*)elemType);
-		} else if (elemKind == STRUCT_KIND) {
-			allocation = getFlatLength((StructType*)elemType);
-		} else {
-			allocation = 1;
-		}
-		Constant* allocC = INT64_CONSTANT(allocation, NOSIGN);
-		Instruction* call = CALL_INT64("llvm_push_struct_element_size", allocC);
-		instrs.push_back(call);
+	if (kind == ARRAY_KIND) {
+		return getFlatSize((ArrayType*)type);
+	} else if (kind == STRUCT_KIND) {
+		return getFlatSize((StructType*)type);
+	} else {
+		return KIND_GetSize(kind);
 	}
 }
 
@@ -340,110 +260,6 @@ uint64_t GetElementPtrInstrumenter::getFlatSize(StructType* structType) {
 	return allocation;
 }
 
-uint64_t GetElementPtrInstrumenter::getFlatLength(ArrayType* arrayType) {
-	Type* elemTy;
-	int size;
-	uint64_t allocation;
-	KIND elemKind;
-
-	// for multi-dimensional array get flatten size
-	size = 1;
-	elemTy = arrayType;
-	while (dyn_cast<ArrayType>(elemTy)) {
-		size = size * ((ArrayType*)elemTy)->getNumElements();
-		elemTy = ((ArrayType*)elemTy)->getElementType();
-	}
-
-	// retrieving element's type
-	elemKind = TypeToKind(elemTy);
-	safe_assert(elemKind != INV_KIND);
-
-	// element kind can be struct or primitive type
-	if (elemKind == STRUCT_KIND) {
-		allocation = size * getFlatLength((StructType*)elemTy);
-	} else {
-		allocation = size;
-	}
-
-	return allocation;
-}
-
-uint64_t GetElementPtrInstrumenter::getFlatLength(StructType* structType) {
-	uint64_t size, allocation, i;
-
-	allocation = 0;
-	size = structType->getNumElements();
-
-	// iterating through all struct element types accumulate allocation size
-	for (i = 0; i < size; i++) {
-		Type* elemType = structType->getElementType(i);
-		KIND elemKind = TypeToKind(elemType);
-		safe_assert(elemKind != INV_KIND);
-
-		if (elemKind == ARRAY_KIND) {
-			allocation += getFlatLength((ArrayType*)elemType);
-		} else if (elemKind == STRUCT_KIND) {
-			allocation += getFlatLength((StructType*)elemType);
-		} else {
-			allocation += 1;
-		}
-	}
-
-	return allocation;
-}
-
-uint64_t GetElementPtrInstrumenter::pushStructType(ArrayType* arrayType, InstrPtrVector& instrs) {
-	Type* elemTy = arrayType;
-	int size = 1;
-	uint64_t allocation = 0;
-
-	while (dyn_cast<ArrayType>(elemTy)) {
-		size = size * ((ArrayType*)elemTy)->getNumElements();
-		elemTy = ((ArrayType*)elemTy)->getElementType();
-	}
-
-	KIND elemKind = TypeToKind(elemTy);
-	safe_assert(elemKind != INV_KIND);
-
-	if (elemKind == STRUCT_KIND) {
-		for (int i = 0; i < size; i++) {
-			allocation += pushStructType((StructType*)elemTy, instrs);
-		}
-	} else {
-		Constant* elemKindC = KIND_CONSTANT(elemKind);
-
-		for (int i = 0; i < size; i++) {
-			Instruction* call = CALL_KIND("llvm_push_struct_type", elemKindC);
-			instrs.push_back(call);
-			allocation++;
-		}
-	}
-
-	return allocation;
-}
-
-uint64_t GetElementPtrInstrumenter::pushStructType(StructType* structType, InstrPtrVector& instrs) {
-	uint64_t size = structType->getNumElements();
-	uint64_t allocation = 0;
-	for (uint64_t i = 0; i < size; i++) {
-		Type* elemType = structType->getElementType(i);
-		KIND elemKind = TypeToKind(elemType);
-		safe_assert(elemKind != INV_KIND);
-		if (elemKind == ARRAY_KIND) {
-			allocation += pushStructType((ArrayType*)elemType, instrs);
-		} else if (elemKind == STRUCT_KIND) {
-			allocation += pushStructType((StructType*)elemType, instrs);
-		} else {
-			Constant* elemKindC = KIND_CONSTANT(elemKind);
-			Instruction* call = CALL_KIND("llvm_push_struct_type", elemKindC);
-			instrs.push_back(call);
-			allocation++;
-		}
-	}
-
-	return allocation;
-}
-
 GetElementPtrInstrumenter::ActualValue GetElementPtrInstrumenter::getActualValue(Value* value) {
 	SCOPE scope;
 	Constant* valOrInx;
@@ -21,13 +21,9 @@ class GetElementPtrInstrumenter : public Instrumenter {
   public:
     GetElementPtrInstrumenter(std::string name, Instrumentation* instrumentation) : Instrumenter(name, instrumentation){};
     bool CheckAndInstrument(Instruction* inst);
-    uint64_t pushStructType(StructType* structType, InstrPtrVector& instrs);
-    uint64_t pushStructType(ArrayType* arrayType, InstrPtrVector& instrs);
-    uint64_t getFlatLength(StructType* structType);
-    uint64_t getFlatLength(ArrayType* arrayType); 
+    uint64_t getFlatSize(Type* type);
     uint64_t getFlatSize(StructType* structType);
     uint64_t getFlatSize(ArrayType* arrayType); 
-    void pushStructElementSize(StructType* structType, InstrPtrVector& instrs);
 };
 
 #endif
@@ -149,6 +149,18 @@ int Instrumentation::getNumGlobalVar() {
 	return globalVarCount;
 }
 
+int Instrumentation::getTypeLayout(StructType* type) {
+	std::map<StructType*, int>::iterator it = layoutIndices.find(type);
+	if (it != layoutIndices.end()) {
+		return it->second;
+	}
+
+	int id = layouts.size();
+	layoutIndices[type] = id;
+	layouts.push_back(type);
+	return id;
+}
+
 int Instrumentation::getFrameSize() {
 	return varCount;
 }
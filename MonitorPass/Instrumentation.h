@@ -170,6 +170,18 @@ public:
    */
   int getNumGlobalVar();
 
+  /**
+   * Get the id of the layout of a struct type.
+   *
+   * @note The first request for a type creates its layout. All layouts are
+   * registered with the runtime once, at the start of the program.
+   *
+   * @param type the struct type.
+   *
+   * @return the layout id of the struct type.
+   */
+  int getTypeLayout(StructType* type);
+
   /**
    * Get the number of variables/registers in the current function.
    *
@@ -223,6 +235,8 @@ public:
   int fileCount; // counter of number of files 
   std::map<std::string, int> fileNames; // map from filename to file index
   std::map<IID, DebugInfo*> debugMap;
+  std::map<StructType*, int> layoutIndices; // map from struct type to layout id
+  std::vector<StructType*> layouts; // struct types by layout id
 
 private:
   InstrumenterPtrList instrumenters_;
@@ -104,6 +104,47 @@ public:
 		return PointerType::get(KVALUE_TYPE(), parent_->AS_);
 	}
 
+	inline StructType* CALLARG_TYPE() {
+		TypePtrVector typeList;
+		typeList.push_back(INT32_TYPE()); // index
+		typeList.push_back(INT32_TYPE()); // scope
+		typeList.push_back(KIND_TYPE());
+		typeList.push_back(VALUE_TYPE());
+
+		return StructType::get(parent_->M_->getContext(),
+							   ArrayRef<Type*>(typeList), false /*isPacked*/);
+	}
+	inline Type* CALLARGPTR_TYPE() {
+		return PointerType::get(CALLARG_TYPE(), parent_->AS_);
+	}
+
+	inline StructType* PHIARG_TYPE() {
+		TypePtrVector typeList;
+		typeList.push_back(INT32_TYPE()); // incoming block
+		typeList.push_back(INT32_TYPE()); // index
+		typeList.push_back(KIND_TYPE());
+		typeList.push_back(VALUE_TYPE());
+
+		return StructType::get(parent_->M_->getContext(),
+							   ArrayRef<Type*>(typeList), false /*isPacked*/);
+	}
+	inline Type* PHIARGPTR_TYPE() {
+		return PointerType::get(PHIARG_TYPE(), parent_->AS_);
+	}
+
+	inline StructType* GEPINDEX_TYPE() {
+		TypePtrVector typeList;
+		typeList.push_back(INT32_TYPE()); // scope
+		typeList.push_back(INT64_TYPE()); // value or index
+		typeList.push_back(INT64_TYPE()); // stride
+
+		return StructType::get(parent_->M_->getContext(),
+							   ArrayRef<Type*>(typeList), false /*isPacked*/);
+	}
+	inline Type* GEPINDEXPTR_TYPE() {
+		return PointerType::get(GEPINDEX_TYPE(), parent_->AS_);
+	}
+
 	inline Constant* INT32_CONSTANT(int32_t c, bool sign) {
 		return ConstantInt::get(INT32_TYPE(), c, sign);
 	}
@@ -501,6 +542,82 @@ public:
 
 	/*******************************************************************************************/
 
+	/**
+	 * The constant counterpart of CAST_VALUE: the value of a constant as a
+	 * VALUE (i64) constant.
+	 *
+	 * @param c the constant
+	 * @param isSigned whether an integer constant is sign extended
+	 */
+	Constant* CONSTANT_VALUE(Constant* c, bool isSigned) {
+		Type* T = c->getType();
+
+		if (T->isIntegerTy()) {
+			return ConstantExpr::getIntegerCast(c, VALUE_TYPE(), isSigned && !T->isIntegerTy(1));
+		} else if (T->isFloatingPointTy()) {
+			return ConstantExpr::getBitCast(ConstantExpr::getFPCast(c, FLPMAX_TYPE()), VALUE_TYPE());
+		} else if (T->isPointerTy()) {
+			return ConstantExpr::getPtrToInt(c, VALUE_TYPE());
+		}
+		return INTMAX_CONSTANT(0, UNSIGNED);
+	}
+
+	/**
+	 * Create a private constant array in the module being instrumented.
+	 *
+	 * @param elemType the type of the array elements
+	 * @param elems the array elements
+	 * @param name the name of the array
+	 *
+	 * @return a pointer to the first element of the array
+	 */
+	Constant* CONSTANT_ARRAY(Type* elemType, vector<Constant*>& elems, const char* name) {
+		ArrayType* arrayType = ArrayType::get(elemType, elems.size());
+		GlobalVariable* array = new GlobalVariable(*parent_->M_, arrayType, true /*isConstant*/,
+				GlobalValue::PrivateLinkage, ConstantArray::get(arrayType, ArrayRef<Constant*>(elems)), name);
+		return ConstantExpr::getPointerCast(array, PointerType::get(elemType, parent_->AS_));
+	}
+
+	/*******************************************************************************************/
+
+	/**
+	 * Flatten a struct or array type into the kinds of its primitive elements,
+	 * in memory order.
+	 *
+	 * @param type the type to flatten
+	 * @param kinds accumulation of element kinds
+	 */
+	void FlattenType(Type* type, vector<KIND>& kinds) {
+		KIND kind = TypeToKind(type);
+		safe_assert(kind != INV_KIND);
+
+		if (kind == STRUCT_KIND) {
+			StructType* structType = (StructType*)type;
+			for (unsigned i = 0; i < structType->getNumElements(); i++) {
+				FlattenType(structType->getElementType(i), kinds);
+			}
+		} else if (kind == ARRAY_KIND) {
+			ArrayType* arrayType = (ArrayType*)type;
+			for (uint64_t i = 0; i < arrayType->getNumElements(); i++) {
+				FlattenType(arrayType->getElementType(), kinds);
+			}
+		} else {
+			kinds.push_back(kind);
+		}
+	}
+
+	/**
+	 * Pass the layout of a struct type to the next struct callback.
+	 *
+	 * @param type the struct type
+	 */
+	Instruction* PUSH_TYPE_LAYOUT(StructType* type) {
+		Constant* layoutC = INT32_CONSTANT(parent_->getTypeLayout(type), SIGNED);
+		return CALL_INT("llvm_push_type_layout", layoutC);
+	}
+
+	/*******************************************************************************************/
+
 	void InsertAllBefore(InstrPtrVector& Instrs, Instruction* I) {
 		for (InstrPtrVector::iterator itr = Instrs.begin(); itr < Instrs.end();
 				++itr) {
@@ -632,6 +749,55 @@ public:
 		return CALL_INSTR(func, VOID_FUNC_TYPE(ArgTypes), Args);
 	}
 
+	/*******************************************************************************************/
+	Instruction* CALL_IID_INT_PHIARGS_INT(const char* func, Value* iid, Value* count, Value* args, Value* inx) {
+		TypePtrVector ArgTypes;
+		ArgTypes.push_back(IID_TYPE());
+		ArgTypes.push_back(INT32_TYPE());
+		ArgTypes.push_back(PHIARGPTR_TYPE());
+		ArgTypes.push_back(INT32_TYPE());
+
+		ValuePtrVector Args;
+		Args.push_back(iid);
+		Args.push_back(count);
+		Args.push_back(args);
+		Args.push_back(inx);
+
+		return CALL_INSTR(func, VOID_FUNC_TYPE(ArgTypes), Args);
+	}
+
+	/*******************************************************************************************/
+	Instruction* CALL_INT_INT_INT64_INT_INT_INT64_INT64_INT_GEPINDICES_INT(
+		const char* func, Value* baseInx, Value* baseScope, Value* baseAddr,
+		Value* elementSize, Value* ptrScope, Value* ptrValOrInx, Value* constOffset,
+		Value* count, Value* indices, Value* inx) {
+		TypePtrVector ArgTypes;
+		ArgTypes.push_back(INT32_TYPE());
+		ArgTypes.push_back(INT32_TYPE());
+		ArgTypes.push_back(INT64_TYPE());
+		ArgTypes.push_back(INT32_TYPE());
+		ArgTypes.push_back(INT32_TYPE());
+		ArgTypes.push_back(INT64_TYPE());
+		ArgTypes.push_back(INT64_TYPE());
+		ArgTypes.push_back(INT32_TYPE());
+		ArgTypes.push_back(GEPINDEXPTR_TYPE());
+		ArgTypes.push_back(INT32_TYPE());
+
+		ValuePtrVector Args;
+		Args.push_back(baseInx);
+		Args.push_back(baseScope);
+		Args.push_back(baseAddr);
+		Args.push_back(elementSize);
+		Args.push_back(ptrScope);
+		Args.push_back(ptrValOrInx);
+		Args.push_back(constOffset);
+		Args.push_back(count);
+		Args.push_back(indices);
+		Args.push_back(inx);
+
+		return CALL_INSTR(func, VOID_FUNC_TYPE(ArgTypes), Args);
+	}
+
 	/*******************************************************************************************/
 	Instruction* CALL_IID_BOOL_KVALUE_INT(const char* func, Value* iid, Value* b1,
 										  Value* kvalue, Value* inx) {
@@ -698,6 +864,28 @@ public:
 		return CALL_INSTR(func, VOID_FUNC_TYPE(ArgTypes), Args);
 	}
 
+	/*******************************************************************************************/
+	Instruction* CALL_IID_BOOL_KIND_INT_INT_CALLARGS(const char* func, Value* iid, Value* b1,
+			Value* kind, Value* inx, Value* count, Value* args) {
+		TypePtrVector ArgTypes;
+		ArgTypes.push_back(IID_TYPE());
+		ArgTypes.push_back(BOOL_TYPE());
+		ArgTypes.push_back(KIND_TYPE());
+		ArgTypes.push_back(INT32_TYPE());
+		ArgTypes.push_back(INT32_TYPE());
+		ArgTypes.push_back(CALLARGPTR_TYPE());
+
+		ValuePtrVector Args;
+		Args.push_back(iid);
+		Args.push_back(b1);
+		Args.push_back(kind);
+		Args.push_back(inx);
+		Args.push_back(count);
+		Args.push_back(args);
+
+		return CALL_INSTR(func, VOID_FUNC_TYPE(ArgTypes), Args);
+	}
+
 	/*******************************************************************************************/
 	Instruction* CALL_IID_BOOL_KIND_INT(const char* func, Value* iid, Value* b1,
 										Value* kind, Value* inx) {
@@ -875,6 +1063,21 @@ public:
 		return CALL_INSTR(func, VOID_FUNC_TYPE(ArgTypes), Args);
 	}
 
+	/*******************************************************************************************/
+	Instruction* CALL_INT_KIND_INT64(const char* func, Value* inx, Value* type, Value* value) {
+		TypePtrVector ArgTypes;
+		ArgTypes.push_back(INT32_TYPE());
+		ArgTypes.push_back(KIND_TYPE());
+		ArgTypes.push_back(INT64_TYPE());
+
+		ValuePtrVector Args;
+		Args.push_back(inx);
+		Args.push_back(type);
+		Args.push_back(value);
+
+		return CALL_INSTR(func, VOID_FUNC_TYPE(ArgTypes), Args);
+	}
+
 	/*******************************************************************************************/
 	Instruction* CALL_INT_INT_KIND_INT64(const char* func, Value* inx,
 										 Value* scope, Value* type,
@@ -20,25 +20,37 @@ bool PHINodeInstrumenter::CheckAndInstrument(Instruction* inst) {
 
     Constant* inxC = computeIndex(phiNode);
 
+    KIND kind = TypeToKind(phiNode->getType());
+    if (kind == INV_KIND) {
+      return false;
+    }
+
+    // the incoming (block, value) pairs are described by a constant table;
+    // the runtime picks the entry of the most recently recorded block
+    vector<Constant*> incoming;
     unsigned valuePairs = phiNode->getNumIncomingValues();
 
     for (unsigned i = 0; i < valuePairs; i++) {
       Value* inValue = phiNode->getIncomingValue(i);
-      Constant* blockInxC = computeIndex(phiNode->getIncomingBlock(i)); 
-      if (dyn_cast<Constant>(inValue) != NULL) {
-        Value* value = KVALUE_VALUE(inValue, instrs, SIGNED);
 
-        Instruction* call = CALL_KVALUE_INT("llvm_push_phinode_constant_value", value, blockInxC);
-        instrs.push_back(call);
+      vector<Constant*> fields;
+      fields.push_back(computeIndex(phiNode->getIncomingBlock(i)));
+      if (Constant* c = dyn_cast<Constant>(inValue)) {
+        fields.push_back(INT32_CONSTANT(-1, SIGNED));
+        fields.push_back(KIND_CONSTANT(kind));
+        fields.push_back(CONSTANT_VALUE(c, SIGNED));
       } else {
-        Constant* inValueInxC = computeIndex(inValue);
-
-        Instruction* call = CALL_INT_INT("llvm_push_phinode_value", inValueInxC, blockInxC);
-        instrs.push_back(call);
+        fields.push_back(computeIndex(inValue));
+        fields.push_back(KIND_CONSTANT(kind));
+        fields.push_back(INTMAX_CONSTANT(0, UNSIGNED));
       }
+      incoming.push_back(ConstantStruct::get(PHIARG_TYPE(), ArrayRef<Constant*>(fields)));
     }
 
-    Instruction* call = CALL_IID_INT("llvm_phinode", iidC, inxC);
+    Constant* countC = INT32_CONSTANT(incoming.size(), NOSIGN);
+    Constant* incomingC = CONSTANT_ARRAY(PHIARG_TYPE(), incoming, "llvm_phi_incoming");
+
+    Instruction* call = CALL_IID_INT_PHIARGS_INT("llvm_phinode_table", iidC, countC, incomingC, inxC);
     instrs.push_back(call);
 
     BasicBlock *phiBlock = phiNode->getParent();
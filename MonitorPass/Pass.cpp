@@ -4,6 +4,7 @@
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include "BlockFuser.h"
 #include "Instrumentation.h"
 #include "Instrumenter.h"
 #include "MonitorPass.h"
@@ -22,6 +23,14 @@ IncludedFunctions("includedFunctions", cl::value_desc("filename"),
 
 cl::opt<string> LogFileName("logfile", cl::value_desc("filename"), cl::desc("Name of log file"), cl::init("log"));
 
+cl::opt<bool> FPSliceOnly("fpSliceOnly",
+						  cl::desc("Only instrument instructions that feed floating-point values; the others run natively"),
+						  cl::init(false));
+
+cl::opt<bool> FuseBlocks("fuseBlocks",
+						 cl::desc("Make the callbacks of straight-line code from one generated handler per run"),
+						 cl::init(false));
+
 namespace {
 
 struct MonitorPass : public FunctionPass {
@@ -29,10 +38,81 @@ struct MonitorPass : public FunctionPass {
 
 	set<string> includedFunctions;
 
+	BlockFuser fuser;  // runs of callbacks collected with -fuseBlocks
+
 
 	MonitorPass() : FunctionPass(ID) {}
 	~MonitorPass() {}
 
+	static bool isFPType(Type* type) {
+		return type->getScalarType()->isFloatingPointTy();
+	}
+
+	/*
+	 * Instructions that are instrumented regardless of the data they compute:
+	 * the interpreter needs them to maintain its frames and local memory, and
+	 * those that produce or consume floating-point values.
+	 */
+	static bool isFPSliceSeed(Instruction* inst) {
+		if (isa<CallInst>(inst) || isa<InvokeInst>(inst) || isa<ReturnInst>(inst) || isa<AllocaInst>(inst)) {
+			return true;
+		}
+		if (isFPType(inst->getType())) {
+			return true;
+		}
+		for (unsigned i = 0; i < inst->getNumOperands(); i++) {
+			if (isFPType(inst->getOperand(i)->getType())) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/*
+	 * The pointer operand of a load or store. It is not followed by the slice;
+	 * if it is not computed by the slice, its register is resynchronized from
+	 * the concrete address before the access.
+	 */
+	static Value* getAddressOperand(Instruction* inst) {
+		if (LoadInst* loadInst = dyn_cast<LoadInst>(inst)) {
+			return loadInst->getPointerOperand();
+		} else if (StoreInst* storeInst = dyn_cast<StoreInst>(inst)) {
+			return storeInst->getPointerOperand();
+		}
+		return NULL;
+	}
+
+	/*
+	 * Compute the backward slice of F that feeds floating-point values and
+	 * memory holding floating-point data.
+	 */
+	static void computeFPSlice(Function& F, set<Instruction*>& slice) {
+		vector<Instruction*> worklist;
+
+		for (Function::iterator BB = F.begin(), e = F.end(); BB != e; ++BB) {
+			for (BasicBlock::iterator itr = BB->begin(), end = BB->end(); itr != end; ++itr) {
+				Instruction* inst = (Instruction*)itr;
+				if (isFPSliceSeed(inst)) {
+					slice.insert(inst);
+					worklist.push_back(inst);
+				}
+			}
+		}
+
+		while (!worklist.empty()) {
+			Instruction* inst = worklist.back();
+			worklist.pop_back();
+
+			Value* address = getAddressOperand(inst);
+			for (unsigned i = 0; i < inst->getNumOperands(); i++) {
+				Instruction* op = dyn_cast<Instruction>(inst->getOperand(i));
+				if (op != NULL && op != address && slice.insert(op).second) {
+					worklist.push_back(op);
+				}
+			}
+		}
+	}
+
 	virtual bool runOnFunction(Function& F) {
 
 		if (!includedFunctions.empty()) {
@@ -57,6 +137,16 @@ struct MonitorPass : public FunctionPass {
 		// set up varCount and indices map
 		instrumentation->BeginFunction();
 
+		// instructions of the function before instrumentation
+		set<Instruction*> original;
+
+		// with -fpSliceOnly, the instructions outside the floating-point slice
+		// are not instrumented
+		set<Instruction*> slice;
+		if (FPSliceOnly) {
+			computeFPSlice(F, slice);
+		}
+
 		// create index for each arguments
 		for (Function::arg_iterator ARG = F.arg_begin(), ae = F.arg_end(); ARG != ae; ++ARG) {
 			Argument* arg = (Argument*)ARG;
@@ -65,6 +155,9 @@ struct MonitorPass : public FunctionPass {
 		}
 
 		// create index for all instructions
+		// only blocks that are incoming blocks of some phi node need to record
+		// their id at runtime
+		std::set<BasicBlock*> phiPredecessors;
 		for (Function::iterator BB = F.begin(), e = F.end(); BB != e; ++BB) {
 			// creater index for each basic block
 			BasicBlock* block = (BasicBlock*)BB;
@@ -76,6 +169,14 @@ struct MonitorPass : public FunctionPass {
 				Instruction* inst = (Instruction*)itr;
 				IID iid = static_cast<IID>(reinterpret_cast<ADDRINT>(inst));
 				instrumentation->createIndex(iid);
+				original.insert(inst);
+
+				PHINode* phiNode = dyn_cast<PHINode>(inst);
+				if (phiNode != NULL && (!FPSliceOnly || slice.count(inst))) {
+					for (unsigned i = 0; i < phiNode->getNumIncomingValues(); i++) {
+						phiPredecessors.insert(phiNode->getIncomingBlock(i));
+					}
+				}
 			}
 		}
 
@@ -100,7 +201,7 @@ struct MonitorPass : public FunctionPass {
 
 			// set up pointers to BB, F, and M
 			instrumentation->BeginBasicBlock(BB, &F, M);
-			isFirstBlockInstruction = true;
+			isFirstBlockInstruction = phiPredecessors.count((BasicBlock*)BB) != 0;
 			for (BasicBlock::iterator itr = BB->begin(), end = BB->end(); itr != end; ++itr) {
 
 				BasicBlock* block = (BasicBlock*)BB;
@@ -155,12 +256,39 @@ struct MonitorPass : public FunctionPass {
 					isFirstBlockInstruction = false;
 				}
 
+				if (FPSliceOnly && !slice.count((Instruction*)itr)) {
+					continue;
+				}
+
+				// the address of a load or store in the slice may be computed
+				// natively; resynchronize its register with the concrete address
+				Instruction* address = FPSliceOnly ? dyn_cast_or_null<Instruction>(getAddressOperand(itr)) : NULL;
+				if (address != NULL && !slice.count(address) && instrumentation->getIndex(address) != -1) {
+					Instrumenter instrumenter("", instrumentation);
+					InstrPtrVector instrs;
+
+					Instruction* addressValue = instrumenter.CAST_VALUE(address, instrs, NOSIGN);
+					if (addressValue != NULL) {
+						instrs.push_back(addressValue);
+						instrs.push_back(instrumenter.CALL_INT_KIND_INT64("llvm_sync_register",
+																		 instrumenter.computeIndex(address),
+																		 instrumenter.KIND_CONSTANT(PTR_KIND), addressValue));
+						instrumenter.InsertAllBefore(instrs, itr);
+					}
+				}
+
 				// instrumentation
 				if (instrumentation->getIndex(itr) != -1) {
 					instrumentation->CheckAndInstrument(itr);
 				}
 			}
 		}
+
+		if (FuseBlocks) {
+			for (Function::iterator BB = F.begin(), e = F.end(); BB != e; ++BB) {
+				fuser.collect((BasicBlock*)BB, original);
+			}
+		}
 		return true;
 	}
 
@@ -333,7 +461,71 @@ struct MonitorPass : public FunctionPass {
 		return Instrumentation::GetInstance()->Initialize(M);
 	}
 
+	/*
+	 * Emit the flattened layout of every struct type used by the callbacks as
+	 * module constants, and register them at the start of main.
+	 */
+	void registerTypeLayouts(Module& M) {
+		Instrumentation* instrumentation = Instrumentation::GetInstance();
+		Instrumenter* instrumenter = new Instrumenter("", instrumentation);
+		BasicBlock* firstBlock = &M.getFunction("main")->getEntryBlock();
+		InstrPtrVector instrs;
+
+		for (unsigned id = 0; id < instrumentation->layouts.size(); id++) {
+			StructType* structType = instrumentation->layouts[id];
+			vector<KIND> kinds;
+			vector<Constant*> kindsC, offsetsC, fieldStartsC;
+			unsigned offset = 0;
+
+			// element kinds and byte offsets
+			instrumenter->FlattenType(structType, kinds);
+			for (unsigned i = 0; i < kinds.size(); i++) {
+				kindsC.push_back(instrumenter->KIND_CONSTANT(kinds[i]));
+				offsetsC.push_back(instrumenter->INT32_CONSTANT(offset, NOSIGN));
+				offset += KIND_GetSize(kinds[i]);
+			}
+
+			// element index of each top-level field
+			vector<KIND> fieldKinds;
+			for (unsigned i = 0; i < structType->getNumElements(); i++) {
+				fieldStartsC.push_back(instrumenter->INT32_CONSTANT(fieldKinds.size(), NOSIGN));
+				instrumenter->FlattenType(structType->getElementType(i), fieldKinds);
+			}
+
+			Constant* kindsG = instrumenter->CONSTANT_ARRAY(instrumenter->KIND_TYPE(), kindsC, "llvm_layout_kinds");
+			Constant* offsetsG = instrumenter->CONSTANT_ARRAY(instrumenter->INT32_TYPE(), offsetsC, "llvm_layout_offsets");
+			Constant* fieldStartsG =
+				instrumenter->CONSTANT_ARRAY(instrumenter->INT32_TYPE(), fieldStartsC, "llvm_layout_fields");
+
+			ValuePtrVector args;
+			args.push_back(instrumenter->INT32_CONSTANT(id, SIGNED));
+			args.push_back(instrumenter->INT32_CONSTANT(kinds.size(), SIGNED));
+			args.push_back(kindsG);
+			args.push_back(offsetsG);
+			args.push_back(instrumenter->INT32_CONSTANT(fieldStartsC.size(), SIGNED));
+			args.push_back(fieldStartsG);
+
+			TypePtrVector argTypes;
+			argTypes.push_back(instrumenter->INT32_TYPE());
+			argTypes.push_back(instrumenter->INT32_TYPE());
+			argTypes.push_back(kindsG->getType());
+			argTypes.push_back(offsetsG->getType());
+			argTypes.push_back(instrumenter->INT32_TYPE());
+			argTypes.push_back(fieldStartsG->getType());
+
+			Instruction* call =
+				instrumenter->CALL_INSTR("llvm_register_type_layout", instrumenter->VOID_FUNC_TYPE(argTypes), args);
+			instrs.push_back(call);
+		}
+
+		instrumenter->InsertAllBefore(instrs, firstBlock->getTerminator());
+		delete instrumenter;
+	}
+
 	bool doFinalization(Module& M) {
+		registerTypeLayouts(M);
+		fuser.finalize(M);
+
 		// printing filenames
 		Instrumentation* instrumentation = Instrumentation::GetInstance();
 		instrumentation->WriteDebugMap(FileName);
@@ -79,7 +79,7 @@ void BlameTreeFloat::setShadowObject(SCOPE scope, int64_t inx, BlameTreeShadowOb
 		if (scope == GLOBAL) {
 			iv = globalSymbolTable[inx];
 		} else {
-			iv = executionStack.top()[inx];
+			iv = state().executionStack.top()[inx];
 		}
 		iv->setShadow(shadowObject);
 	}
@@ -95,7 +95,7 @@ BlameTreeShadowObject<HIGHPRECISION>* BlameTreeFloat::getShadowObject(SCOPE scop
 		if (scope == GLOBAL) {
 			iv = globalSymbolTable[inx];
 		} else {
-			iv = executionStack.top()[inx];
+			iv = state().executionStack.top()[inx];
 		}
 		return (BlameTreeShadowObject<HIGHPRECISION>*)iv->getShadow();
 	}
@@ -115,7 +115,7 @@ HIGHPRECISION BlameTreeFloat::getShadowValue(SCOPE scope, int64_t inx, PRECISION
 		if (scope == GLOBAL) {
 			iv = globalSymbolTable[inx];
 		} else {
-			iv = executionStack.top()[inx];
+			iv = state().executionStack.top()[inx];
 		}
 
 		if (iv->getShadow() == NULL) {
@@ -140,7 +140,7 @@ HIGHPRECISION BlameTreeFloat::getActualValue(SCOPE scope, int64_t value) {
 	} else {
 		IValue* iv;
 
-		iv = (scope == GLOBAL) ? globalSymbolTable[value] : executionStack.top()[value];
+		iv = (scope == GLOBAL) ? globalSymbolTable[value] : state().executionStack.top()[value];
 		actualValue = iv->getFlpValue();
 	}
 
@@ -160,7 +160,7 @@ void BlameTreeFloat::post_call_sin(IID iid UNUSED, bool nounwind UNUSED, int pc,
 	// Obtain actual values and shadow values
 	//
 	arg = getActualValue(argScope, argValueOrIndex);
-	result = executionStack.top()[inx]->getFlpValue();
+	result = state().executionStack.top()[inx]->getFlpValue();
 
 	shadow = getShadowObject(argScope, argValueOrIndex);
 
@@ -199,7 +199,7 @@ void BlameTreeFloat::post_call_sin(IID iid UNUSED, bool nounwind UNUSED, int pc,
 	// creating shadow object for the result
 	BlameTreeShadowObject<HIGHPRECISION>* resultShadow =
 		new BlameTreeShadowObject<HIGHPRECISION>(0, pc, 0, dynamicCounter, CALL_INTR, BINOP_INVALID, "sin", values);
-	executionStack.top()[inx]->setShadow(resultShadow);
+	state().executionStack.top()[inx]->setShadow(resultShadow);
 
 	// adding to the trace
 	trace[dynamicCounter].push_back(*resultShadow);
@@ -220,7 +220,7 @@ void BlameTreeFloat::post_call_acos(IID iid UNUSED, bool nounwind UNUSED, int pc
 	// Obtain actual values and shadow values
 	//
 	arg = getActualValue(argScope, argValueOrIndex);
-	result = executionStack.top()[inx]->getFlpValue();
+	result = state().executionStack.top()[inx]->getFlpValue();
 
 	shadow = getShadowObject(argScope, argValueOrIndex);
 
@@ -259,7 +259,7 @@ void BlameTreeFloat::post_call_acos(IID iid UNUSED, bool nounwind UNUSED, int pc
 	// creating shadow object for the result
 	BlameTreeShadowObject<HIGHPRECISION>* resultShadow =
 		new BlameTreeShadowObject<HIGHPRECISION>(0, pc, 0, dynamicCounter, CALL_INTR, BINOP_INVALID, "acos", values);
-	executionStack.top()[inx]->setShadow(resultShadow);
+	state().executionStack.top()[inx]->setShadow(resultShadow);
 
 	// adding to the trace
 	trace[dynamicCounter].push_back(*resultShadow);
@@ -280,7 +280,7 @@ void BlameTreeFloat::post_call_sqrt(IID iid UNUSED, bool nounwind UNUSED, int pc
 	// Obtain actual values and shadow values
 	//
 	arg = getActualValue(argScope, argValueOrIndex);
-	result = executionStack.top()[inx]->getFlpValue();
+	result = state().executionStack.top()[inx]->getFlpValue();
 
 	shadow = getShadowObject(argScope, argValueOrIndex);
 
@@ -319,7 +319,7 @@ void BlameTreeFloat::post_call_sqrt(IID iid UNUSED, bool nounwind UNUSED, int pc
 	// creating shadow object for the result
 	BlameTreeShadowObject<HIGHPRECISION>* resultShadow =
 		new BlameTreeShadowObject<HIGHPRECISION>(0, pc, 0, dynamicCounter, CALL_INTR, BINOP_INVALID, "sqrt", values);
-	executionStack.top()[inx]->setShadow(resultShadow);
+	state().executionStack.top()[inx]->setShadow(resultShadow);
 
 	// adding to the trace
 	trace[dynamicCounter].push_back(*resultShadow);
@@ -341,7 +341,7 @@ void BlameTreeFloat::post_call_fabs(IID iid UNUSED, bool nounwind UNUSED, int pc
 	// Obtain actual values and shadow values
 	//
 	arg = getActualValue(argScope, argValueOrIndex);
-	result = executionStack.top()[inx]->getFlpValue();
+	result = state().executionStack.top()[inx]->getFlpValue();
 
 	shadow = getShadowObject(argScope, argValueOrIndex);
 
@@ -380,7 +380,7 @@ void BlameTreeFloat::post_call_fabs(IID iid UNUSED, bool nounwind UNUSED, int pc
 	// creating shadow object for the result
 	BlameTreeShadowObject<HIGHPRECISION>* resultShadow =
 		new BlameTreeShadowObject<HIGHPRECISION>(0, pc, 0, dynamicCounter, CALL_INTR, BINOP_INVALID, "fabs", values);
-	executionStack.top()[inx]->setShadow(resultShadow);
+	state().executionStack.top()[inx]->setShadow(resultShadow);
 
 	// adding to the trace
 	trace[dynamicCounter].push_back(*resultShadow);
@@ -401,7 +401,7 @@ void BlameTreeFloat::post_call_cos(IID iid UNUSED, bool nounwind UNUSED, int pc,
 	// Obtain actual values and shadow values
 	//
 	arg = getActualValue(argScope, argValueOrIndex);
-	result = executionStack.top()[inx]->getFlpValue();
+	result = state().executionStack.top()[inx]->getFlpValue();
 
 	shadow = getShadowObject(argScope, argValueOrIndex);
 
@@ -440,7 +440,7 @@ void BlameTreeFloat::post_call_cos(IID iid UNUSED, bool nounwind UNUSED, int pc,
 	// creating shadow object for the result
 	BlameTreeShadowObject<HIGHPRECISION>* resultShadow =
 		new BlameTreeShadowObject<HIGHPRECISION>(0, pc, 0, dynamicCounter, CALL_INTR, BINOP_INVALID, "cos", values);
-	executionStack.top()[inx]->setShadow(resultShadow);
+	state().executionStack.top()[inx]->setShadow(resultShadow);
 
 	// adding to the trace
 	trace[dynamicCounter].push_back(*resultShadow);
@@ -534,7 +534,7 @@ void BlameTreeFloat::post_fbinop(SCOPE lScope, SCOPE rScope, int64_t lValue, int
 	}
 
 	// truncate result depending on precision
-	values[BITS_DOUBLE] = executionStack.top()[inx]->getFlpValue();
+	values[BITS_DOUBLE] = state().executionStack.top()[inx]->getFlpValue();
 	values[BITS_FLOAT] = sresult;
 	for (i = PRECISION(BITS_FLOAT + 1); i < BITS_DOUBLE; i = PRECISION(i + 1)) {
 		values[i] = BlameTreeUtilities::clearBits(values[BITS_DOUBLE], 52 - BlameTreeUtilities::exactBits(i));
@@ -543,7 +543,7 @@ void BlameTreeFloat::post_fbinop(SCOPE lScope, SCOPE rScope, int64_t lValue, int
 	// creating shadow object for target
 	BlameTreeShadowObject<HIGHPRECISION>* resultShadow =
 		new BlameTreeShadowObject<HIGHPRECISION>(file, line, col, dynamicCounter, BIN_INTR, op, "NONE", values);
-	executionStack.top()[inx]->setShadow(resultShadow);
+	state().executionStack.top()[inx]->setShadow(resultShadow);
 
 	// adding to the trace
 	trace[dynamicCounter].push_back(*resultShadow);
@@ -580,7 +580,7 @@ void BlameTreeFloat::post_fptrunc(int64_t op, SCOPE opScope, KIND opKind UNUSED,
 
 	if (opbtSO) {
 		BlameTreeShadowObject<HIGHPRECISION>* btSO = new BlameTreeShadowObject<HIGHPRECISION>(*opbtSO);
-		executionStack.top()[inx]->setShadow(btSO);
+		state().executionStack.top()[inx]->setShadow(btSO);
 	}
 }
 
@@ -590,7 +590,7 @@ void BlameTreeFloat::post_fpext(int64_t op, SCOPE opScope, KIND opKind UNUSED, K
 
 	if (opbtSO) {
 		BlameTreeShadowObject<HIGHPRECISION>* btSO = new BlameTreeShadowObject<HIGHPRECISION>(*opbtSO);
-		executionStack.top()[inx]->setShadow(btSO);
+		state().executionStack.top()[inx]->setShadow(btSO);
 	}
 }
 
@@ -133,6 +133,97 @@ struct kvalue_t {
 } __attribute__((__aligned__(KVALUE_ALIGNMENT)));
 #define KVALUE kvalue_t
 
+// Static description of an argument of an interpreted call. The pass emits
+// the arguments of each call site as a constant array of these.
+struct callarg_t {
+	INT32 inx;  // index of the argument, or -1 for a constant
+	INT32 scope;  // scope of the argument
+	KIND kind;
+	VALUE value;  // value of a constant argument
+};
+#define CALLARG callarg_t
+
+// Static description of an incoming value of a phi node. The pass emits the
+// incoming values of each phi node as a constant array of these.
+struct phiarg_t {
+	INT32 block;  // index of the incoming block
+	INT32 inx;  // index of the incoming value, or -1 for a constant
+	KIND kind;
+	VALUE value;  // value of a constant incoming value
+};
+#define PHIARG phiarg_t
+
+// Index operand of a getelementptr whose value is not a constant integer.
+struct gepindex_t {
+	INT32 scope;  // scope of the operand
+	INT valOrInx;  // register or global index of the operand, or its value
+	INT stride;  // bytes per unit of the index
+};
+#define GEPINDEX gepindex_t
+
+// Callbacks that MonitorPass -fuseBlocks may move into the handler of a run
+// of straight-line code, without their llvm_ prefix. They return nothing and
+// take integer, floating-point and pointer arguments only.
+#define BLOCK_CALLBACKS(CALLBACK)                                                                                      \
+	CALLBACK(record_block_id)                                                                                          \
+	CALLBACK(phinode)                                                                                                  \
+	CALLBACK(phinode_table)                                                                                            \
+	CALLBACK(push_phinode_constant_value)                                                                              \
+	CALLBACK(push_phinode_value)                                                                                       \
+	CALLBACK(sync_register)                                                                                            \
+	CALLBACK(allocax)                                                                                                  \
+	CALLBACK(allocax_array)                                                                                            \
+	CALLBACK(allocax_struct)                                                                                           \
+	CALLBACK(load)                                                                                                     \
+	CALLBACK(load_struct)                                                                                              \
+	CALLBACK(push_type_layout)                                                                                         \
+	CALLBACK(push_struct_type)                                                                                         \
+	CALLBACK(push_struct_element_size)                                                                                 \
+	CALLBACK(push_getelementptr_inx)                                                                                   \
+	CALLBACK(push_getelementptr_inx2)                                                                                  \
+	CALLBACK(push_getelementptr_inx5)                                                                                  \
+	CALLBACK(push_array_size)                                                                                          \
+	CALLBACK(push_array_size5)                                                                                         \
+	CALLBACK(getelementptr)                                                                                            \
+	CALLBACK(getelementptr_array)                                                                                      \
+	CALLBACK(getelementptr_strided)                                                                                    \
+	CALLBACK(getelementptr_struct)                                                                                     \
+	CALLBACK(extractvalue)                                                                                             \
+	CALLBACK(add)                                                                                                      \
+	CALLBACK(fadd)                                                                                                     \
+	CALLBACK(sub)                                                                                                      \
+	CALLBACK(fsub)                                                                                                     \
+	CALLBACK(mul)                                                                                                      \
+	CALLBACK(fmul)                                                                                                     \
+	CALLBACK(udiv)                                                                                                     \
+	CALLBACK(sdiv)                                                                                                     \
+	CALLBACK(fdiv)                                                                                                     \
+	CALLBACK(urem)                                                                                                     \
+	CALLBACK(srem)                                                                                                     \
+	CALLBACK(frem)                                                                                                     \
+	CALLBACK(shl)                                                                                                      \
+	CALLBACK(lshr)                                                                                                     \
+	CALLBACK(ashr)                                                                                                     \
+	CALLBACK(and_)                                                                                                     \
+	CALLBACK(or_)                                                                                                      \
+	CALLBACK(xor_)                                                                                                     \
+	CALLBACK(trunc)                                                                                                    \
+	CALLBACK(zext)                                                                                                     \
+	CALLBACK(sext)                                                                                                     \
+	CALLBACK(fptrunc)                                                                                                  \
+	CALLBACK(fpext)                                                                                                    \
+	CALLBACK(fptoui)                                                                                                   \
+	CALLBACK(fptosi)                                                                                                   \
+	CALLBACK(uitofp)                                                                                                   \
+	CALLBACK(sitofp)                                                                                                   \
+	CALLBACK(ptrtoint)                                                                                                 \
+	CALLBACK(inttoptr)                                                                                                 \
+	CALLBACK(bitcast)                                                                                                  \
+	CALLBACK(icmp)                                                                                                     \
+	CALLBACK(fcmp)                                                                                                     \
+	CALLBACK(select)                                                                                                   \
+	CALLBACK(push_stack)
+
 struct DebugInfo {
 	int line;
 	int column;
@@ -194,6 +194,12 @@ void EmptyObserver::getelementptr_array(
 	int64_t valOrInx03 UNUSED, int size01 UNUSED, int size02 UNUSED,
 	int inx UNUSED) {}
 
+void EmptyObserver::getelementptr_strided(
+	int baseInx UNUSED, SCOPE baseScope UNUSED, uint64_t baseAddr UNUSED,
+	int elementSize UNUSED, int ptrScope UNUSED, int64_t ptrValOrInx UNUSED,
+	int64_t constOffset UNUSED, int count UNUSED,
+	const GEPINDEX* indices UNUSED, int inx UNUSED) {}
+
 void EmptyObserver::getelementptr_struct(IID iid UNUSED, int baseInx UNUSED,
 		SCOPE baseScope UNUSED,
 		uint64_t baseAddr UNUSED,
@@ -290,6 +296,9 @@ void EmptyObserver::fcmp(SCOPE lScope UNUSED, SCOPE rScope UNUSED,
 
 void EmptyObserver::phinode(IID iid UNUSED, int inx UNUSED) {}
 
+void EmptyObserver::phinode_table(IID iid UNUSED, int count UNUSED,
+								  const PHIARG* incoming UNUSED, int inx UNUSED) {}
+
 void EmptyObserver::select(IID iid UNUSED, KVALUE* cond UNUSED,
 						   KVALUE* tvalue UNUSED, KVALUE* fvalue UNUSED,
 						   int inx UNUSED) {}
@@ -310,6 +319,11 @@ void EmptyObserver::push_struct_type(KIND kind UNUSED) {}
 
 void EmptyObserver::push_struct_element_size(uint64_t s UNUSED) {}
 
+void EmptyObserver::register_type_layout(int id UNUSED, int length UNUSED, const KIND* kinds UNUSED,
+		const unsigned* offsets UNUSED, int fields UNUSED, const unsigned* fieldStarts UNUSED) {}
+
+void EmptyObserver::push_type_layout(int id UNUSED) {}
+
 void EmptyObserver::push_getelementptr_inx(uint64_t value UNUSED) {}
 
 void EmptyObserver::push_getelementptr_inx5(
@@ -341,6 +355,8 @@ void EmptyObserver::create_global_symbol_table(int size UNUSED) {}
 
 void EmptyObserver::record_block_id(int id UNUSED) {}
 
+void EmptyObserver::sync_register(int inx UNUSED, KIND type UNUSED, int64_t value UNUSED) {}
+
 void EmptyObserver::create_global(KVALUE* kvalue UNUSED,
 								  KVALUE* initializer UNUSED) {}
 
@@ -356,6 +372,19 @@ void EmptyObserver::call_malloc(IID iid UNUSED, bool nounwind UNUSED,
 								int inx UNUSED, uint64_t mallocAddress UNUSED) {
 }
 
+void EmptyObserver::call_calloc(IID iid UNUSED, bool nounwind UNUSED,
+								KIND type UNUSED, int size UNUSED,
+								int inx UNUSED, uint64_t callocAddress UNUSED) {
+}
+
+void EmptyObserver::call_realloc(IID iid UNUSED, bool nounwind UNUSED,
+								 KIND type UNUSED, int size UNUSED,
+								 int inx UNUSED, uint64_t reallocAddress UNUSED) {
+}
+
+void EmptyObserver::call_free(IID iid UNUSED, bool nounwind UNUSED) {
+}
+
 void EmptyObserver::call_sin(IID iid UNUSED, bool nounwind UNUSED,
 							 IID argIID UNUSED, KIND type UNUSED,
 							 int inx UNUSED) {}
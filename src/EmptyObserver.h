@@ -163,6 +163,12 @@ public:
 									 int64_t valOrInx02, int64_t valOrInx03,
 									 int size01, int size02, int inx);
 
+	virtual void getelementptr_strided(int baseInx, SCOPE baseScope,
+									   uint64_t baseAddr, int elementSize,
+									   int ptrScope, int64_t ptrValOrInx,
+									   int64_t constOffset, int count,
+									   const GEPINDEX* indices, int inx);
+
 	virtual void getelementptr_struct(IID iid, int baseInx, SCOPE baseScope,
 									  uint64_t baseAddr, int inx);
 
@@ -235,6 +241,8 @@ public:
 
 	virtual void phinode(IID iid, int inx);
 
+	virtual void phinode_table(IID iid, int count, const PHIARG* incoming, int inx);
+
 	virtual void select(IID iid, KVALUE* cond, KVALUE* tvalue, KVALUE* fvalue,
 						int inx);
 
@@ -243,6 +251,14 @@ public:
 	virtual void call_malloc(IID iid, bool nounwind, KIND type, int size, int inx,
 							 uint64_t mallocAddress);
 
+	virtual void call_calloc(IID iid, bool nounwind, KIND type, int size, int inx,
+							 uint64_t callocAddress);
+
+	virtual void call_realloc(IID iid, bool nounwind, KIND type, int size, int inx,
+							  uint64_t reallocAddress);
+
+	virtual void call_free(IID iid, bool nounwind);
+
 	virtual void call_sin(IID iid, bool nounwind, IID argIID, KIND type, int inx);
 
 	virtual void call_acos(IID iid, bool nounwind, IID argIID, KIND type,
@@ -279,6 +295,11 @@ public:
 
 	void push_struct_element_size(uint64_t size);
 
+	void register_type_layout(int id, int length, const KIND* kinds, const unsigned* offsets, int fields,
+							  const unsigned* fieldStarts);
+
+	void push_type_layout(int id);
+
 	void push_getelementptr_inx(uint64_t value);
 
 	void push_getelementptr_inx5(int scope01, int scope02, int scope03,
@@ -307,6 +328,8 @@ public:
 
 	void record_block_id(int id);
 
+	void sync_register(int inx, KIND type, int64_t value);
+
 	void create_global(KVALUE* value, KVALUE* initializer);
 
 	void create_global_array(int valInx, uint64_t addr, uint32_t size, KIND type);
@@ -0,0 +1,220 @@
+/**
+ * @file ExecutionStack.h
+ * @brief Arena-backed stack of interpreter frames
+ */
+
+/*
+ * Copyright (c) 2013, UC Berkeley All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. All advertising materials mentioning features or use of this software must
+ * display the following acknowledgement: This product includes software
+ * developed by the UC Berkeley.
+ *
+ * 4. Neither the name of the UC Berkeley nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY UC BERKELEY ''AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL UC BERKELEY BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Author: Cuong Nguyen and Cindy Rubio-Gonzalez
+
+#ifndef EXECUTION_STACK_H_
+#define EXECUTION_STACK_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+#include "IValue.h"
+
+/**
+ * Registers of one function invocation. The frame owns a contiguous block of
+ * IValues, one per register, and a parallel array of slots that initially
+ * point to them. Most registers are written in place through operator[].
+ *
+ * A register holding a whole struct (a loaded struct or a struct returned by
+ * a call) is a heap array of IValues, one per field, and extractvalue reads
+ * field i at operator[](inx) + i; OutOfBoundAnalysis likewise replaces
+ * registers with heap IValues carrying its shadow. Those are installed with
+ * redirect() and are not owned by the frame, which is why the slots stay.
+ */
+class Frame {
+	friend class ExecutionStack;
+
+public:
+	IValue* operator[](size_t inx) const {
+		return slots[inx];
+	}
+
+	/**
+	 * Point register inx at value. The previous value is not released.
+	 */
+	void redirect(size_t inx, IValue* value) {
+		slots[inx] = value;
+	}
+
+	size_t size() const {
+		return size_;
+	}
+
+	/**
+	 * Whether value is the frame's own storage and must not be deleted.
+	 */
+	bool owns(const IValue* value) const {
+		return value >= values && value < values + size_;
+	}
+
+private:
+	IValue** slots;
+	IValue* values;
+	size_t size_;
+	size_t chunk, mark;  // arena position before the frame was pushed
+};
+
+/**
+ * Stack of frames carved out of a bump-pointer arena. Pushing a frame takes
+ * one block from the current chunk, popping it rewinds the bump pointer, so
+ * calls and returns do not go through the allocator. Chunks are kept for
+ * reuse once allocated.
+ */
+class ExecutionStack {
+public:
+	ExecutionStack() : chunk(0), used(0) {}
+
+	~ExecutionStack() {
+		while (!empty()) {
+			pop();
+		}
+	}
+
+	ExecutionStack(const ExecutionStack&) = delete;
+	ExecutionStack& operator=(const ExecutionStack&) = delete;
+
+	/**
+	 * Push a frame of size registers, all default constructed.
+	 */
+	Frame& push(size_t size) {
+		size_t slotBytes = align(size * sizeof(IValue*));
+		size_t bytes = slotBytes + size * sizeof(IValue);
+		if (chunks.empty() || used + bytes > chunks[chunk].size) {
+			grow(bytes);
+		}
+
+		char* base = chunks[chunk].data.get() + used;
+		Frame frame;
+		frame.slots = reinterpret_cast<IValue**>(base);
+		frame.values = reinterpret_cast<IValue*>(base + slotBytes);
+		frame.size_ = size;
+		frame.chunk = chunk;
+		frame.mark = used;
+		for (size_t i = 0; i < size; i++) {
+			frame.slots[i] = new (&frame.values[i]) IValue();
+		}
+		used += bytes;
+
+		frames.push_back(frame);
+		return frames.back();
+	}
+
+	/**
+	 * Destroy the top frame's own values and release its block.
+	 */
+	void pop() {
+		Frame& frame = frames.back();
+		for (size_t i = 0; i < frame.size_; i++) {
+			frame.values[i].~IValue();
+		}
+		chunk = frame.chunk;
+		used = frame.mark;
+		frames.pop_back();
+	}
+
+	Frame& top() {
+		return frames.back();
+	}
+
+	/**
+	 * The frame below the top one, i.e. the frame of the caller.
+	 */
+	Frame& caller() {
+		return frames[frames.size() - 2];
+	}
+
+	/**
+	 * The frame at depth, counted from the bottom of the stack.
+	 */
+	Frame& frame(size_t depth) {
+		return frames[depth];
+	}
+
+	bool empty() const {
+		return frames.empty();
+	}
+
+	size_t size() const {
+		return frames.size();
+	}
+
+private:
+	static const size_t CHUNK_SIZE = 1 << 20;
+
+	struct Chunk {
+		std::unique_ptr<char[]> data;
+		size_t size;
+
+		Chunk() : size(0) {}
+	};
+
+	static size_t align(size_t bytes) {
+		return (bytes + alignof(IValue) - 1) / alignof(IValue) * alignof(IValue);
+	}
+
+	/**
+	 * Move to the next chunk, allocating it if it does not exist yet or is too
+	 * small to hold bytes.
+	 */
+	void grow(size_t bytes) {
+		if (!chunks.empty()) {
+			chunk++;
+		}
+		if (chunk == chunks.size()) {
+			chunks.push_back(Chunk());
+		}
+		if (chunks[chunk].size < bytes) {
+			size_t size = std::max(bytes, size_t(CHUNK_SIZE));  // by value: CHUNK_SIZE has no definition
+			chunks[chunk].data.reset(new char[size]);
+			chunks[chunk].size = size;
+		}
+		used = 0;
+	}
+
+	std::vector<Chunk> chunks;
+	size_t chunk;  // chunk holding the top frame
+	size_t used;  // bytes of that chunk in use
+	std::vector<Frame> frames;
+};
+
+#endif // EXECUTION_STACK_H_
@@ -83,7 +83,7 @@ long double FPBackwardAnalysis::getShadowValue(SCOPE scope, int64_t value) {
 	} else {
 		IValue* iv;
 
-		iv = (scope == GLOBAL) ? globalSymbolTable[value] : executionStack.top()[value];
+		iv = (scope == GLOBAL) ? globalSymbolTable[value] : state().executionStack.top()[value];
 		result = iv->getShadow() == NULL ? (long double)iv->getFlpValue() :
 				 ((FPBackwardShadowObject*)iv->getShadow())->getValue();
 	}
@@ -102,7 +102,7 @@ long double FPBackwardAnalysis::getConcreteValue(SCOPE scope, int64_t value) {
 	} else {
 		IValue* iv;
 
-		iv = (scope == GLOBAL) ? globalSymbolTable[value] : executionStack.top()[value];
+		iv = (scope == GLOBAL) ? globalSymbolTable[value] : state().executionStack.top()[value];
 		result = iv->getFlpValue();
 	}
 
@@ -117,7 +117,7 @@ int FPBackwardAnalysis::getLineNumber(SCOPE scope, int64_t value) {
 	} else {
 		IValue* iv;
 
-		iv = (scope == GLOBAL) ? globalSymbolTable[value] : executionStack.top()[value];
+		iv = (scope == GLOBAL) ? globalSymbolTable[value] : state().executionStack.top()[value];
 		if (iv->getShadow() != NULL) {
 			line = ((FPBackwardShadowObject*)iv->getShadow())->getLine();
 		} else {
@@ -133,8 +133,8 @@ int FPBackwardAnalysis::getLineNumber(SCOPE scope, int64_t value) {
 /******** ANALYSIS FUNCTIONS **********/
 
 void FPBackwardAnalysis::pre_analysis(int inx) {
-	if (executionStack.top()[inx]->getShadow() != NULL) {
-		preFpISO = (FPBackwardShadowObject*)executionStack.top()[inx]->getShadow();
+	if (state().executionStack.top()[inx]->getShadow() != NULL) {
+		preFpISO = (FPBackwardShadowObject*)state().executionStack.top()[inx]->getShadow();
 	} else {
 		preFpISO = new FPBackwardShadowObject(0, 0);
 	}
@@ -191,13 +191,13 @@ void FPBackwardAnalysis::post_fbinop(SCOPE lScope, SCOPE rScope, int64_t lValue,
 	//
 	// Construct shadow value for the result shadow object.
 	//
-	if (executionStack.top()[inx]->getShadow() == NULL) {
+	if (state().executionStack.top()[inx]->getShadow() == NULL) {
 		fpISO = new FPBackwardShadowObject(sresult, line);
 	} else {
-		fpISO = (FPBackwardShadowObject*)executionStack.top()[inx]->getShadow();
+		fpISO = (FPBackwardShadowObject*)state().executionStack.top()[inx]->getShadow();
 	}
-	cout << "\tConcrete result: " << executionStack.top()[inx]->getFlpValue() << endl;
-	cout << "\tAbsolute error: " << fabs(sresult - executionStack.top()[inx]->getFlpValue()) << endl;
+	cout << "\tConcrete result: " << state().executionStack.top()[inx]->getFlpValue() << endl;
+	cout << "\tAbsolute error: " << fabs(sresult - state().executionStack.top()[inx]->getFlpValue()) << endl;
 
 	cout << "====";
 	fpISO->print();
@@ -205,7 +205,7 @@ void FPBackwardAnalysis::post_fbinop(SCOPE lScope, SCOPE rScope, int64_t lValue,
 	delete (preFpISO);
 	preFpISO = NULL;
 
-	executionStack.top()[inx]->setShadow(fpISO);
+	state().executionStack.top()[inx]->setShadow(fpISO);
 	return;
 }
 
@@ -41,6 +41,12 @@
 // Author: Cuong Nguyen and Cindy Rubio-Gonzalez
 
 #include "IValue.h"
+#include "ShadowMemory.h"
+
+#include <algorithm>
+#include <climits>
+#include <mutex>
+#include <vector>
 
 using namespace std;
 
@@ -51,6 +57,83 @@ function<void(void*)> IValue::deleteShadow = [](void* a) {
 	delete static_cast<char*>(a);
 };  // dangerous!
 
+IValueInfo* IValue::infoChunks[1U << (32 - IValue::INFO_CHUNK_BITS)];
+
+namespace {
+
+// IValueInfo handles are handed to threads in batches, and a released handle
+// goes to the free list of the thread releasing it, so the common case does
+// not synchronize. The shared pool is only touched when a thread's list runs
+// empty or overflows. The per-thread state is trivially destructible so that
+// IValues can still be destroyed after thread-local destructors have run;
+// the handles a thread holds when it exits are not returned.
+const unsigned INFO_BATCH = 256;
+const unsigned INFO_CACHE = 4 * INFO_BATCH;
+
+struct InfoPool {
+	std::mutex lock;
+	uint32_t used = 0;
+	std::vector<uint32_t> released;
+};
+
+struct InfoCache {
+	uint32_t released[INFO_CACHE];
+	unsigned count;
+	uint32_t next, end;  // unused handles of the last batch
+};
+
+thread_local InfoCache infoCache;
+
+InfoPool& infoPool() {
+	static InfoPool* pool = new InfoPool();  // never destroyed, see above
+	return *pool;
+}
+
+}
+
+uint32_t IValue::newInfo(const IValueInfo& info) {
+	InfoCache& cache = infoCache;
+	if (cache.count == 0 && cache.next == cache.end) {
+		InfoPool& pool = infoPool();
+		std::lock_guard<std::mutex> guard(pool.lock);
+		if (!pool.released.empty()) {
+			unsigned n = std::min<size_t>(INFO_BATCH, pool.released.size());
+			std::copy(pool.released.end() - n, pool.released.end(), cache.released);
+			pool.released.resize(pool.released.size() - n);
+			cache.count = n;
+		} else {
+			safe_assert(pool.used <= UINT32_MAX - INFO_BATCH);
+			cache.next = pool.used;
+			cache.end = pool.used += INFO_BATCH;
+			// batches never straddle a chunk
+			if (!infoChunks[cache.next >> INFO_CHUNK_BITS]) {
+				infoChunks[cache.next >> INFO_CHUNK_BITS] = new IValueInfo[1U << INFO_CHUNK_BITS];
+			}
+		}
+	}
+	uint32_t handle = cache.count > 0 ? cache.released[--cache.count] : cache.next++;
+	infoChunks[handle >> INFO_CHUNK_BITS][handle & ((1U << INFO_CHUNK_BITS) - 1)] = info;
+	return handle;
+}
+
+void IValue::deleteInfo(uint32_t handle) {
+	InfoCache& cache = infoCache;
+	if (cache.count == INFO_CACHE) {
+		InfoPool& pool = infoPool();
+		std::lock_guard<std::mutex> guard(pool.lock);
+		pool.released.insert(pool.released.end(), cache.released + INFO_CACHE - INFO_BATCH,
+							 cache.released + INFO_CACHE);
+		cache.count -= INFO_BATCH;
+	}
+	cache.released[cache.count++] = handle;
+}
+
+void IValue::releaseCells() {
+	IValue* cells = (IValue*)((int64_t)value.as_ptr + getValueOffset());
+	ShadowMemory::get().unmapBlock(value.as_int, cells, getLength());
+	delete[] cells;
+}
+
 // long IValue::counterNew = 0;
 // long IValue::counterDelete = 0;
 
@@ -84,7 +167,7 @@ string IValue::toString() const {
 			break;
 		case INT1_KIND:
 			s << "[INT1: " << value.as_int << "] ";
-			s << ", bitOffset: " << bitOffset;
+			s << ", bitOffset: " << getBitOffset();
 			break;
 		case INT8_KIND:
 			s << "[INT8: " << value.as_int << "]";
@@ -119,14 +202,14 @@ string IValue::toString() const {
 			break;
 	}
 
-	s << ", Size: " << size;
-	s << ", Offset: " << offset;
-	s << ", BitOffset: " << bitOffset;
-	s << ", Index: " << index;
-	s << ", FirstByte: " << firstByte;
-	s << ", Length: " << length;
+	s << ", Size: " << getSize();
+	s << ", Offset: " << getOffset();
+	s << ", BitOffset: " << getBitOffset();
+	s << ", Index: " << getIndex();
+	s << ", FirstByte: " << getFirstByte();
+	s << ", Length: " << getLength();
 	s << ", Initialized: " << isInitialized();
-	s << ", ValueOffset: " << valueOffset;
+	s << ", ValueOffset: " << getValueOffset();
 
 	return s.str();
 }
@@ -135,12 +218,8 @@ void IValue::copy(IValue* dest) const {
 	// note: we do never overwrite the field firstByte
 	dest->setType(type);
 	dest->setValue(value);
-	dest->setSize(size);
-	dest->setOffset(offset);
-	dest->setBitOffset(bitOffset);
-	dest->setIndex(index);
-	dest->setLength(length);
-	dest->setValueOffset(valueOffset);
+	dest->setBitOffset(getBitOffset());
+	dest->assignInfo(*this, dest->getFirstByte());
 	deleteShadow(dest->shadow);
 	dest->shadow = copyShadow(shadow);
 	return;
@@ -163,7 +242,7 @@ VALUE IValue::readValue(int offset, KIND type) {
 
 	byte = KIND_GetSize(type);
 
-	if (offset == 0 && KIND_GetSize(getIPtrValue(index).getType()) == byte) {
+	if (offset == 0 && KIND_GetSize(getIPtrValue(getIndex()).getType()) == byte) {
 
 		//
 		// trivial reading case
@@ -171,7 +250,7 @@ VALUE IValue::readValue(int offset, KIND type) {
 
 		DEBUG_STDOUT("\t"
 					 << "Trivial reading.");
-		value = getIPtrValue(index).getValue();
+		value = getIPtrValue(getIndex()).getValue();
 
 	} else {
 
@@ -186,11 +265,11 @@ VALUE IValue::readValue(int offset, KIND type) {
 		int totalByte, tocInx, trcInx;
 		uint8_t* totalContent, *truncContent;
 
-		nextIndex = index;
+		nextIndex = getIndex();
 		totalByte = 0;
 
 		// TODO: review the condition nextIndex < length
-		while (totalByte < offset + byte && nextIndex < length) {
+		while (totalByte < offset + byte && nextIndex < getLength()) {
 			IValue value;
 
 			value = getIPtrValue(nextIndex);
@@ -205,7 +284,7 @@ VALUE IValue::readValue(int offset, KIND type) {
 		totalContent = (uint8_t*)malloc(totalByte * sizeof(uint8_t));
 		tocInx = 0;
 
-		for (unsigned i = index; i < nextIndex; i++) {
+		for (unsigned i = getIndex(); i < nextIndex; i++) {
 			IValue value;
 			KIND type;
 			int size;
@@ -292,12 +371,12 @@ bool IValue::writeValue(int offset, int byte, const IValue* src) {
 	bitOffset = src->getBitOffset();
 	newOffset = src->getOffset();
 
-	if (offset == 0 && KIND_GetSize(getIPtrValue(index).getType()) == byte) {
+	if (offset == 0 && KIND_GetSize(getIPtrValue(getIndex()).getType()) == byte) {
 
 		// trivial writing case
 		DEBUG_STDOUT("\t"
 					 << "Trivial writing.");
-		src->copy(&getIPtrValue(index));
+		src->copy(&getIPtrValue(getIndex()));
 
 		return true;
 
@@ -321,7 +400,7 @@ bool IValue::writeValue(int offset, int byte, const IValue* src) {
 		}
 
 		// writing the content to this value array
-		currentIndex = index;
+		currentIndex = getIndex();
 		byteWrittens = 0;
 		oldByteWrittens = 0;
 
@@ -474,15 +553,15 @@ void IValue::setAll(KIND type, VALUE value, unsigned size, int index, unsigned l
 	clearValue();
 	this->type = type;
 	this->value = value;
-	this->size = size;
-	this->offset = 0;
-	this->index = index;
-	this->length = length;
-	this->valueOffset = valueOffset;
+	setSize(size);
+	setOffset(0);
+	setIndex(index);
+	setLength(length);
+	setValueOffset(valueOffset);
 	deleteShadow(this->shadow);
 	this->shadow = NULL;
-	this->firstByte = 0;
-	this->bitOffset = 0;
+	setFirstByte(0);
+	this->bitOffset_ = 0;
 	this->scope = REGISTER;
 	return;
 }
@@ -492,13 +571,12 @@ void IValue::clear() {
 	deleteShadow(shadow);
 	shadow = NULL;
 	type = INV_KIND;
-	valueOffset = -1;
-	size = 0;
-	index = 0;
-	firstByte = 0;
-	length = 0;
-	offset = 0;
-	bitOffset = 0;
+	if (hasInfo) {
+		deleteInfo(aux);
+		hasInfo = false;
+	}
+	aux = 0;
+	bitOffset_ = 0;
 	//  scope = SCOPE_INVALID;
 	struct_ = false;
 	return;
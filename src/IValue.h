@@ -46,6 +46,17 @@
 #include <functional>
 #include "Common.h"
 
+/**
+ * Pointer and aggregate metadata of an IValue. Plain scalars, which make up
+ * almost all registers and array elements, never need it, so it is kept out
+ * of line and only allocated when one of these fields leaves its default.
+ */
+struct IValueInfo {
+	int64_t valueOffset;
+	unsigned size, index, firstByte, length;
+	int offset;
+};
+
 class IValue {
 
 private:
@@ -74,16 +85,21 @@ private:
 	 *  bitOffset: to represent data not fiting to a byte, values range from 0 to
 	7.
 	 *  scope: either a GLOBAL, LOCAL or REGISTER.
+	 *
+	 * Only value, shadow, type, scope, bitOffset and firstByte are stored in
+	 * the object itself. valueOffset, size, index, length and offset live in
+	 * an IValueInfo that is allocated the first time one of them is set to a
+	 * non-default value; firstByte then moves there as well and aux holds the
+	 * handle of the record.
 	 */
 
 	VALUE value;
 	void* shadow;
-	KIND type;
-	int64_t valueOffset;
-	unsigned size, index, firstByte, length;
-	int offset, bitOffset;
-	SCOPE scope;
-	bool struct_;
+	uint32_t aux;  // firstByte, or the IValueInfo handle if hasInfo
+	uint8_t type;
+	uint8_t scope;
+	int8_t bitOffset_;
+	uint8_t struct_ : 1;
 
 	// set to be true only when we are certain that we own
 	// the data returned by getIPtrValue()
@@ -91,7 +107,9 @@ private:
 	// unless we can PROVE that it is done safely.
 	// (note that proof should be expressed in C++
 	// not half-written somewhere else)
-	bool owns_ptr;
+	uint8_t owns_ptr : 1;
+
+	uint8_t hasInfo : 1;
 
 	// static long counterNew, counterDelete;
 
@@ -104,6 +122,68 @@ private:
 	static std::function<void* (void*)> copyShadow;
 	static std::function<void(void*)> deleteShadow;
 
+	/**
+	 * Table of IValueInfo records. Records are allocated in chunks that never
+	 * move, so a handle can be dereferenced without locking while other
+	 * threads allocate.
+	 */
+	static const unsigned INFO_CHUNK_BITS = 16;
+	static IValueInfo* infoChunks[1U << (32 - INFO_CHUNK_BITS)];
+
+	static uint32_t newInfo(const IValueInfo& info);
+	static void deleteInfo(uint32_t handle);
+
+	IValueInfo& info() const {
+		return infoChunks[aux >> INFO_CHUNK_BITS][aux & ((1U << INFO_CHUNK_BITS) - 1)];
+	}
+
+	static bool isDefault(const IValueInfo& info) {
+		return info.valueOffset == -1 && info.size == 0 && info.index == 0 && info.length == 0 && info.offset == 0;
+	}
+
+	/**
+	 * Take the pointer fields of iv, with the given firstByte. A record is
+	 * only kept while one of the fields is not at its default, so scalars
+	 * copied into array elements (or over a pointer) stay compact.
+	 */
+	void assignInfo(const IValue& iv, unsigned firstByte) {
+		if (iv.hasInfo && !isDefault(iv.info())) {
+			if (!hasInfo) {
+				aux = newInfo(iv.info());
+				hasInfo = true;
+			} else if (this != &iv) {
+				info() = iv.info();
+			}
+			info().firstByte = firstByte;
+		} else {
+			if (hasInfo) {
+				deleteInfo(aux);
+				hasInfo = false;
+			}
+			aux = firstByte;
+		}
+	}
+
+	IValueInfo& ensureInfo() {
+		if (!hasInfo) {
+			IValueInfo defaults = {-1, 0, 0, aux, 0, 0};
+			aux = newInfo(defaults);
+			hasInfo = true;
+		}
+		return info();
+	}
+
+	void initDefaults(KIND t, SCOPE s) {
+		shadow = nullptr;
+		aux = 0;
+		type = t;
+		scope = s;
+		bitOffset_ = 0;
+		struct_ = false;
+		owns_ptr = false;
+		hasInfo = false;
+	}
+
 	/**
 	 * Write a chunk of byte to value. This functions returns the actual number
 	 * of byte written.
@@ -119,15 +199,17 @@ private:
 
 public:
 	explicit IValue(KIND t, int number_of_type, void* concrete_address, KIND k = PTR_KIND, SCOPE s = REGISTER)
-		: value(concrete_address), shadow(nullptr), type(k),
-		  valueOffset(reinterpret_cast<intptr_t>(new IValue[number_of_type]) -
-					  reinterpret_cast<intptr_t>(concrete_address)),
-		  size(KIND_GetSize(t)), index(0), firstByte(0), length(number_of_type), offset(0), bitOffset(0), scope(s),
-		  struct_(false), owns_ptr(true) {
-		IValue* location = reinterpret_cast<IValue*>(reinterpret_cast<intptr_t>(value.as_ptr) + valueOffset);
+		: value(concrete_address) {
+		initDefaults(k, s);
+		IValue* location = new IValue[number_of_type];
+		IValueInfo& ptrInfo = ensureInfo();
+		ptrInfo.valueOffset = reinterpret_cast<intptr_t>(location) - reinterpret_cast<intptr_t>(concrete_address);
+		ptrInfo.size = KIND_GetSize(t);
+		ptrInfo.length = number_of_type;
+		owns_ptr = true;
 		unsigned firstByte = 0, bitOffset = 0;
 		for (int i = 0; i < number_of_type; ++i) {
-			location[i] = IValue(0, i, (firstByte + bitOffset) / 8, bitOffset % 8, t);
+			location[i] = IValue(0, i, firstByte + bitOffset / 8, bitOffset % 8, t);
 			firstByte += KIND_GetSize(t);
 			// WHY ARE WE DOUBLE INCREMENTING HERE?
 			bitOffset = (t == INT1_KIND) ? bitOffset + 1 : bitOffset;
@@ -138,16 +220,22 @@ public:
 	}
 
 	explicit IValue(const std::vector<KIND>& collection, void* concrete_address, KIND k = PTR_KIND, SCOPE s = REGISTER)
-		: value(concrete_address), shadow(nullptr), type(k),
-		  valueOffset(reinterpret_cast<intptr_t>(new IValue[collection.size()]) -
-					  reinterpret_cast<intptr_t>(concrete_address)),
-		  size(KIND_GetSize(collection.size() > 0 ? collection.front() : PTR_KIND)), index(0), firstByte(0),
-		  length(collection.size()), offset(0), bitOffset(0), scope(s), struct_(false), owns_ptr(true) {
+		: IValue(collection.data(), collection.size(), concrete_address, k, s) {}
+
+	explicit IValue(const KIND* collection, size_t count, void* concrete_address, KIND k = PTR_KIND,
+					SCOPE s = REGISTER)
+		: value(concrete_address) {
+		initDefaults(k, s);
+		IValue* locArr = new IValue[count];
+		IValueInfo& ptrInfo = ensureInfo();
+		ptrInfo.valueOffset = reinterpret_cast<intptr_t>(locArr) - reinterpret_cast<intptr_t>(concrete_address);
+		ptrInfo.size = KIND_GetSize(count > 0 ? collection[0] : PTR_KIND);
+		ptrInfo.length = count;
+		owns_ptr = true;
 		unsigned firstByte = 0, bitOffset = 0;
-		IValue* locArr = reinterpret_cast<IValue*>(reinterpret_cast<intptr_t>(value.as_ptr) + valueOffset);
 		// TODO: add in assert that collection is only made up on primitive types (not an array? or struct)
-		for (uint64_t i = 0; i < collection.size(); i++) {
-			locArr[i] = IValue(0, i, (firstByte + bitOffset) / 8, bitOffset % 8, collection[i]);
+		for (uint64_t i = 0; i < count; i++) {
+			locArr[i] = IValue(0, i, firstByte + bitOffset / 8, bitOffset % 8, collection[i]);
 			firstByte += KIND_GetSize(collection[i]);
 			// WHY ARE WE DOUBLE INCREMENTING HERE?
 			bitOffset = (collection[i] == INT1_KIND) ? bitOffset + 1 : bitOffset;
@@ -157,99 +245,148 @@ public:
 		}
 	}
 
-	explicit IValue(INT value_, unsigned index_, unsigned firstByte_, unsigned bitOffset_, KIND type_, SCOPE s = REGISTER)
-		: value(value_), shadow(nullptr), type(type_), valueOffset(-1), size(0), index(index_), firstByte(firstByte_),
-		  length(0), offset(0), bitOffset(bitOffset_), scope(s), owns_ptr(false) {}
+	// Array element. The element index is not recorded: only pointers use an
+	// index, and elements stay compact as long as they hold scalars.
+	explicit IValue(INT value_, unsigned /* index */, unsigned firstByte_, unsigned bitOffset, KIND type_,
+					SCOPE s = REGISTER)
+		: value(value_) {
+		initDefaults(type_, s);
+		aux = firstByte_;
+		bitOffset_ = bitOffset;
+	}
 
-	IValue(KIND t, VALUE v, SCOPE s)
-		: value(v), shadow(NULL), type(t), valueOffset(-1), size(0), index(0), firstByte(0), length(0), offset(0),
-		  bitOffset(0), scope(s), struct_(false), owns_ptr(false) {
+	IValue(KIND t, VALUE v, SCOPE s) : value(v) {
+		initDefaults(t, s);
 		// counterNew++;
 	}
 
-	IValue(KIND t, VALUE v)
-		: value(v), shadow(NULL), type(t), valueOffset(-1), size(0), index(0), firstByte(0), length(0), offset(0),
-		  bitOffset(0), scope(REGISTER), struct_(false), owns_ptr(false) {
+	IValue(KIND t, VALUE v) : value(v) {
+		initDefaults(t, REGISTER);
 		// counterNew++;
 	}
 
-	IValue(KIND t, VALUE v, unsigned fb)
-		: value(v), shadow(NULL), type(t), valueOffset(-1), size(0), index(0), firstByte(fb), length(0), offset(0),
-		  bitOffset(0), scope(REGISTER), struct_(false), owns_ptr(false) {
+	IValue(KIND t, VALUE v, unsigned fb) : value(v) {
+		initDefaults(t, REGISTER);
+		aux = fb;
 		// counterNew++;
 	}
 
-	IValue(KIND t, VALUE v, unsigned s, int o, unsigned i, unsigned l)
-		: value(v), shadow(NULL), type(t), valueOffset(-1), size(s), index(i), firstByte(0), length(l), offset(o),
-		  bitOffset(0), scope(REGISTER), struct_(false), owns_ptr(false) {
+	IValue(KIND t, VALUE v, unsigned s, int o, unsigned i, unsigned l) : value(v) {
+		initDefaults(t, REGISTER);
+		setSize(s);
+		setOffset(o);
+		setIndex(i);
+		setLength(l);
 		// counterNew++;
 	}
 
-	IValue(KIND t)
-		: shadow(NULL), type(t), valueOffset(-1), size(0), index(0), firstByte(0), length(0), offset(0), bitOffset(0),
-		  scope(REGISTER), struct_(false), owns_ptr(false) {
+	IValue(KIND t) {
+		initDefaults(t, REGISTER);
 		value.as_int = 0;
 		// counterNew++;
 	}
 
-	IValue()
-		: shadow(NULL), type(INV_KIND), valueOffset(-1), size(0), index(0), firstByte(0), length(0), offset(0),
-		  bitOffset(0), scope(REGISTER), struct_(false), owns_ptr(false) {
+	IValue() {
+		initDefaults(INV_KIND, REGISTER);
 		// counterNew++;
 	}
 
 	IValue(const IValue& iv)
-		: value(iv.getValue()), shadow(copyShadow(iv.getShadow())), type(iv.getType()), valueOffset(iv.getValueOffset()),
-		  size(iv.getSize()), index(iv.getIndex()), firstByte(iv.getFirstByte()), length(iv.getLength()),
-		  offset(iv.getOffset()), bitOffset(iv.getOffset()), scope(iv.getScope()), struct_(iv.isStruct()),
-		  owns_ptr(false) {}  // owns_ptr is false here since they both refer to the same value
+		: value(iv.getValue()), shadow(copyShadow(iv.getShadow())), aux(0), type(iv.type), scope(iv.scope),
+		  bitOffset_(iv.bitOffset_), struct_(iv.struct_),
+		  owns_ptr(false),  // owns_ptr is false here since they both refer to the same value
+		  hasInfo(false) {
+		assignInfo(iv, iv.getFirstByte());
+	}
 
 public:
-	IValue(IValue&& iv) {
+	IValue(IValue&& iv) : IValue() {
 		swap(iv);
 	}
 
 	~IValue() {
 		deleteShadow(shadow);
 		clearValue();
+		if (hasInfo) {
+			deleteInfo(aux);
+		}
 	}
 
 private:
+	void releaseCells();
+
 	void clearValue() {
 		if (owns_ptr) {
-			delete[](IValue*)((int64_t)value.as_ptr + valueOffset);
+			releaseCells();
 		}
 		owns_ptr = false;
 		// TODO: implement destruction of pointed to object
 	}
 
 public:
+	// Assignments update the object in place. Only when this value owns an
+	// array, which iv may be an element of, do they go through a swap so that
+	// the array outlives the read of iv.
 	IValue& operator=(const IValue& iv) {
-		IValue temp(iv);
-		swap(temp);
+		if (owns_ptr) {
+			IValue temp(iv);
+			swap(temp);
+		} else if (this != &iv) {
+			void* sh = copyShadow(iv.shadow);
+			deleteShadow(shadow);
+			shadow = sh;
+			value = iv.value;
+			type = iv.type;
+			scope = iv.scope;
+			bitOffset_ = iv.bitOffset_;
+			struct_ = iv.struct_;
+			assignInfo(iv, iv.getFirstByte());
+		}
 		return *this;
 	}
 
-
 	IValue& operator=(IValue&& iv) {
-		swap(iv);
+		if (owns_ptr) {
+			swap(iv);
+		} else if (this != &iv) {
+			deleteShadow(shadow);
+			if (hasInfo) {
+				deleteInfo(aux);
+			}
+			value = iv.value;
+			shadow = iv.shadow;
+			aux = iv.aux;
+			type = iv.type;
+			scope = iv.scope;
+			bitOffset_ = iv.bitOffset_;
+			struct_ = iv.struct_;
+			owns_ptr = iv.owns_ptr;
+			hasInfo = iv.hasInfo;
+			iv.shadow = nullptr;
+			iv.aux = 0;
+			iv.owns_ptr = false;
+			iv.hasInfo = false;
+		}
 		return *this;
 	}
 
 	void swap(IValue& iv) {
 		std::swap(type, iv.type);
 		std::swap(value, iv.value);
-		std::swap(valueOffset, iv.valueOffset);
-		std::swap(size, iv.size);
-		std::swap(index, iv.index);
-		std::swap(firstByte, iv.firstByte);
-		std::swap(length, iv.length);
-		std::swap(offset, iv.offset);
-		std::swap(bitOffset, iv.bitOffset);
+		std::swap(aux, iv.aux);
+		std::swap(bitOffset_, iv.bitOffset_);
 		std::swap(scope, iv.scope);
-		std::swap(struct_, iv.struct_);
 		std::swap(shadow, iv.shadow);
-		std::swap(owns_ptr, iv.owns_ptr);
+
+		uint8_t flag = struct_;
+		struct_ = iv.struct_;
+		iv.struct_ = flag;
+		flag = owns_ptr;
+		owns_ptr = iv.owns_ptr;
+		iv.owns_ptr = flag;
+		flag = hasInfo;
+		hasInfo = iv.hasInfo;
+		iv.hasInfo = flag;
 	}
 
 	void setType(KIND t) {
@@ -276,12 +413,14 @@ public:
 	void setTypeValueSize(KIND t, VALUE v, unsigned s) {
 		type = t;
 		setValue(v);
-		size = s;
+		setSize(s);
 	}
 
 	void setValueOffset(int64_t vo) {
 		owns_ptr = false;
-		valueOffset = vo;
+		if (hasInfo || vo != -1) {
+			ensureInfo().valueOffset = vo;
+		}
 	}
 
 	void setScope(SCOPE sc) {
@@ -289,28 +428,40 @@ public:
 	}
 
 	void setSize(unsigned int s) {
-		size = s;
+		if (hasInfo || s != 0) {
+			ensureInfo().size = s;
+		}
 	}
 
 	void setIndex(unsigned i) {
-		index = i;
+		if (hasInfo || i != 0) {
+			ensureInfo().index = i;
+		}
 	}
 
 	void setFirstByte(unsigned fb) {
-		firstByte = fb;
+		if (hasInfo) {
+			info().firstByte = fb;
+		} else {
+			aux = fb;
+		}
 	}
 
 	void setLength(unsigned l) {
 		owns_ptr = false;
-		length = l;
+		if (hasInfo || l != 0) {
+			ensureInfo().length = l;
+		}
 	}
 
 	void setOffset(int o) {
-		offset = o;
+		if (hasInfo || o != 0) {
+			ensureInfo().offset = o;
+		}
 	}
 
 	void setBitOffset(int bo) {
-		bitOffset = bo;
+		bitOffset_ = bo;
 	}
 
 	void resetShadow() {
@@ -340,8 +491,8 @@ public:
 	}
 
 	void setInitialized() {
-		if (type == PTR_KIND && length == 0) {
-			length = 1;
+		if (type == PTR_KIND && getLength() == 0) {
+			ensureInfo().length = 1;
 		}
 	}
 
@@ -360,35 +511,35 @@ public:
 	}
 
 	unsigned getIndex() const {
-		return this->index;
+		return hasInfo ? info().index : 0;
 	}
 
 	unsigned getFirstByte() const {
-		return this->firstByte;
+		return hasInfo ? info().firstByte : aux;
 	}
 
 	unsigned getLength() const {
-		return this->length;
+		return hasInfo ? info().length : 0;
 	}
 
 	unsigned int getSize() const {
-		return this->size;
+		return hasInfo ? info().size : 0;
 	}
 
 	SCOPE getScope() const {
-		return this->scope;
+		return (SCOPE) this->scope;
 	}
 
 	int getOffset() const {
-		return this->offset;
+		return hasInfo ? info().offset : 0;
 	}
 
 	int getBitOffset() const {
-		return this->bitOffset;
+		return this->bitOffset_;
 	}
 
 	int64_t getValueOffset() const {
-		return this->valueOffset;
+		return hasInfo ? info().valueOffset : -1;
 	}
 
 	void* getShadow() const {
@@ -414,20 +565,20 @@ public:
 	double getFlpValue();
 
 	IValue& getIPtrValue(unsigned index = 0) const {
-		IValue* iptr = (IValue*)((int64_t)value.as_ptr + valueOffset);
+		IValue* iptr = (IValue*)((int64_t)value.as_ptr + getValueOffset());
 		return iptr[index];
 	}
 
 	const IValue* cbegin() const {
-		return (IValue*)((int64_t)value.as_ptr + valueOffset);
+		return (IValue*)((int64_t)value.as_ptr + getValueOffset());
 	}
 
 	const IValue* cend() const {
-		return (IValue*)((int64_t)value.as_ptr + valueOffset) + getLength();
+		return (IValue*)((int64_t)value.as_ptr + getValueOffset()) + getLength();
 	}
 
 	bool isInitialized() const {
-		return type != PTR_KIND || length > 0;
+		return type != PTR_KIND || getLength() > 0;
 	}
 
 	bool isIntValue() const {
@@ -515,4 +666,6 @@ public:
 };
 
 
+static_assert(sizeof(IValue) == 24, "IValue is expected to be a compact 24-byte cell");
+
 #endif /* IVALUE_H_ */
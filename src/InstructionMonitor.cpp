@@ -44,6 +44,7 @@
 #include "InstructionObserver.h"
 #include "InterpreterObserver.h"
 #include "EmptyObserver.h"
+#include "ObserverPipeline.h"
 #include <vector>
 #include <memory>
 
@@ -53,22 +54,27 @@ using std::unique_ptr;
 /*******************************************************************************************/
 vector<unique_ptr<InstructionObserver>> observers_ = {};
 
-#define DISPATCH_TO_OBSERVERS_NOARG(func)                                      \
-  for (auto &ob_ptr : observers_) {                                            \
-    ob_ptr->func();                                                            \
-  }
+#define DISPATCH_TO_OBSERVERS_NOARG(func) activeObservers_.func();
 
-#define DISPATCH_TO_OBSERVERS(func, ...)                                       \
-  for (auto &ob_ptr : observers_) {                                            \
-    ob_ptr->func(__VA_ARGS__);                                                 \
-  }
+#define DISPATCH_TO_OBSERVERS(func, ...) activeObservers_.func(__VA_ARGS__);
 
 /*******************************************************************************************/
 
-// macro for adding observers
-#define REGISTER_OBSERVER(T, N) static RegisterObserver<T> T##_INSTANCE(N);
-
-REGISTER_OBSERVER(InterpreterObserver, "interpreter")
+// macros for selecting the observers; exactly one of them must be used.
+// Plugins registered with RegisterObserver are only reached when
+// DynamicObservers is part of the chain, so the default chain keeps it: the
+// analyses under BlameAnalysis/ register that way. Without plugins it costs
+// a check of the empty observers_ per callback.
+#define REGISTER_OBSERVER(T, N)                                                \
+  typedef ObserverPipeline<T> ActiveObservers;                                 \
+  static ActiveObservers activeObservers_(N);
+
+#define REGISTER_OBSERVER_CHAIN(N, ...)                                        \
+  typedef ObserverPipeline<__VA_ARGS__> ActiveObservers;                       \
+  static ActiveObservers activeObservers_(N);
+
+REGISTER_OBSERVER_CHAIN("interpreter", InterpreterObserver, DynamicObservers)
+// REGISTER_OBSERVER(InterpreterObserver, "interpreter")
 // REGISTER_OBSERVER(EmptyObserver, "emptyobserver")
 
 /*******************************************************************************************/
@@ -261,6 +267,15 @@ void llvm_getelementptr_array(int baseInx, SCOPE baseScope, uint64_t baseAddr,
 						  valOrInx01, valOrInx02, valOrInx03, size01, size02, inx)
 }
 
+void llvm_getelementptr_strided(int baseInx, SCOPE baseScope, uint64_t baseAddr,
+								int elementSize, int ptrScope,
+								int64_t ptrValOrInx, int64_t constOffset,
+								int count, const GEPINDEX* indices, int inx) {
+	DISPATCH_TO_OBSERVERS(getelementptr_strided, baseInx, baseScope, baseAddr,
+						  elementSize, ptrScope, ptrValOrInx, constOffset, count,
+						  indices, inx)
+}
+
 void llvm_getelementptr_struct(IID iid, int baseInx, SCOPE baseScope,
 							   uint64_t baseAddr, int inx) {
 	DISPATCH_TO_OBSERVERS(getelementptr_struct, iid, baseInx, baseScope, baseAddr,
@@ -387,6 +402,10 @@ void llvm_phinode(IID iid, int inx) {
 	DISPATCH_TO_OBSERVERS(phinode, iid, inx)
 }
 
+void llvm_phinode_table(IID iid, int count, const PHIARG* incoming, int inx) {
+	DISPATCH_TO_OBSERVERS(phinode_table, iid, count, incoming, inx)
+}
+
 void llvm_select(IID iid, KVALUE* cond, KVALUE* tvalue, KVALUE* fvalue,
 				 int inx) {
 	DISPATCH_TO_OBSERVERS(select, iid, cond, tvalue, fvalue, inx)
@@ -447,6 +466,17 @@ void llvm_push_struct_element_size(uint64_t s) {
 	DISPATCH_TO_OBSERVERS(push_struct_element_size, s);
 }
 
+void llvm_register_type_layout(int id, int length, const KIND* kinds,
+							   const unsigned* offsets, int fields,
+							   const unsigned* fieldStarts) {
+	DISPATCH_TO_OBSERVERS(register_type_layout, id, length, kinds, offsets,
+						  fields, fieldStarts);
+}
+
+void llvm_push_type_layout(int id) {
+	DISPATCH_TO_OBSERVERS(push_type_layout, id);
+}
+
 void llvm_construct_array_type(uint64_t i) {
 	DISPATCH_TO_OBSERVERS(construct_array_type, i);
 }
@@ -476,6 +506,10 @@ void llvm_record_block_id(int id) {
 	DISPATCH_TO_OBSERVERS(record_block_id, id)
 }
 
+void llvm_sync_register(int inx, KIND type, int64_t value) {
+	DISPATCH_TO_OBSERVERS(sync_register, inx, type, value)
+}
+
 void llvm_create_global(KVALUE* value, KVALUE* initializer) {
 	DISPATCH_TO_OBSERVERS(create_global, value, initializer)
 }
@@ -489,6 +523,11 @@ void llvm_call(IID iid, bool nounwind, KIND type, int inx) {
 	DISPATCH_TO_OBSERVERS(call, iid, nounwind, type, inx)
 }
 
+void llvm_call_args(IID iid, bool nounwind, KIND type, int inx, int count,
+					const CALLARG* args) {
+	DISPATCH_TO_OBSERVERS(call_args, iid, nounwind, type, inx, count, args)
+}
+
 void llvm_call_sin(IID iid, bool nounwind, IID argIID, KIND type, int inx) {
 	DISPATCH_TO_OBSERVERS(call_sin, iid, nounwind, argIID, type, inx)
 }
@@ -527,6 +566,22 @@ void llvm_call_malloc(IID iid, bool nounwind, KIND type, int size, int inx,
 						  mallocAddress)
 }
 
+void llvm_call_calloc(IID iid, bool nounwind, KIND type, int size, int inx,
+					  uint64_t callocAddress) {
+	DISPATCH_TO_OBSERVERS(call_calloc, iid, nounwind, type, size, inx,
+						  callocAddress)
+}
+
+void llvm_call_realloc(IID iid, bool nounwind, KIND type, int size, int inx,
+					   uint64_t reallocAddress) {
+	DISPATCH_TO_OBSERVERS(call_realloc, iid, nounwind, type, size, inx,
+						  reallocAddress)
+}
+
+void llvm_call_free(IID iid, bool nounwind) {
+	DISPATCH_TO_OBSERVERS(call_free, iid, nounwind)
+}
+
 void llvm_vaarg() {
 	DISPATCH_TO_OBSERVERS_NOARG(vaarg)
 }
@@ -126,6 +126,11 @@ extern "C" {
 								  int scopeInx03, int64_t valOrInx01,
 								  int64_t valOrInx02, int64_t valOrInx03,
 								  int size01, int size02, int inx);
+	void llvm_getelementptr_strided(int baseInx, SCOPE baseScope,
+									uint64_t baseAddr, int elementSize,
+									int ptrScope, int64_t ptrValOrInx,
+									int64_t constOffset, int count,
+									const GEPINDEX* indices, int inx);
 	void llvm_getelementptr_struct(IID iid, int baseInx, SCOPE baseScope,
 								   uint64_t baseAddr, int inx);
 
@@ -174,6 +179,7 @@ extern "C" {
 	void llvm_fcmp(SCOPE lScope, SCOPE rScope, int64_t lValue, int64_t rValue,
 				   KIND type, PRED pred, int inx);
 	void llvm_phinode(IID iid, int inx);
+	void llvm_phinode_table(IID iid, int count, const PHIARG* incoming, int inx);
 	void llvm_select(IID iid, KVALUE* cond, KVALUE* tvalue, KVALUE* fvalue, int x);
 	void llvm_push_stack(int inx, SCOPE scope, KIND type, uint64_t addr);
 	void llvm_push_string(int c);
@@ -182,6 +188,10 @@ extern "C" {
 	void llvm_push_return_struct(KVALUE* value);
 	void llvm_push_struct_type(KIND kind);
 	void llvm_push_struct_element_size(uint64_t s);
+	void llvm_register_type_layout(int id, int length, const KIND* kinds,
+								   const unsigned* offsets, int fields,
+								   const unsigned* fieldStarts);
+	void llvm_push_type_layout(int id);
 	void llvm_push_getelementptr_inx(uint64_t value);
 	void llvm_push_getelementptr_inx5(int scope01, int scope02, int scope03,
 									  int scope04, int scope05, int64_t vori01,
@@ -199,10 +209,13 @@ extern "C" {
 	void llvm_create_stack_frame(int size);
 	void llvm_create_global_symbol_table(int size);
 	void llvm_record_block_id(int id);
+	void llvm_sync_register(int inx, KIND type, int64_t value);
 	void llvm_create_global(KVALUE* value, KVALUE* initializer);
 	void llvm_create_global_array(int valInx, uint64_t addr, uint32_t size,
 								  KIND type);
 	void llvm_call(IID iid, bool nounwind, KIND type, int x);
+	void llvm_call_args(IID iid, bool nounwind, KIND type, int x, int count,
+						const CALLARG* args);
 	void llvm_call_sin(IID iid, bool nounwind, IID argIID, KIND type, int x);
 	void llvm_call_acos(IID iid, bool nounwind, IID argIID, KIND type, int x);
 	void llvm_call_sqrt(IID iid, bool nounwind, IID argIID, KIND type, int x);
@@ -213,6 +226,11 @@ extern "C" {
 	void llvm_call_floor(IID iid, bool nounwind, IID argIID, KIND type, int x);
 	void llvm_call_malloc(IID iid, bool nounwind, KIND type, int size, int x,
 						  uint64_t mallocAddress);
+	void llvm_call_calloc(IID iid, bool nounwind, KIND type, int size, int x,
+						  uint64_t callocAddress);
+	void llvm_call_realloc(IID iid, bool nounwind, KIND type, int size, int x,
+						   uint64_t reallocAddress);
+	void llvm_call_free(IID iid, bool nounwind);
 	void llvm_vaarg();
 	void llvm_landingpad();
 }
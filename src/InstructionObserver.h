@@ -209,6 +209,13 @@ public:
 						int64_t valOrInx02 UNUSED, int64_t valOrInx03 UNUSED,
 						int size01 UNUSED, int size02 UNUSED, int inx UNUSED) {}
 	;
+	virtual void
+	getelementptr_strided(int baseInx UNUSED, SCOPE baseScope UNUSED,
+						  uint64_t baseAddr UNUSED, int elementSize UNUSED,
+						  int ptrScope UNUSED, int64_t ptrValOrInx UNUSED,
+						  int64_t constOffset UNUSED, int count UNUSED,
+						  const GEPINDEX* indices UNUSED, int inx UNUSED) {}
+	;
 	virtual void getelementptr_struct(IID iid UNUSED, int baseInx UNUSED,
 									  SCOPE baseScope UNUSED,
 									  uint64_t baseAddr UNUSED, int inx UNUSED) {}
@@ -299,6 +306,9 @@ public:
 	;
 	virtual void phinode(IID iid UNUSED, int inx UNUSED) {}
 	;
+	virtual void phinode_table(IID iid UNUSED, int count UNUSED,
+							   const PHIARG* incoming UNUSED, int inx UNUSED) {}
+	;
 	virtual void select(IID iid UNUSED, KVALUE* cond UNUSED,
 						KVALUE* tvalue UNUSED, KVALUE* fvealue UNUSED,
 						int inx UNUSED) {}
@@ -319,6 +329,14 @@ public:
 	;
 	virtual void push_struct_element_size(uint64_t s UNUSED) {}
 	;
+	virtual void register_type_layout(int id UNUSED, int length UNUSED,
+									  const KIND* kinds UNUSED,
+									  const unsigned* offsets UNUSED,
+									  int fields UNUSED,
+									  const unsigned* fieldStarts UNUSED) {}
+	;
+	virtual void push_type_layout(int id UNUSED) {}
+	;
 	virtual void push_getelementptr_inx(uint64_t value UNUSED) {}
 	;
 	virtual void
@@ -351,6 +369,8 @@ public:
 	;
 	virtual void record_block_id(int id UNUSED) {}
 	;
+	virtual void sync_register(int inx UNUSED, KIND type UNUSED, int64_t value UNUSED) {}
+	;
 	virtual void create_global(KVALUE* value UNUSED, KVALUE* initializer UNUSED) {
 	}
 	;
@@ -360,6 +380,13 @@ public:
 	virtual void call(IID iid UNUSED, bool nounwind UNUSED, KIND type UNUSED,
 					  int inx UNUSED) {}
 	;
+	// A call whose arguments are described by a constant array instead of
+	// the argument stack.
+	virtual void call_args(IID iid, bool nounwind, KIND type, int inx,
+						   int count UNUSED, const CALLARG* args UNUSED) {
+		call(iid, nounwind, type, inx);
+	}
+	;
 	virtual void call_sin(IID iid UNUSED, bool nounwind UNUSED, IID argIID UNUSED,
 						  KIND type UNUSED, int inx UNUSED) {}
 	;
@@ -389,6 +416,16 @@ public:
 							 KIND type UNUSED, int size UNUSED, int inx UNUSED,
 							 uint64_t mallocAddress UNUSED) {}
 	;
+	virtual void call_calloc(IID iid UNUSED, bool nounwind UNUSED,
+							 KIND type UNUSED, int size UNUSED, int inx UNUSED,
+							 uint64_t callocAddress UNUSED) {}
+	;
+	virtual void call_realloc(IID iid UNUSED, bool nounwind UNUSED,
+							  KIND type UNUSED, int size UNUSED, int inx UNUSED,
+							  uint64_t reallocAddress UNUSED) {}
+	;
+	virtual void call_free(IID iid UNUSED, bool nounwind UNUSED) {}
+	;
 	virtual void vaarg() {}
 	;
 	virtual void landingpad() {}
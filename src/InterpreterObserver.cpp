@@ -42,8 +42,11 @@
 
 #include "InterpreterObserver.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
+#include <iterator>
 #include <stack>
 #include <vector>
 
@@ -55,6 +58,18 @@
 using std::cerr;
 using llvm::CmpInst;
 
+const bool InterpreterObserver::threaded = getenv("INTERPRETER_THREADS") != NULL;
+std::atomic<unsigned> InterpreterObserver::stateSlots(0);
+thread_local vector<std::unique_ptr<InterpreterObserver::ThreadState>> InterpreterObserver::threadStates;
+
+InterpreterObserver::ThreadState& InterpreterObserver::newState() {
+	if (stateSlot >= threadStates.size()) {
+		threadStates.resize(stateSlot + 1);
+	}
+	threadStates[stateSlot].reset(new ThreadState());
+	return *threadStates[stateSlot];
+}
+
 /***************************** Helper Functions *****************************/
 
 void release(IValue* value) {
@@ -71,6 +86,14 @@ void release(IValue* value) {
 	return;
 }
 
+// Release the value held by register inx of frame, unless it is the frame's
+// own storage, which lives until the frame is popped.
+void release(Frame& frame, int inx) {
+	if (!frame.owns(frame[inx])) {
+		release(frame[inx]);
+	}
+}
+
 /*
 void release(IValue* value) {
   if (value->getType() == PTR_KIND) {
@@ -95,6 +118,140 @@ unsigned InterpreterObserver::findIndex(const IValue* cbegin, const IValue* cend
 	return std::distance(cbegin, ret);
 }
 
+unsigned InterpreterObserver::findIndex(const IValue* cbegin, const IValue* cend, unsigned offset, int guess) {
+	// the guess is the answer if it is the first element at the offset
+	if (guess >= 0 && guess < cend - cbegin && cbegin[guess].getFirstByte() == offset &&
+			(guess == 0 || cbegin[guess - 1].getFirstByte() < offset)) {
+		return guess;
+	}
+	return findIndex(cbegin, cend, offset);
+}
+
+int InterpreterObserver::mappedIndex(const IValue* pointer, int offset) {
+	const IValue* cell = shadowMemory.find(pointer->getValue().as_int + offset);
+	if (cell == NULL || !pointer->isInitialized()) {
+		return -1;
+	}
+	std::less<const IValue*> before;
+	if (before(cell, pointer->cbegin()) || !before(cell, pointer->cend())) {
+		return -1;
+	}
+	return cell - pointer->cbegin();
+}
+
+void InterpreterObserver::mapBlock(const IValue* pointer) {
+	if (pointer->isInitialized()) {
+		shadowMemory.mapBlock(pointer->getValue().as_int, &pointer->getIPtrValue(), pointer->getLength());
+	}
+}
+
+namespace {
+
+// Number of concrete bytes shadowed by a non-empty block of cells.
+uint64_t blockBytes(const IValue* cells, unsigned count) {
+	const IValue& last = cells[count - 1];
+	return last.getFirstByte() + std::max(KIND_GetSize(last.getType()), 1u);
+}
+
+}  // namespace
+
+void InterpreterObserver::mapAlloca(int inx) {
+	ThreadState& s = state();
+	mapBlock(s.executionStack.top()[inx]);
+
+	size_t depth = s.executionStack.size();
+	if (s.allocaRegisters.size() < depth) {
+		s.allocaRegisters.resize(depth);
+	}
+	vector<int>& registers = s.allocaRegisters[depth - 1];
+	if (std::find(registers.begin(), registers.end(), inx) == registers.end()) {
+		registers.push_back(inx);
+	}
+}
+
+bool InterpreterObserver::resolveBlock(uint64_t addr, uint64_t& base, HeapBlock& block) {
+	auto covers = [addr](uint64_t start, const IValue* cells, unsigned count) {
+		return count > 0 && addr >= start && addr - start < blockBytes(cells, count);
+	};
+	auto lookup = [&](const map<uint64_t, HeapBlock>& blocks) {
+		auto it = blocks.upper_bound(addr);
+		if (it == blocks.begin()) {
+			return false;
+		}
+		--it;
+		if (!covers(it->first, it->second.cells, it->second.count)) {
+			return false;
+		}
+		base = it->first;
+		block = it->second;
+		return true;
+	};
+
+	// allocas of the live frames, innermost first
+	ThreadState& s = state();
+	for (size_t depth = std::min(s.allocaRegisters.size(), s.executionStack.size()); depth-- > 0;) {
+		Frame& frame = s.executionStack.frame(depth);
+		for (int inx : s.allocaRegisters[depth]) {
+			const IValue* reg = frame[inx];
+			if (reg->isInitialized() && covers(reg->getValue().as_int, &reg->getIPtrValue(), reg->getLength())) {
+				base = reg->getValue().as_int;
+				block.cells = &reg->getIPtrValue();
+				block.count = reg->getLength();
+				return true;
+			}
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(heapLock);
+		if (lookup(heapBlocks)) {
+			return true;
+		}
+	}
+	return lookup(globalBlocks);
+}
+
+void InterpreterObserver::pointInto(IValue* pointer, uint64_t addr, uint64_t base, const HeapBlock& block) {
+	unsigned offset = addr - base;
+	const IValue* cell = shadowMemory.find(addr);
+
+	unsigned index;
+	std::less<const IValue*> before;
+	if (cell != NULL && !before(cell, block.cells) && before(cell, block.cells + block.count)) {
+		index = cell - block.cells;
+	} else {
+		// the element that starts at or before offset
+		index = findIndex(block.cells, block.cells + block.count, offset);
+		if (index > 0 && (index == block.count || block.cells[index].getFirstByte() > offset)) {
+			index--;
+		}
+	}
+
+	VALUE value;
+	value.as_int = base;
+	IValue target = IValue(PTR_KIND, value, KIND_GetSize(block.cells[index].getType()), offset, index, block.count);
+	target.setValueOffset((int64_t)block.cells - (int64_t)base);
+	*pointer = std::move(target);
+}
+
+bool InterpreterObserver::bindPointer(IValue* pointer, uint64_t addr) {
+	uint64_t base;
+	HeapBlock block;
+	if (!resolveBlock(addr, base, block)) {
+		return false;
+	}
+	pointInto(pointer, addr, base, block);
+	return true;
+}
+
+void InterpreterObserver::adoptCell(IValue* pointer, uint64_t addr, const IValue& cell) {
+	HeapBlock block = {new IValue[1], 1};
+	cell.copy(block.cells);
+	block.cells->setFirstByte(0);
+	collect(addr, block.cells, block.count);
+	pointInto(pointer, addr, addr, block);
+}
+
 bool InterpreterObserver::checkStore(IValue* dest, KIND srcKind, int64_t srcValue) {
 	bool result;
 	double dpValue;
@@ -341,11 +498,11 @@ std::string InterpreterObserver::CASTOP_ToString(int castop) {
 
 // *** Load and Store Operations *** //
 
-void InterpreterObserver::load_struct(IID iid UNUSED, KIND type UNUSED, KVALUE* src, int inx) {
+void InterpreterObserver::load_struct(IID iid, KIND type UNUSED, KVALUE* src, int inx) {
 
 	// DEBUG_LOG("[LOAD STRUCT] Performing load ");
 
-	unsigned structSize = returnStruct.size();
+	unsigned structSize = state().returnStruct.size();
 	IValue* dest = new IValue[structSize];
 
 	if (src->inx == -1) {
@@ -353,16 +510,16 @@ void InterpreterObserver::load_struct(IID iid UNUSED, KIND type UNUSED, KVALUE*
 		// Case 1: struct constant.
 		// Create an IValue struct that has all values in structReturn.
 		for (unsigned i = 0; structSize; i++) {
-			KVALUE* concreteStructElem = returnStruct[i];
+			KVALUE* concreteStructElem = state().returnStruct[i];
 
 			if (concreteStructElem->inx == -1) {
 				dest[i] = IValue(concreteStructElem->kind, concreteStructElem->value, REGISTER);
 			} else {
 				dest[i] = *(concreteStructElem->isGlobal ? globalSymbolTable[concreteStructElem->inx] :
-							executionStack.top()[concreteStructElem->inx]);
+							state().executionStack.top()[concreteStructElem->inx]);
 			}
 		}
-		returnStruct.clear();
+		state().returnStruct.clear();
 
 		safe_assert(false);  // why?
 
@@ -370,40 +527,36 @@ void InterpreterObserver::load_struct(IID iid UNUSED, KIND type UNUSED, KVALUE*
 
 		// Case 2: local or global struct.
 
-		IValue* srcPointer = src->isGlobal ? globalSymbolTable[src->inx] : executionStack.top()[src->inx];
+		IValue* srcPointer = src->isGlobal ? globalSymbolTable[src->inx] : state().executionStack.top()[src->inx];
 		auto structSrc = [&](unsigned index)->IValue & {
 			return srcPointer->getIPtrValue(index);
 		};
 
 		for (unsigned i = 0; i < structSize; i++) {
 			// get concrete value in case we need to sync
-			KVALUE* concreteStructElem = returnStruct[i];
+			KVALUE* concreteStructElem = state().returnStruct[i];
 
 			IValue structElem;
 			structSrc(i).copy(&structElem);
 			int type = structElem.getType();
 
-			// sync load
-			// first create a KVALUE pointer to concreteStructElem because sync load
-			// expect the KVALUE to be a pointer to the concrete value
-			KVALUE concreteStructElemPtr;
-			concreteStructElemPtr.value.as_ptr = &(concreteStructElem->value);
-			if (syncLoad(&structElem, &concreteStructElemPtr, type)) {
+			// sync load against the concrete value of the element
+			if (syncLoad(iid, &structElem, &concreteStructElem->value, type)) {
 				DEBUG_LOG("[LOAD STRUCT] Syncing load");
 			}
 			dest[i] = structElem;
 		}
-		returnStruct.clear();
+		state().returnStruct.clear();
 	}
 
-	release(executionStack.top()[inx]);
-	executionStack.top()[inx] = dest;
+	release(state().executionStack.top(), inx);
+	state().executionStack.top().redirect(inx, dest);
 
 	DEBUG_STDOUT("Destination result: " << dest->toString());
 	return;
 }
 
-void InterpreterObserver::load(IID iid UNUSED, KIND type, SCOPE opScope, int opInx, uint64_t opAddr, bool loadGlobal,
+void InterpreterObserver::load(IID iid, KIND type, SCOPE opScope, int opInx, uint64_t opAddr, bool loadGlobal,
 							   int loadInx, int inx) {
 
 	// pre_load(iid, type, opScope, opInx, opAddr, loadGlobal, loadInx, file,
@@ -413,26 +566,48 @@ void InterpreterObserver::load(IID iid UNUSED, KIND type, SCOPE opScope, int opI
 	bool isPointerConstant = false;
 	bool sync = false;
 	IValue* srcPtrLocation;
-	IValue* destLocation = executionStack.top()[inx];
+	IValue* destLocation = state().executionStack.top()[inx];
 
 	// DEBUG_LOG("[LOAD] Performing load");
 
 	// retrieving source pointer value
 	if (opScope == CONSTANT) {
 		isPointerConstant = true;
+		srcPtrLocation = NULL;
 	} else if (opScope == GLOBAL) {
 		srcPtrLocation = globalSymbolTable[opInx];
 	} else {
-		srcPtrLocation = executionStack.top()[opInx];
+		srcPtrLocation = state().executionStack.top()[opInx];
 	}
+	BlockAccess access(*this, srcPtrLocation, opAddr);
 
 	// performing load
 	if (!isPointerConstant) {
 
 		DEBUG_STDOUT("\tsrcPtrLocation: " << srcPtrLocation->toString());
 
-		// CASE 1: srcPtrLocation and srcLocation exist
-		if (srcPtrLocation->isInitialized()) {
+		// a pointer computed natively points into the block covering opAddr
+		if (!srcPtrLocation->isInitialized()) {
+			bindPointer(srcPtrLocation, opAddr);
+		}
+
+		IValue* cell = shadowMemory.find(opAddr);
+
+		if (srcPtrLocation->isInitialized() && cell != NULL && KIND_GetSize(cell->getType()) == KIND_GetSize(type)) {
+			// CASE 0: the shadow memory has a cell for opAddr with the size of the
+			// loaded value; this is the trivial read of CASE 1 without going
+			// through the pointer metadata
+			DEBUG_STDOUT("\tsrcLocation (shadow memory): " << cell->toString());
+
+			cell->copy(destLocation);
+			destLocation->setTypeValue(type, cell->getValue());
+
+			sync = syncLoad(iid, destLocation, (const void*)opAddr, type);
+			if (sync) {
+				destLocation->copy(cell);
+			}
+		} else if (srcPtrLocation->isInitialized()) {
+			// CASE 1: srcPtrLocation and srcLocation exist
 
 			// retrieving source
 			unsigned valueIndex = srcPtrLocation->getIndex();
@@ -462,7 +637,7 @@ void InterpreterObserver::load(IID iid UNUSED, KIND type, SCOPE opScope, int opI
 			destLocation->setTypeValue(type, value);
 
 			// syncing load value with concrete value
-			sync = syncLoad(destLocation, opAddr, type);
+			sync = syncLoad(iid, destLocation, (const void*)opAddr, type);
 
 			// if sync happens, update srcPtrLocation if possible
 			if (sync) {
@@ -473,8 +648,8 @@ void InterpreterObserver::load(IID iid UNUSED, KIND type, SCOPE opScope, int opI
 				}
 			}
 		} else {
-			// CASE 2: srcPtrLocation exists, but it is not initialized (no
-			// srcLocation)
+			// CASE 2: srcPtrLocation exists, but no shadow block covers the
+			// address (no srcLocation)
 			DEBUG_STDOUT("\tSource pointer is not initialized!");
 
 			VALUE zeroValue;
@@ -484,23 +659,19 @@ void InterpreterObserver::load(IID iid UNUSED, KIND type, SCOPE opScope, int opI
 			destLocation->setTypeValue(type, zeroValue);
 
 			// syncing load
-			sync = syncLoad(destLocation, opAddr, type);
+			sync = syncLoad(iid, destLocation, (const void*)opAddr, type);
 
 			// initializing srcPtrLocation and srcLocation
 			DEBUG_STDOUT("\tInitializing source pointer.");
 			DEBUG_STDOUT("\tSource pointer location: " << srcPtrLocation->toString());
-			IValue* srcLocation = new IValue();
-			destLocation->copy(srcLocation);
-			srcPtrLocation->setLength(1);  // initialized
-			srcPtrLocation->setSize(KIND_GetSize(type));
-			srcPtrLocation->setValueOffset((int64_t)srcLocation - srcPtrLocation->getValue().as_int);
+			adoptCell(srcPtrLocation, opAddr, *destLocation);
 			DEBUG_STDOUT("\tSource pointer location: " << srcPtrLocation->toString());
 
 			// TODO: revise this case
 			// updating load variable
 			if (loadInx != -1) {
 				IValue* loadInst;
-				loadInst = loadGlobal ? globalSymbolTable[loadInx] : executionStack.top()[loadInx];
+				loadInst = loadGlobal ? globalSymbolTable[loadInx] : state().executionStack.top()[loadInx];
 
 				// retrieving source
 				IValue& elem = loadInst->getIPtrValue(loadInst->getIndex());
@@ -522,7 +693,7 @@ void InterpreterObserver::load(IID iid UNUSED, KIND type, SCOPE opScope, int opI
 		destLocation->setTypeValue(type, zeroValue);
 
 		// syncing load
-		sync = syncLoad(destLocation, opAddr, type);
+		sync = syncLoad(iid, destLocation, (const void*)opAddr, type);
 		DEBUG_STDOUT(destLocation->toString());
 	}
 
@@ -554,27 +725,17 @@ void InterpreterObserver::store(int dstInx, SCOPE dstScope, KIND srcKind, SCOPE
 	}
 
 	// retrieving destination pointer operand
-	IValue* dstPtrLocation = (dstScope == GLOBAL) ? globalSymbolTable[dstInx] : executionStack.top()[dstInx];
+	IValue* dstPtrLocation = (dstScope == GLOBAL) ? globalSymbolTable[dstInx] : state().executionStack.top()[dstInx];
+	// pointers into a block keep the block's address and the offset into it
+	uint64_t dstAddr = dstPtrLocation->getValue().as_int + dstPtrLocation->getOffset();
+	BlockAccess access(*this, dstPtrLocation, dstAddr);
 
 	DEBUG_STDOUT("\tDstPtr: " << dstPtrLocation->toString());
 
-	// the destination pointer is not initialized
-	// initialize with an empty IValue object
-	if (!dstPtrLocation->isInitialized()) {
-		DEBUG_STDOUT("\tDestination pointer location is not initialized");
-		IValue* iValue = new IValue(srcKind);
-		iValue->setLength(0);
-		dstPtrLocation->setValueOffset((int64_t)iValue - (int64_t)dstPtrLocation->getPtrValue());
-		dstPtrLocation->setInitialized();
-		DEBUG_STDOUT("\tInitialized destPtr: " << dstPtrLocation->toString());
-	}
-
-	unsigned dstPtrOffset = dstPtrLocation->getOffset();
+	// retrieving source
 	const IValue* srcLocation = NULL;
 	IValue temp;
-	int internalOffset = 0;
 
-	// retrieving source
 	if (srcScope == CONSTANT) {
 		VALUE value;
 		value.as_int = srcValue;
@@ -588,11 +749,41 @@ void InterpreterObserver::store(int dstInx, SCOPE dstScope, KIND srcKind, SCOPE
 	} else if (srcScope == GLOBAL) {
 		srcLocation = globalSymbolTable[srcInx];
 	} else {
-		srcLocation = executionStack.top()[srcInx];
+		srcLocation = state().executionStack.top()[srcInx];
 	}
 
 	DEBUG_STDOUT("\tSrc: " << srcLocation->toString());
 
+	// a pointer computed natively points into the block covering dstAddr; if
+	// there is none, the destination gets a cell of its own
+	if (!dstPtrLocation->isInitialized() && !bindPointer(dstPtrLocation, dstAddr)) {
+		DEBUG_STDOUT("\tDestination pointer location is not initialized");
+		adoptCell(dstPtrLocation, dstAddr, IValue(srcKind));
+		DEBUG_STDOUT("\tInitialized destPtr: " << dstPtrLocation->toString());
+	}
+
+	// the shadow memory has a cell for the destination with the size of the
+	// stored value; write it directly
+	IValue* cell = shadowMemory.find(dstAddr);
+	if (dstPtrLocation->isInitialized() && cell != NULL && KIND_GetSize(cell->getType()) == KIND_GetSize(srcKind)) {
+		srcLocation->copy(cell);
+
+		IValue writtenValue = IValue(srcLocation->getType(), cell->getValue());
+		writtenValue.setOffset(cell->getOffset());
+		writtenValue.setBitOffset(cell->getBitOffset());
+		DEBUG_STDOUT("\tUpdated Dst (shadow memory): " << cell->toString());
+
+		if (!checkStore(&writtenValue, srcKind, srcValue)) {
+			DEBUG_STDERR("\twrittenValue: " << writtenValue.toString());
+			DEBUG_STDERR("\tMismatched values found in Store");
+			safe_assert(false);
+		}
+		return;
+	}
+
+	unsigned dstPtrOffset = dstPtrLocation->getOffset();
+	int internalOffset = 0;
+
 	// retrieve actual destination
 	unsigned valueIndex = dstPtrLocation->getIndex();
 	IValue& dstLocation = dstPtrLocation->getIPtrValue(valueIndex);
@@ -644,7 +835,7 @@ void InterpreterObserver::store(int dstInx, SCOPE dstScope, KIND srcKind, SCOPE
 // **** Binary Operations *** //
 inline void InterpreterObserver::binop(IID iid UNUSED, IID liid UNUSED, IID riid UNUSED, SCOPE lScope, SCOPE rScope,
 									   int64_t lValue, int64_t rValue, KIND type, int inx, BINOP op) {
-	IValue* iResult = executionStack.top()[inx];
+	IValue* iResult = state().executionStack.top()[inx];
 	iResult->clear();
 
 	if (type == INT80_KIND) {
@@ -664,7 +855,7 @@ inline void InterpreterObserver::binop(IID iid UNUSED, IID liid UNUSED, IID riid
 		v1 = lValue;
 		d1 = *ptr;
 	} else {  // register
-		IValue* loc1 = (lScope == GLOBAL) ? globalSymbolTable[lValue] : executionStack.top()[lValue];
+		IValue* loc1 = (lScope == GLOBAL) ? globalSymbolTable[lValue] : state().executionStack.top()[lValue];
 		v1 = loc1->getIntValue();
 		d1 = loc1->getFlpValue();
 		DEBUG_STDOUT("\tOperand 01: " << loc1->toString());
@@ -675,7 +866,7 @@ inline void InterpreterObserver::binop(IID iid UNUSED, IID liid UNUSED, IID riid
 		v2 = rValue;
 		d2 = *ptr;
 	} else {  // register
-		IValue* loc2 = (rScope == GLOBAL) ? globalSymbolTable[rValue] : executionStack.top()[rValue];
+		IValue* loc2 = (rScope == GLOBAL) ? globalSymbolTable[rValue] : state().executionStack.top()[rValue];
 		v2 = loc2->getIntValue();
 		d2 = loc2->getFlpValue();
 		DEBUG_STDOUT("\tOperand 02: " << loc2->toString());
@@ -824,14 +1015,14 @@ void InterpreterObserver::bitwise(SCOPE lScope, SCOPE rScope, int64_t lValue, in
 	if (lScope == CONSTANT) {
 		v64_1 = lValue;
 	} else {
-		IValue* iOp1 = (lScope == GLOBAL) ? globalSymbolTable[lValue] : executionStack.top()[lValue];
+		IValue* iOp1 = (lScope == GLOBAL) ? globalSymbolTable[lValue] : state().executionStack.top()[lValue];
 		v64_1 = iOp1->getIntValue();
 	}
 
 	if (rScope == CONSTANT) {
 		v64_2 = rValue;
 	} else {
-		IValue* iOp2 = (rScope == GLOBAL) ? globalSymbolTable[rValue] : executionStack.top()[rValue];
+		IValue* iOp2 = (rScope == GLOBAL) ? globalSymbolTable[rValue] : state().executionStack.top()[rValue];
 		v64_2 = iOp2->getIntValue();
 	}
 
@@ -999,7 +1190,7 @@ void InterpreterObserver::bitwise(SCOPE lScope, SCOPE rScope, int64_t lValue, in
 			return;
 	}
 
-	iResult = executionStack.top()[inx];
+	iResult = state().executionStack.top()[inx];
 	iResult->clear();
 	iResult->setTypeValue(type, result);
 	DEBUG_STDOUT(iResult->toString());
@@ -1056,21 +1247,21 @@ void InterpreterObserver::extractvalue(IID iid UNUSED, int inx, int opinx) {
 	KVALUE* aggKValue;
 
 	// We expect only one index in the getElementPtrIndexList.
-	safe_assert(getElementPtrIndexList.size() == 1);
-	index = getElementPtrIndexList[0];
-	getElementPtrIndexList.pop_back();
+	safe_assert(state().getElementPtrIndexList.size() == 1);
+	index = state().getElementPtrIndexList[0];
+	state().getElementPtrIndexList.pop_back();
 
 	// Obtain KVALUE and IValue objects.
-	aggKValue = returnStruct[0];
+	aggKValue = state().returnStruct[0];
 
 	if (opinx == -1) {
 		aggIValue = NULL;
 	} else {
-		aggIValue = aggKValue->isGlobal ? globalSymbolTable[opinx] : executionStack.top()[opinx];
+		aggIValue = aggKValue->isGlobal ? globalSymbolTable[opinx] : state().executionStack.top()[opinx];
 	}
 
-	aggKValue = returnStruct[index];
-	returnStruct.clear();  // in code some elements stay there
+	aggKValue = state().returnStruct[index];
+	state().returnStruct.clear();  // in code some elements stay there
 
 	DEBUG_STDOUT("KVALUE: " << KVALUE_ToString(aggKValue));
 
@@ -1084,7 +1275,7 @@ void InterpreterObserver::extractvalue(IID iid UNUSED, int inx, int opinx) {
 		iResult.setValue(aggKValue->value);
 	}
 
-	*executionStack.top()[inx] = std::move(iResult);
+	*state().executionStack.top()[inx] = std::move(iResult);
 
 	DEBUG_STDOUT(iResult.toString());
 	return;
@@ -1101,7 +1292,7 @@ void InterpreterObserver::allocax(IID iid UNUSED, KIND type, uint64_t size UNUSE
 	// KVALUE* actualAddress
 	// pre_allocax(iid, type, size, inx, line, arg, actualAddress);
 	// allocating and popularing new array
-	IValue* ptrLocation = executionStack.top()[inx];
+	IValue* ptrLocation = state().executionStack.top()[inx];
 	IValue newPtrLocation =
 		IValue(type == INV_KIND ? PTR_KIND : type, 1, reinterpret_cast<void*>(actualAddress), PTR_KIND, LOCAL);
 
@@ -1112,6 +1303,7 @@ void InterpreterObserver::allocax(IID iid UNUSED, KIND type, uint64_t size UNUSE
 
 	DEBUG_STDOUT("LOCAL alloca");
 	*ptrLocation = std::move(newPtrLocation);
+	mapAlloca(inx);
 
 	safe_assert(ptrLocation->getValueOffset() != -1);
 
@@ -1127,19 +1319,19 @@ void InterpreterObserver::allocax(IID iid UNUSED, KIND type, uint64_t size UNUSE
   // element
   uint64_t structSize = 1;
   if (type == STRUCT_KIND) {
-    structSize = structType.size();
+    structSize = state().structType.size();
   }
 
   IValue* locArr = new IValue[size * structSize];
   for (uint64_t i = 0; i < size; i++) {
     if (type == STRUCT_KIND) {
       for (uint64_t j = 0; j < structSize; j++) {
-        IValue var = IValue(structType[j]);
+        IValue var = IValue(state().structType[j]);
         length++;
         var.setFirstByte(firstByte + bitOffset / 8);
         var.setBitOffset(bitOffset % 8);
         var.setLength(0);
-        KIND structType_j = structType[j];
+        KIND structType_j = state().structType[j];
         firstByte += KIND_GetSize(structType_j);
         bitOffset = (structType_j == INT1_KIND) ? bitOffset + 1 : bitOffset;
         locArr[i * structSize + j] = var;
@@ -1158,7 +1350,7 @@ void InterpreterObserver::allocax(IID iid UNUSED, KIND type, uint64_t size UNUSE
       locArr[i] = var;
     }
   }
-  structType.clear();
+  state().structType.clear();
 
   VALUE value;
   value.as_ptr = (void*)actualAddress;
@@ -1167,44 +1359,45 @@ void InterpreterObserver::allocax(IID iid UNUSED, KIND type, uint64_t size UNUSE
   structPtrVar.setSize(KIND_GetSize(locArr[0].getType()));
   structPtrVar.setLength(length);
 
-  *executionStack.top()[inx] = structPtrVar;
+  *state().executionStack.top()[inx] = structPtrVar;
 
-  DEBUG_STDOUT(executionStack.top()[inx]->toString());
+  DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 
   safe_assert(structPtrVar.getValueOffset() != -1);
   return;
 }*/
 
 void InterpreterObserver::allocax_array(IID iid UNUSED, KIND type, uint64_t size, int inx, uint64_t actualAddress) {
-	// TODO: reserve
+	const TypeLayout* layout = type == STRUCT_KIND ? &takeLayout() : NULL;
+
 	vector<KIND> types;
-	for (int i = 0; i < size; ++i) {
-		if (type != STRUCT_KIND) {
+	types.reserve(layout != NULL ? size * layout->length : size);
+	for (uint64_t i = 0; i < size; ++i) {
+		if (layout == NULL) {
 			types.push_back(type);
-		}
-		for (int j = 0; j < structType.size(); ++j) {
-			types.push_back(structType[j]);
+		} else {
+			types.insert(types.end(), layout->kinds, layout->kinds + layout->length);
 		}
 	}
-	structType.clear();
 
-	*executionStack.top()[inx] = IValue(types, reinterpret_cast<void*>(actualAddress), PTR_KIND, LOCAL);
+	*state().executionStack.top()[inx] = IValue(types, reinterpret_cast<void*>(actualAddress), PTR_KIND, LOCAL);
+	mapAlloca(inx);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
-	safe_assert(executionStack.top()[inx]->getValueOffset() != -1);
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
+	safe_assert(state().executionStack.top()[inx]->getValueOffset() != -1);
 }
 
 /*void InterpreterObserver::allocax_struct(IID iid UNUSED, uint64_t size, int inx, uint64_t actualAddress) {
 
-  safe_assert(structType.size() == size);
+  safe_assert(state().structType.size() == size);
 
   unsigned firstByte = 0;
   unsigned bitOffset = 0;
   unsigned length = 0;
   IValue* ptrToStructVar = new IValue[size];
 
-  for (unsigned i = 0; i < structType.size(); i++) {
-    KIND type = structType[i];
+  for (unsigned i = 0; i < state().structType.size(); i++) {
+    KIND type = state().structType[i];
     IValue var = IValue(type);
     var.setFirstByte(firstByte + bitOffset / 8);
     var.setBitOffset(bitOffset % 8);
@@ -1214,7 +1407,7 @@ void InterpreterObserver::allocax_array(IID iid UNUSED, KIND type, uint64_t size
     length++;
     ptrToStructVar[i] = var;
   }
-  structType.clear();
+  state().structType.clear();
 
   VALUE value;
   value.as_ptr = (void*)actualAddress;
@@ -1223,23 +1416,25 @@ void InterpreterObserver::allocax_array(IID iid UNUSED, KIND type, uint64_t size
   structPtrVar.setSize(KIND_GetSize(ptrToStructVar[0].getType()));
   structPtrVar.setLength(length);
 
-  *executionStack.top()[inx] = structPtrVar;
+  *state().executionStack.top()[inx] = structPtrVar;
 
-  DEBUG_STDOUT(executionStack.top()[inx]->toString());
+  DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 
   safe_assert(structPtrVar.getValueOffset() != -1);
   return;
 }*/
 
 void InterpreterObserver::allocax_struct(IID iid UNUSED, uint64_t size, int inx, uint64_t actualAddress) {
-	safe_assert(structType.size() == size);
+	const TypeLayout& layout = takeLayout();
+	safe_assert(layout.length == size);
 
-	*executionStack.top()[inx] = IValue(structType, reinterpret_cast<void*>(actualAddress), PTR_KIND, LOCAL);
-	structType.clear();
+	*state().executionStack.top()[inx] = IValue(layout.kinds, layout.length, reinterpret_cast<void*>(actualAddress), PTR_KIND,
+										LOCAL);
+	mapAlloca(inx);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 
-	safe_assert(executionStack.top()[inx]->getValueOffset() != -1);
+	safe_assert(state().executionStack.top()[inx]->getValueOffset() != -1);
 }
 
 void InterpreterObserver::fence() {
@@ -1283,14 +1478,14 @@ void InterpreterObserver::getelementptr(IID iid UNUSED, int baseInx, SCOPE baseS
 		if (baseScope == GLOBAL) {
 			basePtrLocation = globalSymbolTable[baseInx];
 		} else {
-			basePtrLocation = executionStack.top()[baseInx];
+			basePtrLocation = state().executionStack.top()[baseInx];
 		}
 	}
 	DEBUG_STDOUT("\tBase pointer operand " << basePtrLocation->toString());
 	// done retriving base pointer operand
 
 	// retrieving index operand
-	index = offsetInx == -1 ? offsetValue : executionStack.top()[offsetInx]->getValue().as_int;
+	index = offsetInx == -1 ? offsetValue : state().executionStack.top()[offsetInx]->getValue().as_int;
 	DEBUG_STDOUT("\tIndex value: " << index);
 
 	// computing actual offset from base pointer in bytes
@@ -1410,10 +1605,13 @@ void InterpreterObserver::getelementptr(IID iid UNUSED, int baseInx, SCOPE baseS
 
 		basePtrLocation->setSize(size / 8);  // REVISE: I thought this would be the original size instead
 
+		// the old cells were unmapped when the old array was released
+		mapBlock(basePtrLocation);
+
 		// update load variable
 		if (loadInx != -1) {
 			// TODO: load can also be a global variable
-			loadInst = loadGlobal ? globalSymbolTable[loadInx] : executionStack.top()[loadInx];
+			loadInst = loadGlobal ? globalSymbolTable[loadInx] : state().executionStack.top()[loadInx];
 
 			// retrieving source
 			IValue& elem = loadInst->getIPtrValue(loadInst->getIndex());
@@ -1434,12 +1632,15 @@ void InterpreterObserver::getelementptr(IID iid UNUSED, int baseInx, SCOPE baseS
 	safe_assert(index < (int)basePtrLocation->getLength());
 	if (index < 0 || (int)array_ind.getFirstByte() != index * (int)size / 8 ||
 			KIND_GetSize(array_ind.getType()) != (int)size / 8) {
-		index = findIndex(basePtrLocation->cbegin(), basePtrLocation->cend(), actualOffset);
+		index = mappedIndex(basePtrLocation, actualOffset);
+		if (index < 0) {
+			index = findIndex(basePtrLocation->cbegin(), basePtrLocation->cend(), actualOffset);
+		}
 	}
 
 	// TODO: This code is dangerous (and silly) - now we have two objects pointing to the same
 	// information one of which can be global (and hence, point to stale data)
-	IValue* ptrLocation = executionStack.top()[inx];
+	IValue* ptrLocation = state().executionStack.top()[inx];
 	if (ptrLocation != basePtrLocation) {
 		ptrLocation->setAll(PTR_KIND, basePtrLocation->getValue(), size / 8,
 							/*actualOffset, */ index, basePtrLocation->getLength(), basePtrLocation->getValueOffset());
@@ -1450,7 +1651,7 @@ void InterpreterObserver::getelementptr(IID iid UNUSED, int baseInx, SCOPE baseS
 
 	ptrLocation->setOffset(actualOffset);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 	return;
 }
 
@@ -1469,8 +1670,8 @@ void InterpreterObserver::getelementptr_array(int baseInx, SCOPE baseScope, uint
 		value.as_ptr = (void*)baseAddr;
 		arrayElemPtr = IValue(PTR_KIND, value, 0, 0, 0, 0);
 
-		getElementPtrIndexList.clear();
-		arraySize.clear();
+		state().getElementPtrIndexList.clear();
+		state().arraySize.clear();
 	} else {
 		IValue* ptrArray;
 		int index, arrayDim;
@@ -1479,14 +1680,14 @@ void InterpreterObserver::getelementptr_array(int baseInx, SCOPE baseScope, uint
 		if (baseScope == GLOBAL) {
 			ptrArray = globalSymbolTable[baseInx];
 		} else {
-			ptrArray = executionStack.top()[baseInx];
+			ptrArray = state().executionStack.top()[baseInx];
 		}
 
 		DEBUG_STDOUT("\tPointer operand: " << ptrArray->toString());
 
 		// compute the index for flatten array representation of
 		// the program's multi-dimensional array
-		arrayDim = (size02 != -1) ? arraySize.size() + 2 : 1;
+		arrayDim = (size02 != -1) ? state().arraySize.size() + 2 : 1;
 
 		if (scopeInx02 == SCOPE_INVALID) {
 			scopeInx02 = CONSTANT;
@@ -1496,7 +1697,7 @@ void InterpreterObserver::getelementptr_array(int baseInx, SCOPE baseScope, uint
 		if (scopeInx03 == SCOPE_INVALID) {
 			getIndexNo = 1;
 		} else {
-			getIndexNo = getElementPtrIndexList.size() + 2;
+			getIndexNo = state().getElementPtrIndexList.size() + 2;
 		}
 
 		DEBUG_STDOUT("arrayDim " << arrayDim);
@@ -1513,12 +1714,12 @@ void InterpreterObserver::getelementptr_array(int baseInx, SCOPE baseScope, uint
 		if (size02 != -1) {
 			arraySizeVec[0] = size02;
 
-			for (unsigned i = 1; i < arraySize.size(); i++) {
+			for (unsigned i = 1; i < state().arraySize.size(); i++) {
 				if (i < getIndexNo) {
-					arraySizeVec[i] = arraySize[i - 1];
+					arraySizeVec[i] = state().arraySize[i - 1];
 				}
 			}
-			arraySize.clear();
+			state().arraySize.clear();
 		}
 
 		arraySizeVec[getIndexNo - 1] = 1;
@@ -1538,10 +1739,10 @@ void InterpreterObserver::getelementptr_array(int baseInx, SCOPE baseScope, uint
 			indexVec[1] = actualValueToIntValue(scopeInx03, valOrInx03);
 			unsigned i = 2;
 
-			for (unsigned int j = 0; j < getElementPtrIndexList.size(); j++) {
-				indexVec[i + j] = getElementPtrIndexList[j];
+			for (unsigned int j = 0; j < state().getElementPtrIndexList.size(); j++) {
+				indexVec[i + j] = state().getElementPtrIndexList[j];
 			}
-			getElementPtrIndexList.clear();
+			state().getElementPtrIndexList.clear();
 		}
 
 		index = 0;
@@ -1556,48 +1757,95 @@ void InterpreterObserver::getelementptr_array(int baseInx, SCOPE baseScope, uint
 		// compute new offset for flatten array
 		newOffset = ptrArray->getOffset() + elementSize * index;
 
-		// compute the index for the casted fatten array
-		if (ptrArray->isInitialized()) {
-			index = findIndex(ptrArray->cbegin(), ptrArray->cend(), newOffset);
-		}
+		arrayElemPtr = arrayElementPtr(ptrArray, offset_into_ptrArray, index, newOffset, inx);
+	}  // baseInx != -1
 
-		DEBUG_STDOUT("\tIndex: " << index);
+	safe_assert(state().getElementPtrIndexList.empty());
 
-		// TODO: revisit this
-		if (index < (int)ptrArray->getLength()) {
-			IValue& arrayElem = ptrArray->getIPtrValue(index + offset_into_ptrArray);
-			arrayElemPtr = IValue(PTR_KIND, ptrArray->getValue());
-			arrayElemPtr.setValueOffset(ptrArray->getValueOffset());
-			arrayElemPtr.setIndex(index);
-			arrayElemPtr.setLength(ptrArray->getLength());
-			arrayElemPtr.setSize(KIND_GetSize(arrayElem.getType()));
-			arrayElemPtr.setOffset(arrayElem.getFirstByte());
-		} else {
-			VALUE arrayElemPtrValue;
-			arrayElemPtrValue.as_int = ptrArray->getValue().as_int + newOffset;
-			arrayElemPtr = IValue(PTR_KIND, arrayElemPtrValue, ptrArray->getSize(), 0, 0, 0);
-			// TODO: why are we storing the offset from *this* to some (int) value?
-			arrayElemPtr.setValueOffset((int64_t)executionStack.top()[inx] - arrayElemPtr.getValue().as_int);
+	*state().executionStack.top()[inx] = std::move(arrayElemPtr);
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
+	return;
+}
+
+void InterpreterObserver::getelementptr_strided(int baseInx, SCOPE baseScope, uint64_t baseAddr, int elementSize,
+		int ptrScope, int64_t ptrValOrInx, int64_t constOffset, int count,
+		const GEPINDEX* indices, int inx) {
+	IValue arrayElemPtr;
+
+	if (baseInx == -1) {
+		// TODO: review this constant pointer return a dummy object
+		VALUE value;
+		value.as_ptr = (void*)baseAddr;
+		arrayElemPtr = IValue(PTR_KIND, value, 0, 0, 0, 0);
+	} else {
+		IValue* ptrArray = baseScope == GLOBAL ? globalSymbolTable[baseInx] : state().executionStack.top()[baseInx];
+
+		DEBUG_STDOUT("\tPointer operand: " << ptrArray->toString());
+
+		// the constant indices are folded into constOffset by the pass
+		int64_t offset = constOffset;
+		for (int i = 0; i < count; i++) {
+			offset += actualValueToIntValue(indices[i].scope, indices[i].valOrInx) * indices[i].stride;
 		}
-	}  // baseInx != -1
+		DEBUG_STDOUT("\tOffset: " << offset);
+
+		// the first index is for the pointer operand
+		unsigned offset_into_ptrArray = actualValueToIntValue(ptrScope, ptrValOrInx);
+		int index = elementSize > 0 ? offset / elementSize : 0;
 
-	safe_assert(getElementPtrIndexList.empty());
+		arrayElemPtr = arrayElementPtr(ptrArray, offset_into_ptrArray, index, ptrArray->getOffset() + offset, inx);
+	}
 
-	*executionStack.top()[inx] = std::move(arrayElemPtr);
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	*state().executionStack.top()[inx] = std::move(arrayElemPtr);
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 	return;
 }
 
+IValue InterpreterObserver::arrayElementPtr(IValue* ptrArray, unsigned offsetIntoArray, int index, int newOffset,
+		int inx) {
+	IValue arrayElemPtr;
+
+	// compute the index for the casted fatten array
+	if (ptrArray->isInitialized()) {
+		index = mappedIndex(ptrArray, newOffset);
+		if (index < 0) {
+			int guess = ptrArray->getSize() > 0 ? newOffset / (int)ptrArray->getSize() : -1;
+			index = findIndex(ptrArray->cbegin(), ptrArray->cend(), newOffset, guess);
+		}
+	}
+
+	DEBUG_STDOUT("\tIndex: " << index);
+
+	// TODO: revisit this
+	if (index < (int)ptrArray->getLength()) {
+		IValue& arrayElem = ptrArray->getIPtrValue(index + offsetIntoArray);
+		arrayElemPtr = IValue(PTR_KIND, ptrArray->getValue());
+		arrayElemPtr.setValueOffset(ptrArray->getValueOffset());
+		arrayElemPtr.setIndex(index);
+		arrayElemPtr.setLength(ptrArray->getLength());
+		arrayElemPtr.setSize(KIND_GetSize(arrayElem.getType()));
+		arrayElemPtr.setOffset(arrayElem.getFirstByte());
+	} else {
+		VALUE arrayElemPtrValue;
+		arrayElemPtrValue.as_int = ptrArray->getValue().as_int + newOffset;
+		arrayElemPtr = IValue(PTR_KIND, arrayElemPtrValue, ptrArray->getSize(), 0, 0, 0);
+		// TODO: why are we storing the offset from *this* to some (int) value?
+		arrayElemPtr.setValueOffset((int64_t)state().executionStack.top()[inx] - arrayElemPtr.getValue().as_int);
+	}
+	return arrayElemPtr;
+}
+
 void InterpreterObserver::getelementptr_struct(IID iid UNUSED, int baseInx, SCOPE baseScope, uint64_t baseAddr,
 		int inx) {
 
 	// TODO: much of this code is duplicated above
 
-	DEBUG_STDOUT("\tstructType size " << structType.size());
+	const TypeLayout& layout = takeLayout();
+
+	DEBUG_STDOUT("\tstructType size " << layout.length);
 
 	IValue* structPtr, structElemPtr;
 	int structElemNo, structSize, index, size, newOffset;
-	int* structElemSize, *structElem;
 
 	if (baseInx == -1) {
 		// TODO: review this
@@ -1607,67 +1855,37 @@ void InterpreterObserver::getelementptr_struct(IID iid UNUSED, int baseInx, SCOP
 		value.as_ptr = (void*)baseAddr;
 		structElemPtr = IValue(PTR_KIND, value, 0, 0, 0, 0);
 
-		getElementPtrIndexList.clear();
-
-		while (!structElementSize.empty()) {
-			structElementSize.pop();
-		}
+		state().getElementPtrIndexList.clear();
 	} else {
 		// get the struct operand
 		if (baseScope == GLOBAL) {
 			structPtr = globalSymbolTable[baseInx];
 		} else {
-			structPtr = executionStack.top()[baseInx];
+			structPtr = state().executionStack.top()[baseInx];
 		}
-		structElemNo = structType.size();
-
-		// TODO: replace with vector - there is no good reason to use a naked new
-		// here
-		structElemSize = new int[structElemNo];
-		structElem = new int[structElemNo];
-
-		// record struct element size
-		// compute struct size
-		structSize = 0;
-
-		for (unsigned i = 0; i < structType.size(); i++) {
-			structElemSize[i] = KIND_GetSize(structType[i]);
-			structElem[i] = structType[i];
-			structSize += structElemSize[i];
-		}
-		structType.clear();
+		structElemNo = layout.length;
+		structSize = layout.size;
 
 		DEBUG_STDOUT("\tstructSize is " << structSize);
 
 		DEBUG_STDOUT("\t" << structPtr->toString());
 
 		// compute struct index
-		DEBUG_STDOUT("\tsize of getElementPtrIndexList: " << getElementPtrIndexList.size());
-
-		index = getElementPtrIndexList[0] * structElemNo;
-		if (getElementPtrIndexList.size() > 1) {
-			for (unsigned int i = 0; i < getElementPtrIndexList[1]; i++) {
-				index = index + structElementSize.front();
-				safe_assert(!structElementSize.empty());
-				structElementSize.pop();
-			}
-		}
-		getElementPtrIndexList.clear();
+		DEBUG_STDOUT("\tsize of getElementPtrIndexList: " << state().getElementPtrIndexList.size());
 
-		while (!structElementSize.empty()) {
-			structElementSize.pop();
+		index = state().getElementPtrIndexList[0] * structElemNo;
+		if (state().getElementPtrIndexList.size() > 1) {
+			safe_assert(state().getElementPtrIndexList[1] < layout.fields);
+			index = index + layout.fieldStarts[state().getElementPtrIndexList[1]];
 		}
-		safe_assert(getElementPtrIndexList.empty());
+		state().getElementPtrIndexList.clear();
+		safe_assert(state().getElementPtrIndexList.empty());
 
 		DEBUG_STDOUT("\tIndex is " << index);
 
-		newOffset = structSize * (index / structElemNo);
-		for (int i = 0; i < index % structElemNo; i++) {
-			newOffset = newOffset + KIND_GetSize(structElem[i]);
-		}
-
+		newOffset = structSize * (index / structElemNo) + layout.offsets[index % structElemNo];
 		newOffset = newOffset + structPtr->getOffset();
-		size = KIND_GetSize(structElem[index % structElemNo]);
+		size = KIND_GetSize(layout.kinds[index % structElemNo]);
 
 		DEBUG_STDOUT("\tNew offset is: " << newOffset);
 
@@ -1675,7 +1893,12 @@ void InterpreterObserver::getelementptr_struct(IID iid UNUSED, int baseInx, SCOP
 		// initialized and is not initialized
 		if (structPtr->isInitialized()) {
 
-			index = findIndex(structPtr->cbegin(), structPtr->cend(), newOffset);  // TODO: revise offset, getValue().as_ptr
+			// common case: the element has a cell in the shadow memory, or the
+			// memory has the layout of the struct, so the element sits at the
+			// index the layout predicts
+			int mapped = mappedIndex(structPtr, newOffset);
+			index = mapped >= 0 ? mapped : findIndex(structPtr->cbegin(), structPtr->cend(), newOffset,
+					index + structPtr->getIndex());  // TODO: revise offset, getValue().as_ptr
 
 			DEBUG_STDOUT("\tNew index is: " << index);
 
@@ -1704,13 +1927,13 @@ void InterpreterObserver::getelementptr_struct(IID iid UNUSED, int baseInx, SCOP
 
 			structElemPtr = IValue(PTR_KIND, structElemPtrValue, size, 0, 0, 0);
 			// TODO: why are we storing the offset from *this*?
-			structElemPtr.setValueOffset((int64_t)executionStack.top()[inx] - structElemPtr.getValue().as_int);
+			structElemPtr.setValueOffset((int64_t)state().executionStack.top()[inx] - structElemPtr.getValue().as_int);
 		}
 	}
 
-	*executionStack.top()[inx] = std::move(structElemPtr);
+	*state().executionStack.top()[inx] = std::move(structElemPtr);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 	return;
 }
 
@@ -1743,7 +1966,7 @@ void InterpreterObserver::castop(int64_t opVal, SCOPE opScope, KIND opType, KIND
 
 	} else {
 
-		iOp = (opScope == GLOBAL) ? globalSymbolTable[opVal] : executionStack.top()[opVal];
+		iOp = (opScope == GLOBAL) ? globalSymbolTable[opVal] : state().executionStack.top()[opVal];
 		opIntValue = iOp->getIntValue();
 		opUIntValue = iOp->getUIntValue();
 		opFlpValue = iOp->getFlpValue();
@@ -1975,7 +2198,7 @@ void InterpreterObserver::castop(int64_t opVal, SCOPE opScope, KIND opType, KIND
 			safe_assert(false);
 	}
 
-	iResult = executionStack.top()[inx];
+	iResult = state().executionStack.top()[inx];
 
 	if (op == BITCAST) {
 		if (opScope == CONSTANT) {
@@ -2060,7 +2283,7 @@ void InterpreterObserver::branch(IID iid UNUSED, bool conditional UNUSED, int va
 
 	// TODO: how about the SCOPE == GLOBAL?
 
-	IValue* cond = (valInx == -1) ? NULL : executionStack.top()[valInx];
+	IValue* cond = (valInx == -1) ? NULL : state().executionStack.top()[valInx];
 
 	if (cond != NULL && ((bool)cond->getIntValue() != (bool)value)) {  // revise this: before value.as_int
 		DEBUG_STDERR("\tKVALUE: "
@@ -2082,12 +2305,12 @@ void InterpreterObserver::invoke(IID iid UNUSED, KVALUE* call_value UNUSED, int
 	int count;
 
 	count = 0;
-	while (!myStack.empty()) {
+	while (!state().myStack.empty()) {
 		KVALUE argument;
 
-		argument = myStack.top();
+		argument = state().myStack.top();
 		DEBUG_STDOUT("\t Argument " << count << ": " << KVALUE_ToString(&argument));
-		myStack.pop();
+		state().myStack.pop();
 	}
 
 	DEBUG_STDERR("Unimplemented function.");
@@ -2100,93 +2323,95 @@ void InterpreterObserver::resume(IID iid UNUSED, KVALUE* op1 UNUSED, int inx UNU
 }
 
 void InterpreterObserver::return_(IID iid UNUSED, int valInx, SCOPE scope UNUSED, KIND type, int64_t value) {
-	safe_assert(!executionStack.empty());
+	safe_assert(!state().executionStack.empty());
 
-	std::vector<IValue*> iValues;
-	iValues = executionStack.top();
+	// The callee frame is popped only after the return value has been copied
+	// to the caller, because the frame owns the returned value.
+	Frame& iValues = state().executionStack.top();
 
-	IValue* returnValue = valInx == -1 ? NULL : executionStack.top()[valInx];
+	IValue* returnValue = valInx == -1 ? NULL : iValues[valInx];
 
-	executionStack.pop();
-
-	if (!executionStack.empty()) {
-		DEBUG_STDOUT("New stack size: " << executionStack.size());
-		safe_assert(!callerVarIndex.empty());
+	if (state().executionStack.size() > 1) {
+		DEBUG_STDOUT("New stack size: " << state().executionStack.size() - 1);
+		safe_assert(!state().callerVarIndex.empty());
 
+		Frame& caller = state().executionStack.caller();
 		if (returnValue == NULL) {
-			executionStack.top()[callerVarIndex.top()]->setType(type);
-			executionStack.top()[callerVarIndex.top()]->setValue(value);
+			caller[state().callerVarIndex.top()]->setType(type);
+			caller[state().callerVarIndex.top()]->setValue(value);
 		} else {
-			returnValue->copy(executionStack.top()[callerVarIndex.top()]);
+			returnValue->copy(caller[state().callerVarIndex.top()]);
 		}
-		DEBUG_STDOUT(executionStack.top()[callerVarIndex.top()]->toString());
-
-		callerVarIndex.pop();
-	} else {
-		cout << "The execution stack is empty.\n";
+		DEBUG_STDOUT(caller[state().callerVarIndex.top()]->toString());
 
-		post_analysis();
+		state().callerVarIndex.pop();
 	}
 
 	// free memory
 	// should not be erasing above stuff twice
 
 	for (unsigned int i = 0; i < iValues.size(); i++) {
-		release(iValues[i]);
+		release(iValues, i);
+	}
+	state().executionStack.pop();
+
+	if (state().executionStack.empty() && std::this_thread::get_id() == mainThread) {
+		cout << "The execution stack is empty.\n";
+		cerr << "[shadow heap] live: " << liveHeapBytes << " bytes, peak: " << peakHeapBytes << " bytes\n";
+		printSyncReport();
+
+		post_analysis();
 	}
 	IValue::printCounters();
 
-	isReturn = true;
+	state().isReturn = true;
 	return;
 }
 
 void InterpreterObserver::return2_(IID iid UNUSED, int inx UNUSED) {
 
-	safe_assert(!executionStack.empty());
-
-	std::vector<IValue*> iValues;
-	iValues = executionStack.top();
+	safe_assert(!state().executionStack.empty());
 
-	executionStack.pop();
+	// freeing memory
+	Frame& iValues = state().executionStack.top();
+	for (unsigned int i = 0; i < iValues.size(); i++) {
+		release(iValues, i);
+	}
+	state().executionStack.pop();
 
-	if (!executionStack.empty()) {
-		DEBUG_STDOUT("New stack size: " << executionStack.size());
+	if (!state().executionStack.empty()) {
+		DEBUG_STDOUT("New stack size: " << state().executionStack.size());
 	} else {
 		cout << "The execution stack is empty.\n";
 	}
 
-	// freeing memory
-	for (unsigned int i = 0; i < iValues.size(); i++) {
-		release(iValues[i]);
-	}
-
 	IValue::printCounters();
-	isReturn = true;
+	state().isReturn = true;
 	return;
 }
 
 void InterpreterObserver::return_struct_(IID iid UNUSED, int inx UNUSED, int valInx) {
 
-	safe_assert(!executionStack.empty());
+	safe_assert(!state().executionStack.empty());
 
-	std::vector<IValue*> iValues;
-	iValues = executionStack.top();
+	// As in return_, the callee frame is popped after the copy to the caller.
+	Frame& iValues = state().executionStack.top();
 
-	IValue* returnValue = (valInx == -1) ? NULL : executionStack.top()[valInx];
+	IValue* returnValue = (valInx == -1) ? NULL : iValues[valInx];
 
-	executionStack.pop();
+	if (state().executionStack.size() > 1) {
+		DEBUG_STDOUT("New stack size: " << state().executionStack.size() - 1);
+		safe_assert(!state().callerVarIndex.empty());
+		safe_assert(!state().returnStruct.empty());
 
-	if (!executionStack.empty()) {
-		DEBUG_STDOUT("New stack size: " << executionStack.size());
-		safe_assert(!callerVarIndex.empty());
-		safe_assert(!returnStruct.empty());
+		Frame& caller = state().executionStack.caller();
 
 		// reconstruct struct value
-		unsigned structSize = returnStruct.size();
+		unsigned structSize = state().returnStruct.size();
 		IValue* structValue = new IValue[structSize];
 
 		for (unsigned i = 0; i < structSize; i++) {
-			KVALUE* value = returnStruct[i];
+			KVALUE* value = state().returnStruct[i];
 
 			if (returnValue == NULL) {
 				structValue[i].setType(value->kind);
@@ -2199,35 +2424,36 @@ void InterpreterObserver::return_struct_(IID iid UNUSED, int inx UNUSED, int val
 
 			DEBUG_STDOUT(cout << structValue[i].toString());
 		}
-		returnStruct.clear();
+		state().returnStruct.clear();
 
 		structValue->setStruct(true);
 
-		release(executionStack.top()[callerVarIndex.top()]);
-		executionStack.top()[callerVarIndex.top()] = structValue;
+		release(caller, state().callerVarIndex.top());
+		caller.redirect(state().callerVarIndex.top(), structValue);
 		/*
 		                        for (i = 0; i < size; i++) {
 
 
-		      DEBUG_STDOUT(executionStack.top()[callerVarIndex.top()][i].toString());
+		      DEBUG_STDOUT(caller[state().callerVarIndex.top()][i].toString());
 		                        }
 		                        */
 	} else {
 		cout << "The execution stack is empty.\n";
 	}
 
-	safe_assert(!callerVarIndex.empty());
-	callerVarIndex.pop();
+	safe_assert(!state().callerVarIndex.empty());
+	state().callerVarIndex.pop();
 
 	// freeing memory
 	for (unsigned int i = 0; i < iValues.size(); i++) {
 		// if (i != (unsigned)valInx) {  // TODO: do not delete struct from now, make copy first!
-		release(iValues[i]);
+		release(iValues, i);
 		//}
 	}
+	state().executionStack.pop();
 
 	IValue::printCounters();
-	isReturn = true;
+	state().isReturn = true;
 	return;
 }
 
@@ -2252,7 +2478,7 @@ void InterpreterObserver::icmp(SCOPE lScope, SCOPE rScope, int64_t lValue, int64
 	if (lScope == CONSTANT) {  // constant
 		v1 = lValue;
 	} else {
-		IValue* loc1 = (lScope == GLOBAL) ? globalSymbolTable[lValue] : executionStack.top()[lValue];
+		IValue* loc1 = (lScope == GLOBAL) ? globalSymbolTable[lValue] : state().executionStack.top()[lValue];
 		v1 = loc1->getType() == PTR_KIND ? loc1->getIntValue() + loc1->getOffset() : loc1->getIntValue();
 	}
 
@@ -2260,7 +2486,7 @@ void InterpreterObserver::icmp(SCOPE lScope, SCOPE rScope, int64_t lValue, int64
 	if (rScope == CONSTANT) {  // constant
 		v2 = rValue;
 	} else {
-		IValue* loc2 = (rScope == GLOBAL) ? globalSymbolTable[rValue] : executionStack.top()[rValue];
+		IValue* loc2 = (rScope == GLOBAL) ? globalSymbolTable[rValue] : state().executionStack.top()[rValue];
 		v2 = loc2->getType() == PTR_KIND ? loc2->getIntValue() + loc2->getOffset() : loc2->getIntValue();
 	}
 
@@ -2314,7 +2540,7 @@ void InterpreterObserver::icmp(SCOPE lScope, SCOPE rScope, int64_t lValue, int64
 			break;
 	}
 
-	IValue* iResult = executionStack.top()[inx];
+	IValue* iResult = state().executionStack.top()[inx];
 	iResult->clear();
 	iResult->setTypeValue(INT1_KIND, result);
 	iResult->setSize(0);  // size for INT1_KIND
@@ -2335,7 +2561,7 @@ void InterpreterObserver::fcmp(SCOPE lScope, SCOPE rScope, int64_t lValue, int64
 		double* ptr = (double*)&lValue;
 		v1 = *ptr;
 	} else {
-		IValue* loc1 = (lScope == GLOBAL) ? globalSymbolTable[lValue] : executionStack.top()[lValue];
+		IValue* loc1 = (lScope == GLOBAL) ? globalSymbolTable[lValue] : state().executionStack.top()[lValue];
 		v1 = loc1->getFlpValue();
 	}
 
@@ -2344,7 +2570,7 @@ void InterpreterObserver::fcmp(SCOPE lScope, SCOPE rScope, int64_t lValue, int64
 		double* ptr = (double*)&rValue;
 		v2 = *ptr;
 	} else {
-		IValue* loc2 = (rScope == GLOBAL) ? globalSymbolTable[rValue] : executionStack.top()[rValue];
+		IValue* loc2 = (rScope == GLOBAL) ? globalSymbolTable[rValue] : state().executionStack.top()[rValue];
 		v2 = loc2->getFlpValue();
 	}
 
@@ -2413,7 +2639,7 @@ void InterpreterObserver::fcmp(SCOPE lScope, SCOPE rScope, int64_t lValue, int64
 			break;
 	}
 
-	IValue* iResult = executionStack.top()[inx];
+	IValue* iResult = state().executionStack.top()[inx];
 	iResult->clear();
 	iResult->setTypeValue(INT1_KIND, result);
 	DEBUG_STDOUT(iResult->toString());
@@ -2424,30 +2650,57 @@ void InterpreterObserver::fcmp(SCOPE lScope, SCOPE rScope, int64_t lValue, int64
 
 void InterpreterObserver::phinode(IID iid UNUSED, int inx) {
 
-	DEBUG_STDOUT("Recent block: " << recentBlock.top());
+	DEBUG_STDOUT("Recent block: " << state().recentBlock.top());
 
 	IValue phiNode;
 
-	if (phinodeConstantValues.find(recentBlock.top()) != phinodeConstantValues.end()) {
-		KVALUE* constant = phinodeConstantValues[recentBlock.top()];
+	if (state().phinodeConstantValues.find(state().recentBlock.top()) != state().phinodeConstantValues.end()) {
+		KVALUE* constant = state().phinodeConstantValues[state().recentBlock.top()];
 		phiNode = IValue(constant->kind, constant->value);
 		phiNode.setLength(0);
 	} else {
-		safe_assert(phinodeValues.find(recentBlock.top()) != phinodeValues.end());
-		IValue* inValue = executionStack.top()[phinodeValues[recentBlock.top()]];
+		safe_assert(state().phinodeValues.find(state().recentBlock.top()) != state().phinodeValues.end());
+		IValue* inValue = state().executionStack.top()[state().phinodeValues[state().recentBlock.top()]];
 		phiNode = IValue();
 		inValue->copy(&phiNode);
 	}
 
-	phinodeConstantValues.clear();
-	phinodeValues.clear();
+	state().phinodeConstantValues.clear();
+	state().phinodeValues.clear();
 
-	*executionStack.top()[inx] = std::move(phiNode);
+	*state().executionStack.top()[inx] = std::move(phiNode);
 
 	DEBUG_STDOUT(phiNode.toString());
 	return;
 }
 
+void InterpreterObserver::phinode_table(IID iid UNUSED, int count, const PHIARG* incoming, int inx) {
+
+	int block = state().recentBlock.top();
+	DEBUG_STDOUT("Recent block: " << block);
+
+	const PHIARG* in = incoming;
+	const PHIARG* end = incoming + count;
+	while (in != end && in->block != block) {
+		in++;
+	}
+	safe_assert(in != end);
+
+	IValue* phiNode = state().executionStack.top()[inx];
+	if (in->inx == -1) {
+		*phiNode = IValue(in->kind, in->value);
+		phiNode->setLength(0);
+	} else {
+		// the incoming value may be the phi node itself
+		IValue inValue;
+		state().executionStack.top()[in->inx]->copy(&inValue);
+		*phiNode = std::move(inValue);
+	}
+
+	DEBUG_STDOUT(phiNode->toString());
+	return;
+}
+
 void InterpreterObserver::select(IID iid UNUSED, KVALUE* cond, KVALUE* tvalue, KVALUE* fvalue, int inx) {
 
 	int condition;
@@ -2456,7 +2709,7 @@ void InterpreterObserver::select(IID iid UNUSED, KVALUE* cond, KVALUE* tvalue, K
 	if (cond->inx == -1) {
 		condition = cond->value.as_int;
 	} else {
-		conditionValue = cond->isGlobal ? globalSymbolTable[cond->inx] : executionStack.top()[cond->inx];
+		conditionValue = cond->isGlobal ? globalSymbolTable[cond->inx] : state().executionStack.top()[cond->inx];
 		condition = conditionValue->getValue().as_int;
 	}
 
@@ -2465,7 +2718,7 @@ void InterpreterObserver::select(IID iid UNUSED, KVALUE* cond, KVALUE* tvalue, K
 			result = IValue(tvalue->kind, tvalue->value, REGISTER);
 		} else {
 			result = IValue();
-			trueValue = tvalue->isGlobal ? globalSymbolTable[tvalue->inx] : executionStack.top()[tvalue->inx];
+			trueValue = tvalue->isGlobal ? globalSymbolTable[tvalue->inx] : state().executionStack.top()[tvalue->inx];
 			trueValue->copy(&result);
 		}
 	} else {
@@ -2473,12 +2726,12 @@ void InterpreterObserver::select(IID iid UNUSED, KVALUE* cond, KVALUE* tvalue, K
 			result = IValue(fvalue->kind, fvalue->value, REGISTER);
 		} else {
 			result = IValue();
-			falseValue = fvalue->isGlobal ? globalSymbolTable[fvalue->inx] : executionStack.top()[fvalue->inx];
+			falseValue = fvalue->isGlobal ? globalSymbolTable[fvalue->inx] : state().executionStack.top()[fvalue->inx];
 			falseValue->copy(&result);
 		}
 	}
 
-	*executionStack.top()[inx] = std::move(result);
+	*state().executionStack.top()[inx] = std::move(result);
 
 	DEBUG_STDOUT("Result is " << result.toString());
 	return;
@@ -2500,37 +2753,97 @@ void InterpreterObserver::push_stack(int inx, SCOPE scope, KIND type, uint64_t a
 	}
 	kvalue.kind = type;
 	kvalue.value.as_ptr = (void*)addr;
-	myStack.push(kvalue);
+	state().myStack.push(kvalue);
 	return;
 }
 
 void InterpreterObserver::push_phinode_constant_value(KVALUE* value, int blockId) {
-	phinodeConstantValues[blockId] = value;
+	state().phinodeConstantValues[blockId] = value;
 	return;
 }
 
 void InterpreterObserver::push_phinode_value(int valId, int blockId) {
-	phinodeValues[blockId] = valId;
+	state().phinodeValues[blockId] = valId;
 	return;
 }
 
 void InterpreterObserver::push_return_struct(KVALUE* value) {
-	returnStruct.push_back(value);
+	state().returnStruct.push_back(value);
 	return;
 }
 
 void InterpreterObserver::push_struct_type(KIND kind) {
-	structType.push_back(kind);
+	state().structType.push_back(kind);
 	return;
 }
 
 void InterpreterObserver::push_struct_element_size(uint64_t s) {
-	structElementSize.push(s);
+	state().structElementSize.push(s);
 	return;
 }
 
+void InterpreterObserver::register_type_layout(int id, int length, const KIND* kinds, const unsigned* offsets,
+		int fields, const unsigned* fieldStarts) {
+	safe_assert(id >= 0);
+
+	TypeLayout layout;
+	layout.length = length;
+	layout.kinds = kinds;
+	layout.offsets = offsets;
+	layout.size = length > 0 ? offsets[length - 1] + KIND_GetSize(kinds[length - 1]) : 0;
+	layout.fields = fields;
+	layout.fieldStarts = fieldStarts;
+
+	if ((unsigned)id >= typeLayouts.size()) {
+		typeLayouts.resize(id + 1);
+	}
+	typeLayouts[id] = layout;
+	return;
+}
+
+void InterpreterObserver::push_type_layout(int id) {
+	safe_assert((unsigned)id < typeLayouts.size());
+	state().currentLayout = &typeLayouts[id];
+	return;
+}
+
+const InterpreterObserver::TypeLayout& InterpreterObserver::takeLayout() {
+	if (state().currentLayout != NULL) {
+		const TypeLayout* layout = state().currentLayout;
+		state().currentLayout = NULL;
+		return *layout;
+	}
+
+	// the layout was pushed one element at a time
+	state().pushedKinds.swap(state().structType);
+	state().structType.clear();
+
+	unsigned offset = 0;
+	state().pushedOffsets.clear();
+	for (KIND kind : state().pushedKinds) {
+		state().pushedOffsets.push_back(offset);
+		offset += KIND_GetSize(kind);
+	}
+
+	unsigned start = 0;
+	state().pushedFieldStarts.clear();
+	while (!state().structElementSize.empty()) {
+		state().pushedFieldStarts.push_back(start);
+		start += state().structElementSize.front();
+		state().structElementSize.pop();
+	}
+
+	state().pushedLayout.length = state().pushedKinds.size();
+	state().pushedLayout.kinds = state().pushedKinds.data();
+	state().pushedLayout.offsets = state().pushedOffsets.data();
+	state().pushedLayout.size = offset;
+	state().pushedLayout.fields = state().pushedFieldStarts.size();
+	state().pushedLayout.fieldStarts = state().pushedFieldStarts.data();
+	return state().pushedLayout;
+}
+
 void InterpreterObserver::push_getelementptr_inx(uint64_t index) {
-	getElementPtrIndexList.push_back(index);
+	state().getElementPtrIndexList.push_back(index);
 	return;
 }
 
@@ -2539,7 +2852,7 @@ int InterpreterObserver::actualValueToIntValue(int scope, int64_t vori) {
 		case CONSTANT:
 			return vori;
 		case LOCAL:
-			return executionStack.top()[vori]->getIntValue();
+			return state().executionStack.top()[vori]->getIntValue();
 		case GLOBAL:
 			return globalSymbolTable[vori]->getIntValue();
 		default:
@@ -2554,23 +2867,23 @@ void InterpreterObserver::push_getelementptr_inx5(int scope01, int scope02, int
 	int value;
 	if (scope01 != SCOPE_INVALID) {
 		value = actualValueToIntValue(scope01, vori01);
-		getElementPtrIndexList.push_back(value);
+		state().getElementPtrIndexList.push_back(value);
 
 		if (scope02 != SCOPE_INVALID) {
 			value = actualValueToIntValue(scope02, vori02);
-			getElementPtrIndexList.push_back(value);
+			state().getElementPtrIndexList.push_back(value);
 
 			if (scope03 != SCOPE_INVALID) {
 				value = actualValueToIntValue(scope03, vori03);
-				getElementPtrIndexList.push_back(value);
+				state().getElementPtrIndexList.push_back(value);
 
 				if (scope04 != SCOPE_INVALID) {
 					value = actualValueToIntValue(scope04, vori04);
-					getElementPtrIndexList.push_back(value);
+					state().getElementPtrIndexList.push_back(value);
 
 					if (scope05 != SCOPE_INVALID) {
 						value = actualValueToIntValue(scope05, vori05);
-						getElementPtrIndexList.push_back(value);
+						state().getElementPtrIndexList.push_back(value);
 					}
 				}
 			}
@@ -2581,26 +2894,26 @@ void InterpreterObserver::push_getelementptr_inx5(int scope01, int scope02, int
 
 void InterpreterObserver::push_getelementptr_inx2(int int_value) {
 	int idx = int_value;
-	getElementPtrIndexList.push_back(idx);
+	state().getElementPtrIndexList.push_back(idx);
 	return;
 }
 
 void InterpreterObserver::push_array_size(uint64_t size) {
-	arraySize.push_back(size);
+	state().arraySize.push_back(size);
 	return;
 }
 
 void InterpreterObserver::push_array_size5(int s1, int s2, int s3, int s4, int s5) {
 	if (s1 != -1) {
-		arraySize.push_back(s1);
+		state().arraySize.push_back(s1);
 		if (s2 != -1) {
-			arraySize.push_back(s2);
+			state().arraySize.push_back(s2);
 			if (s3 != -1) {
-				arraySize.push_back(s3);
+				state().arraySize.push_back(s3);
 				if (s4 != -1) {
-					arraySize.push_back(s4);
+					state().arraySize.push_back(s4);
 					if (s5 != -1) {
-						arraySize.push_back(s5);
+						state().arraySize.push_back(s5);
 					}
 				}
 			}
@@ -2611,114 +2924,138 @@ void InterpreterObserver::push_array_size5(int s1, int s2, int s3, int s4, int s
 
 void InterpreterObserver::after_call(int retInx UNUSED, SCOPE retScope UNUSED, KIND retType, int64_t retValue) {
 
-	if (!isReturn) {
+	if (!state().isReturn) {
 		// int callerId = callerVarIndex.top();
 		// pre_sync_call(callerId, line);
 
 		// call is not interpreted
-		safe_assert(!callerVarIndex.empty());
+		safe_assert(!state().callerVarIndex.empty());
 
 		// empty myStack and callArgs
-		clear(myStack);
-		clear(callArgs);
+		clear(state().myStack);
+		clear(state().callArgs);
+		state().pendingArgs = NULL;
 
-		IValue* reg = executionStack.top()[callerVarIndex.top()];
+		IValue* reg = state().executionStack.top()[state().callerVarIndex.top()];
 
 		// setting return value
 		reg->setTypeValue(retType, retValue);
 		reg->setValueOffset(0);  // new
 		reg->resetShadow();
-		callerVarIndex.pop();
+		state().callerVarIndex.pop();
 
 		// post_sync_call(callerId, line);
 
 		DEBUG_STDOUT(reg->toString());
 	} else {
-		safe_assert(callArgs.empty());
-		safe_assert(myStack.empty());
+		safe_assert(state().callArgs.empty());
+		safe_assert(state().myStack.empty());
 	}
 
-	isReturn = false;
+	state().isReturn = false;
 
-	safe_assert(!recentBlock.empty());
-	recentBlock.pop();
+	safe_assert(!state().recentBlock.empty());
+	state().recentBlock.pop();
 	return;
 }
 
 void InterpreterObserver::after_void_call() {
 
-	isReturn = false;
+	state().isReturn = false;
 
-	safe_assert(!recentBlock.empty());
-	recentBlock.pop();
+	safe_assert(!state().recentBlock.empty());
+	state().recentBlock.pop();
 
 	// empty myStack and callArgs
-	clear(myStack);
-	clear(callArgs);
+	clear(state().myStack);
+	clear(state().callArgs);
+	state().pendingArgs = NULL;
 	return;
 }
 
 void InterpreterObserver::after_struct_call() {
 
-	if (!isReturn) {
+	if (!state().isReturn) {
 		// call is not interpreted
-		safe_assert(!callerVarIndex.empty());
+		safe_assert(!state().callerVarIndex.empty());
 
 		// empty myStack and callArgs
-		clear(myStack);
-		clear(callArgs);
+		clear(state().myStack);
+		clear(state().callArgs);
+		state().pendingArgs = NULL;
 
-		safe_assert(!returnStruct.empty());
+		safe_assert(!state().returnStruct.empty());
 
 		// reconstruct struct value
 		// IValue* structValue = (IValue*)
 		// malloc(returnStruct.size()*sizeof(IValue));
 		// //
-		IValue* structValue = new IValue[returnStruct.size()];
+		IValue* structValue = new IValue[state().returnStruct.size()];
 
-		for (unsigned i = 0; i < returnStruct.size(); i++) {
-			KVALUE* value = returnStruct[i];
+		for (unsigned i = 0; i < state().returnStruct.size(); i++) {
+			KVALUE* value = state().returnStruct[i];
 			IValue iValue = IValue(value->kind);
 			iValue.setValue(value->value);
 			iValue.setLength(0);
 			structValue[i] = iValue;
 		}
-		returnStruct.clear();
+		state().returnStruct.clear();
 
-		executionStack.top()[callerVarIndex.top()] = structValue;
+		state().executionStack.top().redirect(state().callerVarIndex.top(), structValue);
 
-		DEBUG_STDOUT(executionStack.top()[callerVarIndex.top()]->toString());
+		DEBUG_STDOUT(state().executionStack.top()[state().callerVarIndex.top()]->toString());
 
-		callerVarIndex.pop();
+		state().callerVarIndex.pop();
 	} else {
-		returnStruct.clear();
-		safe_assert(callArgs.empty());
-		safe_assert(myStack.empty());
+		state().returnStruct.clear();
+		safe_assert(state().callArgs.empty());
+		safe_assert(state().myStack.empty());
 	}
 
-	isReturn = false;
+	state().isReturn = false;
 
-	safe_assert(!recentBlock.empty());
-	recentBlock.pop();
+	safe_assert(!state().recentBlock.empty());
+	state().recentBlock.pop();
 	return;
 }
 
 void InterpreterObserver::create_stack_frame(int size) {
 
-	isReturn = false;
+	state().isReturn = false;
 
-	std::vector<IValue*> frame(size);
-	for (int i = 0; i < size; i++) {
-		if (!callArgs.empty()) {
-			frame[i] = new IValue(callArgs.top());
+	Frame& frame = state().executionStack.push(size);
+
+	// allocas recorded at this depth belong to a returned frame
+	size_t depth = state().executionStack.size();
+	if (state().allocaRegisters.size() >= depth) {
+		state().allocaRegisters[depth - 1].clear();
+	}
+
+	if (state().pendingArgs != NULL) {
+		// copy the arguments straight from the caller's frame
+		Frame& caller = state().executionStack.caller();
+		for (int i = 0; i < size && i < state().pendingArgCount; i++) {
+			const CALLARG& arg = state().pendingArgs[i];
+			if (arg.inx != -1) {
+				IValue* src = arg.scope == GLOBAL ? globalSymbolTable[arg.inx] : caller[arg.inx];
+				safe_assert(src);
+				src->copy(frame[i]);
+			} else {
+				// argument is a constant
+				*frame[i] = IValue(arg.kind, arg.value, LOCAL);
+				frame[i]->setLength(0);  // uninitialized pointer
+			}
 			DEBUG_STDOUT("\t Argument " << i << ": " << frame[i]->toString());
-			callArgs.pop();
-		} else {
-			frame[i] = new IValue();
 		}
+		state().pendingArgs = NULL;
+	}
+
+	for (int i = 0; i < size && !state().callArgs.empty(); i++) {
+		*frame[i] = state().callArgs.top();
+		DEBUG_STDOUT("\t Argument " << i << ": " << frame[i]->toString());
+		state().callArgs.pop();
 	}
-	safe_assert(callArgs.empty());
-	executionStack.push(frame);
+	safe_assert(state().callArgs.empty());
 	return;
 }
 
@@ -2738,6 +3075,7 @@ void InterpreterObserver::create_global_symbol_table(int size) {
 		IValue* value = new IValue();
 		globalSymbolTable.push_back(value);
 	}
+	mainThread = std::this_thread::get_id();
 
 	pre_analysis();
 
@@ -2752,20 +3090,130 @@ void InterpreterObserver::create_global_symbol_table(int size) {
 	return;
 }
 
+void InterpreterObserver::collect(uint64_t address, IValue* cells, unsigned count) {
+	std::lock_guard<std::mutex> lock(heapLock);
+
+	// the program lost track of the blocks the new block overlaps
+	uint64_t end = address + (count > 0 ? blockBytes(cells, count) : 1);
+	auto it = heapBlocks.upper_bound(address);
+	if (it != heapBlocks.begin()) {
+		auto prev = std::prev(it);
+		if (prev->first == address ||
+				(prev->second.count > 0 && prev->first + blockBytes(prev->second.cells, prev->second.count) > address)) {
+			it = prev;
+		}
+	}
+	while (it != heapBlocks.end() && it->first < end) {
+		HeapBlock& dead = it->second;
+		liveHeapBytes -= dead.count * sizeof(IValue);
+		shadowMemory.unmapBlock(it->first, dead.cells, dead.count);
+		retire(it->first, dead.cells);
+		it = heapBlocks.erase(it);
+	}
+
+	HeapBlock& block = heapBlocks[address];
+	block.cells = cells;
+	block.count = count;
+	shadowMemory.mapBlock(address, cells, count);
+	liveHeapBytes += count * sizeof(IValue);
+	peakHeapBytes = std::max(peakHeapBytes, liveHeapBytes);
+}
+
+uint64_t InterpreterObserver::blockBase(IValue* pointer, uint64_t addr) {
+	// pointers into a block keep the block's address
+	if (pointer->isInitialized()) {
+		return pointer->getValue().as_int;
+	}
+	uint64_t base;
+	HeapBlock block;
+	return resolveBlock(addr, base, block) ? base : addr;
+}
+
+InterpreterObserver::BlockAccess::BlockAccess(InterpreterObserver& observer, IValue* pointer, uint64_t addr)
+	: observer(observer) {
+	if (threaded) {
+		lock = std::unique_lock<std::mutex>(observer.blockLock(pointer ? observer.blockBase(pointer, addr) : addr));
+	}
+}
+
+InterpreterObserver::BlockAccess::~BlockAccess() {
+	if (threaded) {
+		lock.unlock();
+		observer.deleteRetired();
+	}
+}
+
+void InterpreterObserver::retire(uint64_t base, IValue* cells) {
+	if (!threaded) {
+		delete[] cells;
+	} else if (cells != NULL) {
+		state().retired.push_back(std::make_pair(base, cells));
+	}
+}
+
+void InterpreterObserver::deleteRetired() {
+	vector<pair<uint64_t, IValue*>>& retired = state().retired;
+	for (const pair<uint64_t, IValue*>& block : retired) {
+		// a load or store that found the block before it was unmapped holds
+		// its lock until it is done with the cells
+		std::lock_guard<std::mutex> lock(blockLock(block.first));
+		delete[] block.second;
+	}
+	retired.clear();
+}
+
+InterpreterObserver::HeapBlock InterpreterObserver::reclaim(uint64_t address) {
+	std::lock_guard<std::mutex> lock(heapLock);
+	HeapBlock block = {NULL, 0};
+	auto it = heapBlocks.find(address);
+	if (it != heapBlocks.end()) {
+		block = it->second;
+		heapBlocks.erase(it);
+		liveHeapBytes -= block.count * sizeof(IValue);
+		shadowMemory.unmapBlock(address, block.cells, block.count);
+	}
+	return block;
+}
+
 void InterpreterObserver::record_block_id(int id) {
 
-	if (recentBlock.empty()) {
-		recentBlock.push(id);
+	if (state().recentBlock.empty()) {
+		state().recentBlock.push(id);
 	} else {
-		recentBlock.pop();
-		recentBlock.push(id);
+		state().recentBlock.pop();
+		state().recentBlock.push(id);
 	}
 	return;
 }
 
+void InterpreterObserver::sync_register(int inx, KIND type, int64_t value) {
+	VALUE concrete;
+	concrete.as_int = value;
+
+	IValue* reg = state().executionStack.top()[inx];
+
+	// binding reads the cells of the block the pointer points into
+	std::unique_lock<std::mutex> lock;
+	uint64_t base;
+	HeapBlock block;
+	if (threaded && type == PTR_KIND && resolveBlock(value, base, block)) {
+		lock = std::unique_lock<std::mutex>(blockLock(base));
+	}
+
+	// a pointer into a heap block, alloca or global points to its element;
+	// any other pointer is initialized on first access
+	if (type != PTR_KIND || !bindPointer(reg, value)) {
+		*reg = IValue(type, concrete);
+		reg->setLength(0);
+	}
+
+	DEBUG_STDOUT(reg->toString());
+	return;
+}
+
 void InterpreterObserver::create_global_array(int valInx, uint64_t addr, uint32_t size, KIND type) {
+	// global arrays live as long as the program and are never reclaimed
 	IValue* location = new IValue[size];
-	collect_new.push_back(location);
 	uint32_t i, elemSize;
 	VALUE zero, value;
 
@@ -2784,6 +3232,8 @@ void InterpreterObserver::create_global_array(int valInx, uint64_t addr, uint32_
 	ptrLocation.setSize(KIND_GetSize(type));
 	ptrLocation.setLength(size);
 	ptrLocation.setValueOffset((int64_t)location - value.as_int);
+	shadowMemory.mapBlock(addr, location, size);
+	globalBlocks[addr] = {location, size};
 
 	*globalSymbolTable[valInx] = std::move(ptrLocation);
 	DEBUG_STDOUT("\tptr: " << globalSymbolTable[valInx]->toString());
@@ -2804,6 +3254,8 @@ void InterpreterObserver::create_global(KVALUE* kvalue, KVALUE* initializer) {
 		ptrLocation.setLength(1);
 	}
 	ptrLocation.setValueOffset((int64_t)location - value.as_int);
+	shadowMemory.mapBlock(value.as_int, location, 1);
+	globalBlocks[value.as_int] = {location, 1};
 
 	// store it in globalSymbolTable
 	*globalSymbolTable[kvalue->inx] = std::move(ptrLocation);
@@ -2814,15 +3266,15 @@ void InterpreterObserver::create_global(KVALUE* kvalue, KVALUE* initializer) {
 
 void InterpreterObserver::call(IID iid UNUSED, bool nounwind UNUSED, KIND type, int inx) {
 
-	while (!myStack.empty()) {
-		KVALUE value = myStack.top();
-		myStack.pop();
+	while (!state().myStack.empty()) {
+		KVALUE value = state().myStack.top();
+		state().myStack.pop();
 
 		DEBUG_STDOUT(", arg: " << KVALUE_ToString(&value).c_str());
 
 		IValue argCopy;
 		if (value.inx != -1) {
-			IValue* arg = value.isGlobal ? globalSymbolTable[value.inx] : executionStack.top()[value.inx];
+			IValue* arg = value.isGlobal ? globalSymbolTable[value.inx] : state().executionStack.top()[value.inx];
 			safe_assert(arg);
 			argCopy = IValue();
 			arg->copy(&argCopy);
@@ -2831,29 +3283,40 @@ void InterpreterObserver::call(IID iid UNUSED, bool nounwind UNUSED, KIND type,
 			argCopy = IValue(value.kind, value.value, LOCAL);
 			argCopy.setLength(0);  // uninitialized pointer
 		}
-		callArgs.push(argCopy);
+		state().callArgs.push(argCopy);
 	}
 
 	if (type != VOID_KIND) {
-		callerVarIndex.push(inx);
+		state().callerVarIndex.push(inx);
 	}
 
-	IValue* callValue = executionStack.top()[inx];
+	IValue* callValue = state().executionStack.top()[inx];
 	callValue->clear();
 	callValue->setType(type);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 
 	// new recentBLock stack frame for the new call
-	recentBlock.push(0);
+	state().recentBlock.push(0);
+	return;
+}
+
+void InterpreterObserver::call_args(IID iid, bool nounwind, KIND type, int inx, int count, const CALLARG* args) {
+	safe_assert(state().myStack.empty());
+
+	// the arguments are read when the callee creates its frame
+	state().pendingArgs = count > 0 ? args : NULL;
+	state().pendingArgCount = count;
+
+	call(iid, nounwind, type, inx);
 	return;
 }
 
 void InterpreterObserver::call_sin(IID iid UNUSED, bool nounwind UNUSED, IID argIID UNUSED, KIND type, int inx) {
 
-	safe_assert(myStack.size() == 1);
-	KVALUE arg = myStack.top();
-	myStack.pop();
+	safe_assert(state().myStack.size() == 1);
+	KVALUE arg = state().myStack.top();
+	state().myStack.pop();
 	double argValue;
 	VALUE value;
 	// SCOPE argScope;
@@ -2867,7 +3330,7 @@ void InterpreterObserver::call_sin(IID iid UNUSED, bool nounwind UNUSED, IID arg
 			iArg = globalSymbolTable[arg.inx];
 			// argScope = GLOBAL;
 		} else {
-			iArg = executionStack.top()[arg.inx];
+			iArg = state().executionStack.top()[arg.inx];
 			// argScope = LOCAL;
 		}
 
@@ -2894,9 +3357,9 @@ void InterpreterObserver::call_sin(IID iid UNUSED, bool nounwind UNUSED, IID arg
 	value.as_flp = sin(argValue);
 	IValue returnValue = IValue(type, value);
 
-	*executionStack.top()[inx] = std::move(returnValue);
+	*state().executionStack.top()[inx] = std::move(returnValue);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 
 	SCOPE argScope = arg.inx == -1 ? CONSTANT : (arg.isGlobal ? GLOBAL : LOCAL);
 	int64_t argVal = arg.inx == -1 ? arg.value.as_int : arg.inx;
@@ -2906,9 +3369,9 @@ void InterpreterObserver::call_sin(IID iid UNUSED, bool nounwind UNUSED, IID arg
 
 void InterpreterObserver::call_acos(IID iid UNUSED, bool nounwind UNUSED, IID argIID UNUSED, KIND type, int inx) {
 
-	safe_assert(myStack.size() == 1);
-	KVALUE arg = myStack.top();
-	myStack.pop();
+	safe_assert(state().myStack.size() == 1);
+	KVALUE arg = state().myStack.top();
+	state().myStack.pop();
 	double argValue;
 	VALUE value;
 	// SCOPE argScope;
@@ -2922,7 +3385,7 @@ void InterpreterObserver::call_acos(IID iid UNUSED, bool nounwind UNUSED, IID ar
 			iArg = globalSymbolTable[arg.inx];
 			// argScope = GLOBAL;
 		} else {
-			iArg = executionStack.top()[arg.inx];
+			iArg = state().executionStack.top()[arg.inx];
 			// argScope = LOCAL;
 		}
 
@@ -2949,9 +3412,9 @@ void InterpreterObserver::call_acos(IID iid UNUSED, bool nounwind UNUSED, IID ar
 	value.as_flp = acos(argValue);
 	IValue returnValue = IValue(type, value);
 
-	*executionStack.top()[inx] = std::move(returnValue);
+	*state().executionStack.top()[inx] = std::move(returnValue);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 
 	SCOPE argScope = arg.inx == -1 ? CONSTANT : (arg.isGlobal ? GLOBAL : LOCAL);
 	int64_t argVal = arg.inx == -1 ? arg.value.as_int : arg.inx;
@@ -2961,9 +3424,9 @@ void InterpreterObserver::call_acos(IID iid UNUSED, bool nounwind UNUSED, IID ar
 
 void InterpreterObserver::call_sqrt(IID iid UNUSED, bool nounwind UNUSED, IID argIID UNUSED, KIND type, int inx) {
 
-	safe_assert(myStack.size() == 1);
-	KVALUE arg = myStack.top();
-	myStack.pop();
+	safe_assert(state().myStack.size() == 1);
+	KVALUE arg = state().myStack.top();
+	state().myStack.pop();
 	double argValue;
 	VALUE value;
 	// SCOPE argScope;
@@ -2977,7 +3440,7 @@ void InterpreterObserver::call_sqrt(IID iid UNUSED, bool nounwind UNUSED, IID ar
 			iArg = globalSymbolTable[arg.inx];
 			// argScope = GLOBAL;
 		} else {
-			iArg = executionStack.top()[arg.inx];
+			iArg = state().executionStack.top()[arg.inx];
 			// argScope = LOCAL;
 		}
 
@@ -3004,9 +3467,9 @@ void InterpreterObserver::call_sqrt(IID iid UNUSED, bool nounwind UNUSED, IID ar
 	value.as_flp = sqrt(argValue);
 	IValue returnValue = IValue(type, value);
 
-	*executionStack.top()[inx] = std::move(returnValue);
+	*state().executionStack.top()[inx] = std::move(returnValue);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 
 	SCOPE argScope = arg.inx == -1 ? CONSTANT : (arg.isGlobal ? GLOBAL : LOCAL);
 	int64_t argVal = arg.inx == -1 ? arg.value.as_int : arg.inx;
@@ -3016,9 +3479,9 @@ void InterpreterObserver::call_sqrt(IID iid UNUSED, bool nounwind UNUSED, IID ar
 
 void InterpreterObserver::call_fabs(IID iid UNUSED, bool nounwind UNUSED, IID argIID UNUSED, KIND type, int inx) {
 
-	safe_assert(myStack.size() == 1);
-	KVALUE arg = myStack.top();
-	myStack.pop();
+	safe_assert(state().myStack.size() == 1);
+	KVALUE arg = state().myStack.top();
+	state().myStack.pop();
 	double argValue;
 	VALUE value;
 	// SCOPE argScope;
@@ -3032,7 +3495,7 @@ void InterpreterObserver::call_fabs(IID iid UNUSED, bool nounwind UNUSED, IID ar
 			iArg = globalSymbolTable[arg.inx];
 			// argScope = GLOBAL;
 		} else {
-			iArg = executionStack.top()[arg.inx];
+			iArg = state().executionStack.top()[arg.inx];
 			// argScope = LOCAL;
 		}
 
@@ -3059,9 +3522,9 @@ void InterpreterObserver::call_fabs(IID iid UNUSED, bool nounwind UNUSED, IID ar
 	value.as_flp = fabs(argValue);
 	IValue returnValue = IValue(type, value);
 
-	*executionStack.top()[inx] = std::move(returnValue);
+	*state().executionStack.top()[inx] = std::move(returnValue);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 
 	SCOPE argScope = arg.inx == -1 ? CONSTANT : (arg.isGlobal ? GLOBAL : LOCAL);
 	int64_t argVal = arg.inx == -1 ? arg.value.as_int : arg.inx;
@@ -3071,9 +3534,9 @@ void InterpreterObserver::call_fabs(IID iid UNUSED, bool nounwind UNUSED, IID ar
 
 void InterpreterObserver::call_cos(IID iid UNUSED, bool nounwind UNUSED, IID argIID UNUSED, KIND type, int inx) {
 
-	safe_assert(myStack.size() == 1);
-	KVALUE arg = myStack.top();
-	myStack.pop();
+	safe_assert(state().myStack.size() == 1);
+	KVALUE arg = state().myStack.top();
+	state().myStack.pop();
 	double argValue;
 	VALUE value;
 	// SCOPE argScope;
@@ -3087,7 +3550,7 @@ void InterpreterObserver::call_cos(IID iid UNUSED, bool nounwind UNUSED, IID arg
 			iArg = globalSymbolTable[arg.inx];
 			// argScope = GLOBAL;
 		} else {
-			iArg = executionStack.top()[arg.inx];
+			iArg = state().executionStack.top()[arg.inx];
 			// argScope = LOCAL;
 		}
 
@@ -3114,9 +3577,9 @@ void InterpreterObserver::call_cos(IID iid UNUSED, bool nounwind UNUSED, IID arg
 	value.as_flp = cos(argValue);
 	IValue returnValue = IValue(type, value);
 
-	*executionStack.top()[inx] = std::move(returnValue);
+	*state().executionStack.top()[inx] = std::move(returnValue);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 
 	SCOPE argScope = arg.inx == -1 ? CONSTANT : (arg.isGlobal ? GLOBAL : LOCAL);
 	int64_t argVal = arg.inx == -1 ? arg.value.as_int : arg.inx;
@@ -3126,9 +3589,9 @@ void InterpreterObserver::call_cos(IID iid UNUSED, bool nounwind UNUSED, IID arg
 
 void InterpreterObserver::call_log(IID iid UNUSED, bool nounwind UNUSED, IID argIID UNUSED, KIND type, int inx) {
 
-	safe_assert(myStack.size() == 1);
-	KVALUE arg = myStack.top();
-	myStack.pop();
+	safe_assert(state().myStack.size() == 1);
+	KVALUE arg = state().myStack.top();
+	state().myStack.pop();
 	double argValue;
 	VALUE value;
 	// SCOPE argScope;
@@ -3142,7 +3605,7 @@ void InterpreterObserver::call_log(IID iid UNUSED, bool nounwind UNUSED, IID arg
 			iArg = globalSymbolTable[arg.inx];
 			// argScope = GLOBAL;
 		} else {
-			iArg = executionStack.top()[arg.inx];
+			iArg = state().executionStack.top()[arg.inx];
 			// argScope = LOCAL;
 		}
 
@@ -3169,9 +3632,9 @@ void InterpreterObserver::call_log(IID iid UNUSED, bool nounwind UNUSED, IID arg
 	value.as_flp = log(argValue);
 	IValue returnValue = IValue(type, value);
 
-	*executionStack.top()[inx] = std::move(returnValue);
+	*state().executionStack.top()[inx] = std::move(returnValue);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 
 	SCOPE argScope = arg.inx == -1 ? CONSTANT : (arg.isGlobal ? GLOBAL : LOCAL);
 	int64_t argVal = arg.inx == -1 ? arg.value.as_int : arg.inx;
@@ -3181,9 +3644,9 @@ void InterpreterObserver::call_log(IID iid UNUSED, bool nounwind UNUSED, IID arg
 
 void InterpreterObserver::call_exp(IID iid UNUSED, bool nounwind UNUSED, IID argIID UNUSED, KIND type, int inx) {
 
-	safe_assert(myStack.size() == 1);
-	KVALUE arg = myStack.top();
-	myStack.pop();
+	safe_assert(state().myStack.size() == 1);
+	KVALUE arg = state().myStack.top();
+	state().myStack.pop();
 	double argValue;
 	VALUE value;
 	// SCOPE argScope;
@@ -3197,7 +3660,7 @@ void InterpreterObserver::call_exp(IID iid UNUSED, bool nounwind UNUSED, IID arg
 			iArg = globalSymbolTable[arg.inx];
 			// argScope = GLOBAL;
 		} else {
-			iArg = executionStack.top()[arg.inx];
+			iArg = state().executionStack.top()[arg.inx];
 			// argScope = LOCAL;
 		}
 
@@ -3224,9 +3687,9 @@ void InterpreterObserver::call_exp(IID iid UNUSED, bool nounwind UNUSED, IID arg
 	value.as_flp = exp(argValue);
 	IValue returnValue = IValue(type, value);
 
-	*executionStack.top()[inx] = std::move(returnValue);
+	*state().executionStack.top()[inx] = std::move(returnValue);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 
 	SCOPE argScope = arg.inx == -1 ? CONSTANT : (arg.isGlobal ? GLOBAL : LOCAL);
 	int64_t argVal = arg.inx == -1 ? arg.value.as_int : arg.inx;
@@ -3236,9 +3699,9 @@ void InterpreterObserver::call_exp(IID iid UNUSED, bool nounwind UNUSED, IID arg
 
 void InterpreterObserver::call_floor(IID iid UNUSED, bool nounwind UNUSED, IID argIID UNUSED, KIND type, int inx) {
 
-	safe_assert(myStack.size() == 1);
-	KVALUE arg = myStack.top();
-	myStack.pop();
+	safe_assert(state().myStack.size() == 1);
+	KVALUE arg = state().myStack.top();
+	state().myStack.pop();
 	double argValue;
 	VALUE value;
 	// SCOPE argScope;
@@ -3252,7 +3715,7 @@ void InterpreterObserver::call_floor(IID iid UNUSED, bool nounwind UNUSED, IID a
 			iArg = globalSymbolTable[arg.inx];
 			// argScope = GLOBAL;
 		} else {
-			iArg = executionStack.top()[arg.inx];
+			iArg = state().executionStack.top()[arg.inx];
 			// argScope = LOCAL;
 		}
 
@@ -3279,9 +3742,9 @@ void InterpreterObserver::call_floor(IID iid UNUSED, bool nounwind UNUSED, IID a
 	value.as_flp = floor(argValue);
 	IValue returnValue = IValue(type, value);
 
-	*executionStack.top()[inx] = std::move(returnValue);
+	*state().executionStack.top()[inx] = std::move(returnValue);
 
-	DEBUG_STDOUT(executionStack.top()[inx]->toString());
+	DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 
 	SCOPE argScope = arg.inx == -1 ? CONSTANT : (arg.isGlobal ? GLOBAL : LOCAL);
 	int64_t argVal = arg.inx == -1 ? arg.value.as_int : arg.inx;
@@ -3289,29 +3752,26 @@ void InterpreterObserver::call_floor(IID iid UNUSED, bool nounwind UNUSED, IID a
 	return;
 }
 
-void InterpreterObserver::call_malloc(IID iid UNUSED, bool nounwind UNUSED, KIND type, int size, int inx,
-									  uint64_t mallocAddress) {
-
-	// retrieving original number of bytes
-	KVALUE argValue = myStack.top();
-	myStack.pop();
-	assert(myStack.size() == 0);
+InterpreterObserver::HeapBlock InterpreterObserver::allocate(KIND type, int size, int inx, uint64_t address,
+		uint64_t bytes) {
+	HeapBlock block;
 
 	if (type != STRUCT_KIND) {
 		// allocating space
-		int numObjects = argValue.value.as_int * 8 / size;
+		int numObjects = bytes * 8 / size;
 		IValue* addr = new IValue[numObjects];
-		collect_new.push_back(addr);
+		block.cells = addr;
+		block.count = numObjects;
 
 		// creating pointer object
 		VALUE returnValue;
-		returnValue.as_ptr = (void*)mallocAddress;
+		returnValue.as_ptr = (void*)address;
 		{
 			IValue newPointer = IValue(PTR_KIND, returnValue, size / 8, 0, 0, numObjects);
 			newPointer.setValueOffset((int64_t)addr - (int64_t)returnValue.as_ptr);
-			*executionStack.top()[inx] = std::move(newPointer);
+			*state().executionStack.top()[inx] = std::move(newPointer);
 		}
-		IValue& newPointer = *executionStack.top()[inx];
+		IValue& newPointer = *state().executionStack.top()[inx];
 
 		// creating locations
 		unsigned currOffset = 0;
@@ -3328,17 +3788,19 @@ void InterpreterObserver::call_malloc(IID iid UNUSED, bool nounwind UNUSED, KIND
 			currOffset += (size / 8);
 		}
 
-		DEBUG_STDOUT(executionStack.top()[inx]->toString());
+		DEBUG_STDOUT(state().executionStack.top()[inx]->toString());
 	} else {
 
 		// allocating space
-		unsigned numStructs = ceil(argValue.value.as_int * 8.0 / size);
-		unsigned fields = structType.size();
+		const TypeLayout& layout = takeLayout();
+		unsigned numStructs = ceil(bytes * 8.0 / size);
+		unsigned fields = layout.length;
 
 		IValue* ptrToStructVar = new IValue[numStructs * fields];
-		collect_new.push_back(ptrToStructVar);
+		block.cells = ptrToStructVar;
+		block.count = numStructs * fields;
 
-		DEBUG_STDOUT("\nTotal size of malloc in bits: " << argValue.value.as_int * 8);
+		DEBUG_STDOUT("\nTotal size of malloc in bits: " << bytes * 8);
 		DEBUG_STDOUT("Size: " << size);
 		DEBUG_STDOUT("Num Structs: " << numStructs);
 		DEBUG_STDOUT("Number of fields: " << fields);
@@ -3347,7 +3809,7 @@ void InterpreterObserver::call_malloc(IID iid UNUSED, bool nounwind UNUSED, KIND
 		unsigned firstByte = 0;
 		for (unsigned i = 0; i < numStructs; i++) {
 			for (unsigned j = 0; j < fields; j++) {
-				KIND type = structType[j];
+				KIND type = layout.kinds[j];
 
 				ptrToStructVar[length].setType(type);
 				ptrToStructVar[length].setFirstByte(firstByte);
@@ -3357,18 +3819,110 @@ void InterpreterObserver::call_malloc(IID iid UNUSED, bool nounwind UNUSED, KIND
 				length++;
 			}
 		}
-		structType.clear();
 
 		VALUE structPtrVal;
-		structPtrVal.as_ptr = (void*)mallocAddress;
+		structPtrVal.as_ptr = (void*)address;
 		IValue structPtrVar = IValue(PTR_KIND, structPtrVal);
-		structPtrVar.setValueOffset((int64_t)ptrToStructVar - (int64_t)mallocAddress);  ////////////
+		structPtrVar.setValueOffset((int64_t)ptrToStructVar - (int64_t)address);  ////////////
 		structPtrVar.setSize(KIND_GetSize(ptrToStructVar[0].getType()));
 		structPtrVar.setLength(length);
 
-		*executionStack.top()[inx] = std::move(structPtrVar);
+		*state().executionStack.top()[inx] = std::move(structPtrVar);
 		DEBUG_STDOUT(structPtrVar.toString());
 	}
+	return block;
+}
+
+void InterpreterObserver::call_malloc(IID iid UNUSED, bool nounwind UNUSED, KIND type, int size, int inx,
+									  uint64_t mallocAddress) {
+
+	// retrieving original number of bytes
+	KVALUE argValue = state().myStack.top();
+	state().myStack.pop();
+	assert(state().myStack.size() == 0);
+
+	HeapBlock block = allocate(type, size, inx, mallocAddress, argValue.value.as_int);
+	collect(mallocAddress, block.cells, block.count);
+	deleteRetired();
+	return;
+}
+
+void InterpreterObserver::call_calloc(IID iid UNUSED, bool nounwind UNUSED, KIND type, int size, int inx,
+									  uint64_t callocAddress) {
+
+	// retrieving number of elements and element size; shadow cells are
+	// created zero-valued, matching the zeroed memory
+	KVALUE elemSize = state().myStack.top();
+	state().myStack.pop();
+	KVALUE numElems = state().myStack.top();
+	state().myStack.pop();
+	assert(state().myStack.size() == 0);
+
+	HeapBlock block = allocate(type, size, inx, callocAddress, numElems.value.as_int * elemSize.value.as_int);
+	collect(callocAddress, block.cells, block.count);
+	deleteRetired();
+	return;
+}
+
+void InterpreterObserver::call_realloc(IID iid UNUSED, bool nounwind UNUSED, KIND type, int size, int inx,
+									   uint64_t reallocAddress) {
+
+	// retrieving new number of bytes and the old block
+	KVALUE argValue = state().myStack.top();
+	state().myStack.pop();
+	KVALUE oldAddress = state().myStack.top();
+	state().myStack.pop();
+	assert(state().myStack.size() == 0);
+
+	// a failed realloc leaves the old block alive; realloc(ptr, 0) only frees
+	VALUE nullValue;
+	nullValue.as_ptr = NULL;
+	if (reallocAddress == 0 && argValue.value.as_int != 0) {
+		*state().executionStack.top()[inx] = IValue(PTR_KIND, nullValue);
+		return;
+	}
+	HeapBlock old = reclaim(oldAddress.value.as_int);
+	if (argValue.value.as_int == 0) {
+		retire(oldAddress.value.as_int, old.cells);
+		deleteRetired();
+		*state().executionStack.top()[inx] = IValue(PTR_KIND, nullValue);
+		return;
+	}
+
+	HeapBlock block = allocate(type, size, inx, reallocAddress, argValue.value.as_int);
+
+	// the contents up to the smaller size are preserved: a cell keeps its
+	// shadow where the old block has a cell of the same kind at the same byte
+	// offset; the others stay fresh and are resynchronized on their next load
+	for (unsigned i = 0, j = 0; i < block.count && j < old.count; i++) {
+		IValue& cell = block.cells[i];
+		while (j < old.count && old.cells[j].getFirstByte() < cell.getFirstByte()) {
+			j++;
+		}
+		if (j < old.count && old.cells[j].getFirstByte() == cell.getFirstByte()) {
+			if (old.cells[j].getType() == cell.getType()) {
+				old.cells[j].copy(&cell);
+			}
+			j++;
+		}
+	}
+	retire(oldAddress.value.as_int, old.cells);
+
+	collect(reallocAddress, block.cells, block.count);
+	deleteRetired();
+	return;
+}
+
+void InterpreterObserver::call_free(IID iid UNUSED, bool nounwind UNUSED) {
+	KVALUE argValue = state().myStack.top();
+	state().myStack.pop();
+	assert(state().myStack.size() == 0);
+
+	// freeing a block that was not allocated through a shadowed call, or NULL,
+	// leaves nothing to reclaim
+	HeapBlock block = reclaim(argValue.value.as_int);
+	retire(argValue.value.as_int, block.cells);
+	deleteRetired();
 	return;
 }
 
@@ -3391,131 +3945,108 @@ void InterpreterObserver::printCurrentFrame() {
      * @param iValue the interpreted iValue of the concrete value
      * @param concrete pointer to the concrete value
      */
-bool InterpreterObserver::syncLoad(IValue* iValue, KVALUE* concrete, KIND type) {
-	bool sync = false;
-	VALUE syncValue;
-	int64_t cValueVoid;
-	int8_t* cValueInt8Arr;
-	int16_t cValueInt16;
-	int16_t* cValueInt16Arr;
-	int32_t cValueInt32;
-	int32_t* cValueInt32Arr;
-	int64_t cValueInt64;
-	float cValueFloat;
-	double cValueDouble;
-	double cValueLD;
-
-	switch (type) {
-		case PTR_KIND:
-			// TODO: we use int64_t to represent a void* here
-			// might not work on 32 bit machine
-			cValueVoid = *((int64_t*)concrete->value.as_ptr);
+namespace {
 
-			sync = (iValue->getValue().as_int + iValue->getOffset() != cValueVoid);
-			if (sync) {
-				syncValue.as_int = cValueVoid;
-				iValue->setValue(syncValue);
-			}
-			break;
-		case INT1_KIND:
-		case INT8_KIND:
-			cValueInt32 = *((int32_t*)concrete->value.as_ptr);
-			cValueInt32 = cValueInt32 & 0x000000FF;
+// Resynchronize an integer shadow value with a concrete value of type T.
+template <typename T>
+inline bool syncInt(IValue* iValue, T concrete) {
+	if ((T)iValue->getIntValue() == concrete) {
+		return false;
+	}
+	VALUE value;
+	value.as_int = concrete;
+	iValue->setValue(value);
+	return true;
+}
 
-			sync = (((int8_t)iValue->getIntValue()) != cValueInt32);
-			if (sync) {
-				cValueInt8Arr = (int8_t*)calloc(8, sizeof(int8_t));
-				cValueInt8Arr[0] = cValueInt32;
-				syncValue.as_int = *((int64_t*)cValueInt8Arr);
-				iValue->setValue(syncValue);
-			}
-			break;
-		case INT16_KIND:
-			cValueInt16 = *((int16_t*)concrete->value.as_ptr);
-			sync = (((int16_t)iValue->getIntValue()) != cValueInt16);
-			if (sync) {
-				cValueInt16Arr = (int16_t*)calloc(4, sizeof(int16_t));
-				cValueInt16Arr[0] = cValueInt16;
-				syncValue.as_int = *((int64_t*)cValueInt16Arr);
-				iValue->setValue(syncValue);
-			}
-			break;
-		case INT24_KIND:
-			cValueInt32 = *((int32_t*)concrete->value.as_ptr);
-			cValueInt32 = cValueInt32 & 0x00FFFFFF;
-			sync = (((int32_t)iValue->getIntValue()) != cValueInt32);
-			if (sync) {
-				cValueInt32Arr = (int32_t*)calloc(2, sizeof(int32_t));
-				cValueInt32Arr[0] = cValueInt32;
-				syncValue.as_int = *((int32_t*)cValueInt32Arr);
-				iValue->setValue(syncValue);
-			}
-			break;
-		case INT32_KIND:
-			cValueInt32 = *((int32_t*)concrete->value.as_ptr);
-			sync = (((int32_t)iValue->getIntValue()) != cValueInt32);
-			if (sync) {
-				cValueInt32Arr = (int32_t*)calloc(2, sizeof(int32_t));
-				cValueInt32Arr[0] = cValueInt32;
-				syncValue.as_int = *((int32_t*)cValueInt32Arr);
-				iValue->setValue(syncValue);
-			}
-			break;
-		case INT64_KIND:
-			cValueInt64 = *((int64_t*)concrete->value.as_ptr);
-			sync = (iValue->getValue().as_int != cValueInt64);
-			if (sync) {
-				syncValue.as_int = cValueInt64;
-				iValue->setValue(syncValue);
-			}
-			break;
-		case INT80_KIND:
-			cout << "[syncload] Unsupported INT80_KIND" << endl;
-			safe_assert(false);
-			break;
-		case FLP32_KIND:
-			cValueFloat = *((float*)concrete->value.as_ptr);
-			if (std::isnan((float)iValue->getValue().as_flp) && std::isnan(cValueFloat)) {
-				sync = false;
-			} else {
-				sync = ((float)iValue->getValue().as_flp != cValueFloat);
-			}
-			if (sync) {
-				syncValue.as_flp = cValueFloat;
-				iValue->setValue(syncValue);
-			}
-			break;
-		case FLP64_KIND:
-			cValueDouble = *((double*)concrete->value.as_ptr);
-			if (std::isnan((double)iValue->getValue().as_flp) && std::isnan(cValueDouble)) {
-				sync = false;
-			} else {
-				sync = ((double)iValue->getValue().as_flp != cValueDouble);
-			}
-			if (sync) {
-				syncValue.as_flp = cValueDouble;
-				iValue->setValue(syncValue);
-			}
-			break;
-		case FLP80X86_KIND:
-			cValueLD = *((long double*)concrete->value.as_ptr);
-			if (std::isnan((double)iValue->getValue().as_flp) && std::isnan(cValueLD)) {
-				sync = false;
-			} else {
-				sync = ((double)iValue->getValue().as_flp != cValueLD);
-			}
-			if (sync) {
-				syncValue.as_flp = cValueLD;
-				iValue->setValue(syncValue);
-			}
-			break;
-		default:
-			cout << "Should not reach here!: " << type << endl;
-			safe_assert(false);
-			break;
+// Resynchronize a floating point shadow value, compared as T, with a concrete
+// value of type C. Two NaNs are considered equal.
+template <typename T, typename C = T>
+inline bool syncFlp(IValue* iValue, C concrete) {
+	T shadow = (T)iValue->getValue().as_flp;
+	if (shadow == concrete || (std::isnan(shadow) && std::isnan(concrete))) {
+		return false;
+	}
+	VALUE value;
+	value.as_flp = concrete;
+	iValue->setValue(value);
+	return true;
+}
+
+// Resynchronize a pointer shadow value with a concrete address.
+inline bool syncPtr(IValue* iValue, int64_t concrete) {
+	if (iValue->getValue().as_int + iValue->getOffset() == concrete) {
+		return false;
 	}
+	VALUE value;
+	value.as_int = concrete;
+	iValue->setValue(value);
+	return true;
+}
+
+// The resynchronization of a loaded value of one kind, with the concrete
+// value read as that kind.
+typedef bool (*SyncFunction)(IValue* iValue, const void* concrete);
+
+template <typename T>
+bool syncIntKind(IValue* iValue, const void* concrete) {
+	return syncInt<T>(iValue, *(const T*)concrete);
+}
+
+bool syncInt24Kind(IValue* iValue, const void* concrete) {
+	return syncInt<int32_t>(iValue, *(const int32_t*)concrete & 0x00FFFFFF);
+}
+
+template <typename T, typename C = T>
+bool syncFlpKind(IValue* iValue, const void* concrete) {
+	return syncFlp<T, C>(iValue, *(const C*)concrete);
+}
+
+// TODO: we use int64_t to represent a void* here
+// might not work on 32 bit machine
+bool syncPtrKind(IValue* iValue, const void* concrete) {
+	return syncPtr(iValue, *(const int64_t*)concrete);
+}
+
+bool syncUnsupported(IValue* iValue, const void* concrete UNUSED) {
+	cout << "[syncload] Unsupported kind: " << KIND_ToString(iValue->getType()) << endl;
+	safe_assert(false);
+	return false;
+}
+
+// Resynchronization of each kind, indexed by KIND, so that a load calls its
+// kind's specialization without switching on the kind.
+const SyncFunction syncFunctions[] = {
+	syncUnsupported,  // INV_KIND
+	syncPtrKind,  // PTR_KIND
+	syncIntKind<int8_t>,  // INT1_KIND
+	syncIntKind<int8_t>,  // INT8_KIND
+	syncIntKind<int16_t>,  // INT16_KIND
+	syncInt24Kind,  // INT24_KIND
+	syncIntKind<int32_t>,  // INT32_KIND
+	syncIntKind<int64_t>,  // INT64_KIND
+	syncUnsupported,  // INT80_KIND
+	syncFlpKind<float>,  // FLP32_KIND
+	syncFlpKind<double>,  // FLP64_KIND
+	syncUnsupported,  // FLP128_KIND
+	syncFlpKind<double, long double>,  // FLP80X86_KIND
+	syncUnsupported,  // FLP128PPC_KIND
+	syncUnsupported,  // ARRAY_KIND
+	syncUnsupported,  // STRUCT_KIND
+	syncUnsupported,  // VOID_KIND
+};
+
+static_assert(sizeof(syncFunctions) / sizeof(syncFunctions[0]) == VOID_KIND + 1, "A kind has no resynchronization.");
+
+}  // namespace
+
+bool InterpreterObserver::syncLoad(IID iid, IValue* iValue, const void* concrete, KIND type) {
+	VALUE shadow = iValue->getValue();
+	bool sync = (type <= VOID_KIND ? syncFunctions[type] : syncUnsupported)(iValue, concrete);
 
 	if (sync) {
+		recordSync(iid, type, shadow, iValue->getValue());
+
 		DEBUG_STDOUT("\t SYNCING AT LOAD DUE TO MISMATCH");
 		DEBUG_STDOUT("\t " << iValue->toString());
 	}
@@ -3523,128 +4054,59 @@ bool InterpreterObserver::syncLoad(IValue* iValue, KVALUE* concrete, KIND type)
 	return sync;
 }
 
-bool InterpreterObserver::syncLoad(IValue* iValue, uint64_t concreteAddr, KIND type) {
-	bool sync = false;
-	VALUE syncValue;
-	int cValueInt32;
-	int64_t cValueInt64;
-	float cValueFloat;
-	double cValueDouble;
-	double cValueLD;
+void InterpreterObserver::recordSync(IID iid, KIND kind, VALUE shadow, VALUE concrete) {
+	std::unique_lock<std::mutex> lock(syncLock, std::defer_lock);
+	if (threaded) {
+		lock.lock();
+	}
 
-	void* concreteValue;
+	SyncStats& stats = syncStats[iid];
+	if (stats.count++ == 0) {
+		stats.kind = kind;
+		stats.shadow = shadow;
+		stats.concrete = concrete;
+	}
+}
 
-	concreteValue = (void*)concreteAddr;
+void InterpreterObserver::printSyncReport() {
+	std::lock_guard<std::mutex> lock(syncLock);
 
-	switch (type) {
-		case PTR_KIND:
-			// TODO: we use int64_t to represent a void* here
-			// might not work on 32 bit machine
-			cValueInt64 = *((int64_t*)concreteValue);
+	if (syncStats.empty()) {
+		return;
+	}
 
-			sync = (iValue->getValue().as_int + iValue->getOffset() != cValueInt64);
-			if (sync) {
-				syncValue.as_int = cValueInt64;
-				iValue->setValue(syncValue);
-			}
-			break;
-		case INT1_KIND:
-		case INT8_KIND:
-			cValueInt32 = *((int8_t*)concreteValue);
+	vector<pair<IID, SyncStats> > loads(syncStats.begin(), syncStats.end());
+	std::sort(loads.begin(), loads.end(), [](const pair<IID, SyncStats>& a, const pair<IID, SyncStats>& b) {
+		return a.second.count > b.second.count;
+	});
 
-			sync = (((int8_t)iValue->getIntValue()) != cValueInt32);
-			if (sync) {
-				syncValue.as_int = cValueInt32;
-				iValue->setValue(syncValue);
-			}
-			break;
-		case INT16_KIND: {
-			cValueInt32 = *((int16_t*)concreteValue);
-			sync = (((int16_t)iValue->getIntValue()) != cValueInt32);
-			if (sync) {
-				syncValue.as_int = cValueInt32;
-				iValue->setValue(syncValue);
-			}
-			break;
-		}
-		case INT24_KIND:
-			cValueInt32 = *((int32_t*)concreteValue);
-			cValueInt32 = cValueInt32 & 0x00FFFFFF;
-			sync = (((int32_t)iValue->getIntValue()) != cValueInt32);
-			if (sync) {
-				syncValue.as_int = cValueInt32;
-				iValue->setValue(syncValue);
-			}
-			break;
-		case INT32_KIND:
-			cValueInt32 = *((int32_t*)concreteValue);
-			sync = (((int32_t)iValue->getIntValue()) != cValueInt32);
-			if (sync) {
-				syncValue.as_int = cValueInt32;
-				iValue->setValue(syncValue);
-			}
-			break;
-		case INT64_KIND:
-			cValueInt64 = *((int64_t*)concreteValue);
-			sync = (iValue->getValue().as_int != cValueInt64);
-			if (sync) {
-				syncValue.as_int = cValueInt64;
-				iValue->setValue(syncValue);
-			}
-			break;
-		case INT80_KIND:
-			cout << "[syncload] Unsupported INT80_KIND" << endl;
-			safe_assert(false);
-			break;
-		case FLP32_KIND:
-			cValueFloat = *((float*)concreteValue);
-			if (std::isnan((float)iValue->getValue().as_flp) && std::isnan(cValueFloat)) {
-				sync = false;
-			} else {
-				sync = ((float)iValue->getValue().as_flp != cValueFloat);
-			}
-			if (sync) {
-				syncValue.as_flp = cValueFloat;
-				iValue->setValue(syncValue);
-			}
-			break;
-		case FLP64_KIND:
-			cValueDouble = *((double*)concreteValue);
-			if (std::isnan((double)iValue->getValue().as_flp) && std::isnan(cValueDouble)) {
-				sync = false;
-			} else {
-				sync = ((double)iValue->getValue().as_flp != cValueDouble);
-			}
-			if (sync) {
-				syncValue.as_flp = cValueDouble;
-				iValue->setValue(syncValue);
-			}
-			break;
-		case FLP80X86_KIND: {
-			cValueLD = *((long double*)concreteValue);
-			if (std::isnan((double)iValue->getValue().as_flp) && std::isnan(cValueLD)) {
-				sync = false;
-			} else {
-				sync = ((double)iValue->getValue().as_flp != cValueLD);
-			}
-			if (sync) {
-				syncValue.as_flp = cValueLD;
-				iValue->setValue(syncValue);
-			}
-			break;
-		}
-		default:
-			cout << "Should not reach here!" << endl;
-			safe_assert(false);
-			break;
+	uint64_t total = 0;
+	for (unsigned i = 0; i < loads.size(); i++) {
+		total += loads[i].second.count;
 	}
+	cerr << "[sync] " << total << " resynchronized loads at " << loads.size() << " sites\n";
 
-	if (sync) {
-		DEBUG_STDOUT("\t SYNCING AT LOAD DUE TO MISMATCH");
-		DEBUG_STDOUT("\t " << iValue->toString());
+	for (unsigned i = 0; i < loads.size() && i < 20; i++) {
+		const SyncStats& stats = loads[i].second;
+		bool isFlp = stats.kind == FLP32_KIND || stats.kind == FLP64_KIND || stats.kind == FLP80X86_KIND;
+
+		cerr << "[sync]   iid " << loads[i].first << " (" << KIND_ToString(stats.kind) << "): " << stats.count
+			 << " times, first shadow ";
+		if (isFlp) {
+			cerr << stats.shadow.as_flp << " concrete " << stats.concrete.as_flp << "\n";
+		} else {
+			cerr << stats.shadow.as_int << " concrete " << stats.concrete.as_int << "\n";
+		}
 	}
 
-	return sync;
+	// reported; what is recorded from now on goes to the next report
+	syncStats.clear();
+}
+
+InterpreterObserver::~InterpreterObserver() {
+	// programs that exit without returning from main never empty the
+	// execution stack of the main thread
+	printSyncReport();
 }
 
 void InterpreterObserver::pre_allocax(IID iid UNUSED, KIND type UNUSED, uint64_t size UNUSED, int inx UNUSED,
@@ -49,7 +49,14 @@
 #include <queue>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include "IValue.h"
+#include "ExecutionStack.h"
+#include "ShadowMemory.h"
 
 using namespace std;
 
@@ -60,28 +67,154 @@ class CmpInst;
 class InterpreterObserver : public InstructionObserver {
 
 protected:
-	stack<vector<IValue*>> executionStack;
+	// Flattened layout of a struct type. The arrays of registered layouts are
+	// constants of the instrumented module.
+	struct TypeLayout {
+		unsigned length;  // number of primitive elements
+		const KIND* kinds;  // kind of each element
+		const unsigned* offsets;  // byte offset of each element
+		unsigned size;  // size of the flattened struct in bytes
+		unsigned fields;  // number of top-level fields
+		const unsigned* fieldStarts;  // element index of each top-level field
+	};
+
+	// Execution state of one thread of the analyzed program, as seen by one
+	// observer.
+	struct ThreadState {
+		ExecutionStack executionStack;
+
+		stack<KVALUE> myStack;  // store arguments of call instruction
+		vector<uint64_t> getElementPtrIndexList;  // store indices of getelementptr instruction
+		vector<uint64_t> arraySize;  // store size of array
+		vector<KIND> structType;  // store struct type
+		queue<uint64_t> structElementSize;  // store struct (non-flatten) element size
+
+		const TypeLayout* currentLayout = NULL;  // layout for the next struct operation
+		TypeLayout pushedLayout;  // layout built from push_struct_type
+		vector<KIND> pushedKinds;
+		vector<unsigned> pushedOffsets, pushedFieldStarts;
+		vector<KVALUE*> returnStruct;  // store values of returned struct
+
+		stack<int> callerVarIndex;  // index of callee register; to be assigned to the
+		// value of call return
+		stack<IValue> callArgs;  // copy value from callers to callee arguments
+		const CALLARG* pendingArgs = NULL;  // arguments of the pending call_args call
+		int pendingArgCount = 0;
+		map<int, KVALUE*> phinodeConstantValues;  // store phinode value pairs for constants
+		map<int, int> phinodeValues;  // store phinode value pairs for values
+
+		stack<int> recentBlock;  // record the most recent block visited
+		vector<vector<int>> allocaRegisters;  // registers holding an alloca, by frame depth
+		vector<pair<uint64_t, IValue*>> retired;  // released shadow blocks not yet deleted, by base address
+
+		bool isReturn = false;  // whether return instruction is just executed
+	};
+
+	/**
+	 * The execution state of the calling thread for this observer. Each
+	 * observer gets a slot in a per-thread table when it is constructed, so
+	 * the lookup is one thread-local access and an index.
+	 */
+	ThreadState& state() {
+		if (stateSlot < threadStates.size() && threadStates[stateSlot]) {
+			return *threadStates[stateSlot];
+		}
+		return newState();
+	}
+
 	vector<IValue*> globalSymbolTable;
 
 	std::string logName;
 
-	stack<KVALUE> myStack;  // store arguments of call instruction
-	vector<uint64_t> getElementPtrIndexList;  // store indices of getelementptr instruction
-	vector<uint64_t> arraySize;  // store size of array
-	vector<KIND> structType;  // store struct type
-	queue<uint64_t> structElementSize;  // store struct (non-flatten) element size
-	vector<KVALUE*> returnStruct;  // store values of returned struct
+	vector<TypeLayout> typeLayouts;  // registered layouts, by layout id
+
+	// Shadow of a heap block of the analyzed program.
+	struct HeapBlock {
+		IValue* cells;
+		unsigned count;
+	};
+	map<uint64_t, HeapBlock> heapBlocks;  // concrete address -> shadow block
+	map<uint64_t, HeapBlock> globalBlocks;  // concrete address -> shadow of a global, never released
+	uint64_t liveHeapBytes = 0, peakHeapBytes = 0;  // shadow bytes of live blocks
+	std::mutex heapLock;  // protects heapBlocks and the counters
+
+	// Whether the analyzed program runs several threads through the
+	// interpreter, set by INTERPRETER_THREADS in the environment. Only then
+	// do loads and stores lock the shadow block they access; single-threaded
+	// runs do not pay for it.
+	//
+	// Threaded mode covers the interpreter: its per-thread execution state and
+	// the shadow memory of globals and heap. The analyses built on top of it
+	// keep singletons of their own (the blame tree state, and the
+	// BlameAnalysis::get() runtimes of FastBlameAnalysis*, which are only
+	// serialized through the event buffer of libba2) and are not thread-safe.
+	static const bool threaded;
+
+	// The cells of a shadow block are guarded by the stripe of its base
+	// address, so accesses to different blocks do not serialize, while every
+	// cell of a block, whichever address it shadows, has one lock. Released
+	// blocks are retired and deleted under their stripe once the access that
+	// released them is over, so no load or store still reads them.
+	static const unsigned SHADOW_STRIPES = 64;
+	std::mutex shadowLocks[SHADOW_STRIPES];  // protect shadow blocks of globals and heap in threaded mode
+
+	std::mutex& blockLock(uint64_t base) {
+		return shadowLocks[(base >> 4) % SHADOW_STRIPES];
+	}
+
+	// Base address of the shadow block that pointer, pointing to addr, points
+	// into, or addr if there is none.
+	uint64_t blockBase(IValue* pointer, uint64_t addr);
+
+	// Hold the lock of the block a load or store accesses, in threaded mode,
+	// and delete the blocks it retired once it is over.
+	class BlockAccess {
+	public:
+		BlockAccess(InterpreterObserver& observer, IValue* pointer, uint64_t addr);
+		~BlockAccess();
+
+	private:
+		InterpreterObserver& observer;
+		std::unique_lock<std::mutex> lock;
+	};
+
+	// Delete the cells of a released block at base: right away when
+	// single-threaded, else after the current access, see BlockAccess.
+	void retire(uint64_t base, IValue* cells);
+
+	// Delete the retired blocks of the calling thread, each under its lock.
+	void deleteRetired();
+
+	ShadowMemory& shadowMemory = ShadowMemory::get();  // concrete address -> shadow cell
+	std::thread::id mainThread;  // thread that created the global symbol table
+
+	// Resynchronizations of the shadow value of a load with the concrete value.
+	struct SyncStats {
+		uint64_t count;  // number of resynchronizations
+		KIND kind;
+		VALUE shadow, concrete;  // values at the first resynchronization
+	};
+	unordered_map<IID, SyncStats> syncStats;  // load iid -> resynchronizations
+	std::mutex syncLock;  // protects syncStats in threaded mode
+
+	// Count a resynchronization of the load iid.
+	void recordSync(IID iid, KIND kind, VALUE shadow, VALUE concrete);
+
+	// Print the loads that were resynchronized most often since the last
+	// report: when the main thread returns from main, and at exit.
+	void printSyncReport();
 
-	stack<int> callerVarIndex;  // index of callee register; to be assigned to the
-	// value of call return
-	stack<IValue> callArgs;  // copy value from callers to callee arguments
-	map<int, KVALUE*> phinodeConstantValues;  // store phinode value pairs for constants
-	map<int, int> phinodeValues;  // store phinode value pairs for values
+	// Record the shadow block of the heap block at address. Blocks it
+	// overlaps are dead and retired.
+	void collect(uint64_t address, IValue* cells, unsigned count);
 
-	stack<int> recentBlock;  // record the most recent block visited
-	vector<IValue*> collect_new;
+	// Remove the shadow block of the heap block at address from the record
+	// and return it, or return a block without cells if there is none.
+	HeapBlock reclaim(uint64_t address);
 
-	bool isReturn;  // whether return instruction is just executed
+	// Create the shadow of a heap block of bytes bytes at address and make
+	// register inx point to it. Returns the new shadow block.
+	HeapBlock allocate(KIND type, int size, int inx, uint64_t address, uint64_t bytes);
 
 	double getValueFromConstant(KVALUE* op);
 
@@ -101,9 +234,9 @@ protected:
 	void castop(int64_t opVal, SCOPE opScope, KIND opKind, KIND kind, int size, int inx, CASTOP op);
 
 public:
-	InterpreterObserver(std::string name) : InstructionObserver(name) {
-		isReturn = false;
-	}
+	InterpreterObserver(std::string name) : InstructionObserver(name), stateSlot(stateSlots++) {}
+
+	virtual ~InterpreterObserver();
 
 	virtual void load(IID iid, KIND kind, SCOPE opScope, int opInx, uint64_t opAddr, bool loadGlobal, int loadInx,
 					  int inx);
@@ -195,6 +328,10 @@ public:
 									 int scopeInx02, int scopeInx03, int64_t valOrInx01, int64_t valOrInx02,
 									 int64_t valOrInx03, int size01, int size02, int inx);
 
+	virtual void getelementptr_strided(int baseInx, SCOPE baseScope, uint64_t baseAddr, int elementSize, int ptrScope,
+									   int64_t ptrValOrInx, int64_t constOffset, int count, const GEPINDEX* indices,
+									   int inx);
+
 	virtual void getelementptr_struct(IID iid, int baseInx, SCOPE baseScope, uint64_t baseAddr, int inx);
 
 	// ***** Conversion Operations ***** //
@@ -252,9 +389,13 @@ public:
 
 	virtual void phinode(IID iid, int inx);
 
+	virtual void phinode_table(IID iid, int count, const PHIARG* incoming, int inx);
+
 	virtual void select(IID iid, KVALUE* cond, KVALUE* tvalue, KVALUE* fvalue, int inx);
 
 	virtual void call(IID iid, bool nounwind, KIND type, int inx);
+
+	virtual void call_args(IID iid, bool nounwind, KIND type, int inx, int count, const CALLARG* args);
 	virtual void call_floor(IID iid, bool nounwind, IID argIID, KIND type, int inx);
 	virtual void call_sin(IID iid, bool nounwind, IID argIID, KIND type, int inx);
 	virtual void call_acos(IID iid, bool nounwind, IID argIID, KIND type, int inx);
@@ -266,6 +407,12 @@ public:
 
 	virtual void call_malloc(IID iid, bool nounwind, KIND type, int size, int inx, uint64_t mallocAddress);
 
+	virtual void call_calloc(IID iid, bool nounwind, KIND type, int size, int inx, uint64_t callocAddress);
+
+	virtual void call_realloc(IID iid, bool nounwind, KIND type, int size, int inx, uint64_t reallocAddress);
+
+	virtual void call_free(IID iid, bool nounwind);
+
 	virtual void vaarg();
 
 	virtual void landingpad();
@@ -394,6 +541,18 @@ public:
 
 	void push_struct_element_size(uint64_t s);
 
+	void register_type_layout(int id, int length, const KIND* kinds, const unsigned* offsets, int fields,
+							  const unsigned* fieldStarts);
+
+	void push_type_layout(int id);
+
+	/**
+	 * Get the struct layout for the current struct operation: the layout
+	 * pushed by id, or else the one described by push_struct_type and
+	 * push_struct_element_size. The layout is consumed.
+	 */
+	const TypeLayout& takeLayout();
+
 	void push_getelementptr_inx(uint64_t int_value);
 
 	void push_getelementptr_inx5(int scope01, int scope02, int scope03, int scope04, int scope05, int64_t vori01,
@@ -417,15 +576,19 @@ public:
 
 	void record_block_id(int id);
 
+	// Overwrite register inx, computed natively, with its concrete value.
+	void sync_register(int inx, KIND type, int64_t value);
+
 	void create_global(KVALUE* value, KVALUE* initializer);
 
 	void create_global_array(int valInx, uint64_t addr, uint32_t size, KIND type);
 
 	void printCurrentFrame();
 
-	bool syncLoad(IValue* iValue, KVALUE* concrete, KIND type);
-
-	bool syncLoad(IValue* iValue, uint64_t opAddr, KIND type);
+	// Compare the shadow value of the load iid with the concrete value at
+	// concrete and overwrite the shadow value if they differ. Returns whether
+	// the value was resynchronized.
+	bool syncLoad(IID iid, IValue* iValue, const void* concrete, KIND type);
 
 	bool checkStore(IValue* dest, KVALUE* kv);
 
@@ -446,7 +609,71 @@ public:
 	 */
 	unsigned findIndex(const IValue* cbegin, const IValue* cend, unsigned offset);
 
+	/**
+	 * Find the index for the IValue array object, given the offset and a
+	 * guess for the index. The guess is checked before falling back to the
+	 * binary search.
+	 */
+	unsigned findIndex(const IValue* cbegin, const IValue* cend, unsigned offset, int guess);
+
+	/**
+	 * Index of the element of pointer's block that the shadow memory maps at
+	 * the block's concrete address plus offset, or -1 if that address has no
+	 * cell of this block.
+	 */
+	int mappedIndex(const IValue* pointer, int offset);
+
+	/**
+	 * Map the cells of the block that pointer owns in the shadow memory.
+	 */
+	void mapBlock(const IValue* pointer);
+
+	/**
+	 * Map the block of alloca register inx of the top frame and remember the
+	 * register for resolveBlock.
+	 */
+	void mapAlloca(int inx);
+
+	/**
+	 * Find the heap block, alloca or global whose shadow covers the concrete
+	 * address addr. Returns false if there is none.
+	 */
+	bool resolveBlock(uint64_t addr, uint64_t& base, HeapBlock& block);
+
+	/**
+	 * Make pointer point at the element of block, based at the concrete
+	 * address base, that covers addr.
+	 */
+	void pointInto(IValue* pointer, uint64_t addr, uint64_t base, const HeapBlock& block);
+
+	/**
+	 * Make pointer, computed natively, point into the shadow block covering
+	 * the concrete address addr. Returns false if no block covers addr.
+	 */
+	bool bindPointer(IValue* pointer, uint64_t addr);
+
+	/**
+	 * Make cell the shadow of the concrete address addr, which no block
+	 * covers, and point pointer at it. The cell is mapped and owned like a
+	 * heap block, so a block later allocated over addr releases it.
+	 */
+	void adoptCell(IValue* pointer, uint64_t addr, const IValue& cell);
+
+	/**
+	 * Create the pointer to the element at offset newOffset of the array
+	 * pointed to by ptrArray. index is the element index used when ptrArray
+	 * is not initialized.
+	 */
+	IValue arrayElementPtr(IValue* ptrArray, unsigned offsetIntoArray, int index, int newOffset, int inx);
+
 	int actualValueToIntValue(int scope, int64_t vori);
+
+private:
+	static std::atomic<unsigned> stateSlots;  // slots handed out so far
+	static thread_local vector<std::unique_ptr<ThreadState>> threadStates;  // by slot
+	const unsigned stateSlot;
+
+	ThreadState& newState();
 };
 
 #endif /* INTERPRETER_OBSERVER_H_ */
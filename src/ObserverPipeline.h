@@ -0,0 +1,151 @@
+/**
+ * @file ObserverPipeline.h
+ * @brief Compile-time chain of instruction observers
+ */
+
+/*
+ * Copyright (c) 2013, UC Berkeley All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. All advertising materials mentioning features or use of this software must
+ * display the following acknowledgement: This product includes software
+ * developed by the UC Berkeley.
+ *
+ * 4. Neither the name of the UC Berkeley nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY UC BERKELEY ''AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL UC BERKELEY BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Author: Cuong Nguyen and Cindy Rubio-Gonzalez
+
+#ifndef OBSERVER_PIPELINE_H_
+#define OBSERVER_PIPELINE_H_
+
+#include "Common.h"
+#include "InstructionObserver.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * List of all callbacks dispatched by InstructionMonitor. HOOK is applied to
+ * the name of every callback.
+ */
+#define OBSERVER_HOOKS(HOOK) \
+	HOOK(add) HOOK(fadd) HOOK(sub) HOOK(fsub) HOOK(mul) HOOK(fmul) HOOK(udiv) \
+	HOOK(sdiv) HOOK(fdiv) HOOK(urem) HOOK(srem) HOOK(frem) HOOK(shl) \
+	HOOK(lshr) HOOK(ashr) HOOK(and_) HOOK(or_) HOOK(xor_) HOOK(extractelement) \
+	HOOK(insertelement) HOOK(shufflevector) HOOK(extractvalue) \
+	HOOK(insertvalue) HOOK(allocax) HOOK(allocax_array) HOOK(allocax_struct) \
+	HOOK(load) HOOK(load_struct) HOOK(store) HOOK(fence) HOOK(cmpxchg) \
+	HOOK(atomicrmw) HOOK(getelementptr) HOOK(getelementptr_array) \
+	HOOK(getelementptr_strided) \
+	HOOK(getelementptr_struct) HOOK(trunc) HOOK(zext) HOOK(sext) HOOK(fptrunc) \
+	HOOK(fpext) HOOK(fptoui) HOOK(fptosi) HOOK(uitofp) HOOK(sitofp) \
+	HOOK(ptrtoint) HOOK(inttoptr) HOOK(bitcast) HOOK(branch) HOOK(branch2) \
+	HOOK(indirectbr) HOOK(invoke) HOOK(resume) HOOK(return_) \
+	HOOK(return_struct_) HOOK(return2_) HOOK(switch_) HOOK(unreachable) \
+	HOOK(icmp) HOOK(fcmp) HOOK(phinode) HOOK(phinode_table) HOOK(select) HOOK(push_string) \
+	HOOK(push_stack) HOOK(push_phinode_constant_value) \
+	HOOK(push_phinode_value) HOOK(push_return_struct) \
+	HOOK(push_getelementptr_inx) HOOK(push_getelementptr_inx5) \
+	HOOK(push_array_size5) HOOK(push_getelementptr_inx2) HOOK(push_array_size) \
+	HOOK(push_struct_type) HOOK(push_struct_element_size) \
+	HOOK(register_type_layout) HOOK(push_type_layout) \
+	HOOK(construct_array_type) HOOK(after_call) HOOK(after_void_call) \
+	HOOK(after_struct_call) HOOK(create_stack_frame) \
+	HOOK(create_global_symbol_table) HOOK(record_block_id) HOOK(sync_register) HOOK(create_global) \
+	HOOK(create_global_array) HOOK(call) HOOK(call_args) HOOK(call_sin) HOOK(call_acos) \
+	HOOK(call_sqrt) HOOK(call_fabs) HOOK(call_cos) HOOK(call_log) \
+	HOOK(call_exp) HOOK(call_floor) HOOK(call_malloc) HOOK(call_calloc) \
+	HOOK(call_realloc) HOOK(call_free) HOOK(vaarg) HOOK(landingpad)
+
+/**
+ * Statically composed chain of observers.
+ *
+ * Each observer is stored by value and every callback is forwarded with a
+ * qualified, non-virtual call. The active chain is fixed when libmonitor is
+ * linked, so a callback of the analysis is called directly from the llvm_*
+ * entry point, and a callback that the analysis does not override resolves to
+ * the empty default of InstructionObserver and is compiled away.
+ */
+template <class... Observers> class ObserverPipeline;
+
+template <> class ObserverPipeline<> {
+public:
+	ObserverPipeline(std::string name UNUSED) {}
+
+#define PIPELINE_HOOK(func)                                                    \
+  template <class... Args> inline void func(Args...) {}
+
+	OBSERVER_HOOKS(PIPELINE_HOOK)
+#undef PIPELINE_HOOK
+};
+
+template <class Head, class... Tail> class ObserverPipeline<Head, Tail...> {
+public:
+	ObserverPipeline(std::string name) : head_(name), tail_(name) {
+		DEBUG_STDERR(">>> Registering observer: " << name);
+	}
+
+#define PIPELINE_HOOK(func)                                                    \
+  template <class... Args> inline void func(Args... args) {                    \
+    head_.Head::func(args...);                                                 \
+    tail_.func(args...);                                                       \
+  }
+
+	OBSERVER_HOOKS(PIPELINE_HOOK)
+#undef PIPELINE_HOOK
+
+private:
+	Head head_;
+	ObserverPipeline<Tail...> tail_;
+};
+
+/*******************************************************************************************/
+
+/**
+ * Observers that register themselves at load time with RegisterObserver, e.g.
+ * analyses built as separate plugins. They are reached through virtual calls,
+ * so this stage is only worth adding to the chain when such plugins are used.
+ */
+extern std::vector<std::unique_ptr<InstructionObserver>> observers_;
+
+class DynamicObservers {
+public:
+	DynamicObservers(std::string name UNUSED) {}
+
+#define PIPELINE_HOOK(func)                                                    \
+  template <class... Args> inline void func(Args... args) {                    \
+    for (auto &ob_ptr : observers_) {                                          \
+      ob_ptr->func(args...);                                                   \
+    }                                                                          \
+  }
+
+	OBSERVER_HOOKS(PIPELINE_HOOK)
+#undef PIPELINE_HOOK
+};
+
+#endif // OBSERVER_PIPELINE_H_
@@ -46,13 +46,13 @@
 void OutOfBoundAnalysis::getelementptr(IID, bool, KVALUE* base, KVALUE* offset, KIND, uint64_t size, bool, int,
 									   int line, int inx) {
 
-	IValue* basePtrLocation = executionStack.top()[base->inx];
+	IValue* basePtrLocation = state().executionStack.top()[base->inx];
 	IValue* ptrLocation = nullptr;
 
 	bool propagate = isOutOfBound(basePtrLocation);
 
 	if (basePtrLocation->isInitialized()) {
-		int offsetValue = offset->inx != -1 ? executionStack.top()[offset->inx]->getValue().as_int : offset->value.as_int;
+		int offsetValue = offset->inx != -1 ? state().executionStack.top()[offset->inx]->getValue().as_int : offset->value.as_int;
 
 		unsigned newOffset = (offsetValue * (size / 8)) + basePtrLocation->getOffset();
 
@@ -85,27 +85,27 @@ void OutOfBoundAnalysis::getelementptr(IID, bool, KVALUE* base, KVALUE* offset,
 	ptrLocation->setShadow((void*)shadow);
 	ptrLocation->setLineNumber(line);
 
-	executionStack.top()[inx] = ptrLocation;
+	state().executionStack.top().redirect(inx, ptrLocation);
 
 	return;
 }
 
 void OutOfBoundAnalysis::getelementptr_array(IID, bool, KVALUE* op, KIND, int, int inx) {
 
-	IValue* ptrArray = executionStack.top()[op->inx];
+	IValue* ptrArray = state().executionStack.top()[op->inx];
 	IValue* array = static_cast<IValue*>(ptrArray->getValue().as_ptr);
 
-	getElementPtrIndexList.pop();
+	state().getElementPtrIndexList.pop();
 
 	unsigned index = 1;
-	arraySize.pop();
-	while (!arraySize.empty()) {
-		index = index * arraySize.front();
-		arraySize.pop();
+	state().arraySize.pop();
+	while (!state().arraySize.empty()) {
+		index = index * state().arraySize.front();
+		state().arraySize.pop();
 	}
-	index = getElementPtrIndexList.front() * index;
-	getElementPtrIndexList.pop();
-	safe_assert(getElementPtrIndexList.empty());
+	index = state().getElementPtrIndexList.front() * index;
+	state().getElementPtrIndexList.pop();
+	safe_assert(state().getElementPtrIndexList.empty());
 
 	index = ptrArray->getIndex() + index;
 
@@ -123,18 +123,18 @@ void OutOfBoundAnalysis::getelementptr_array(IID, bool, KVALUE* op, KIND, int, i
 		cout << "[BUG WARNING] Potentially invalid memory pointer!\n" << endl;
 	}
 
-	executionStack.top()[inx] = arrayElemPtr;
+	state().executionStack.top().redirect(inx, arrayElemPtr);
 }
 
 void OutOfBoundAnalysis::getelementptr_struct(IID, bool, KVALUE* op, KIND, KIND, int inx) {
-	IValue* structPtr = executionStack.top()[op->inx];
+	IValue* structPtr = state().executionStack.top()[op->inx];
 	IValue* structBase = static_cast<IValue*>(structPtr->getValue().as_ptr);
 
 
-	getElementPtrIndexList.pop();
-	unsigned index = getElementPtrIndexList.front();
-	getElementPtrIndexList.pop();
-	safe_assert(getElementPtrIndexList.empty());
+	state().getElementPtrIndexList.pop();
+	unsigned index = state().getElementPtrIndexList.front();
+	state().getElementPtrIndexList.pop();
+	safe_assert(state().getElementPtrIndexList.empty());
 	index = structPtr->getIndex() + index;
 
 	IValue structElem = structBase[index];
@@ -151,11 +151,11 @@ void OutOfBoundAnalysis::getelementptr_struct(IID, bool, KVALUE* op, KIND, KIND,
 		cout << "[BUG WARNING] Potentially invalid memory pointer!\n" << endl;
 	}
 
-	executionStack.top()[inx] = structElemPtr;
+	state().executionStack.top().redirect(inx, structElemPtr);
 }
 
-void OutOfBoundAnalysis::load(IID, KIND type, KVALUE* src, bool, int, int, int line, int inx) {
-	IValue* srcPtrLocation = src->isGlobal ? globalSymbolTable[src->inx] : executionStack.top()[src->inx];
+void OutOfBoundAnalysis::load(IID iid, KIND type, KVALUE* src, bool, int, int, int line, int inx) {
+	IValue* srcPtrLocation = src->isGlobal ? globalSymbolTable[src->inx] : state().executionStack.top()[src->inx];
 
 	IValue* destLocation = new IValue();
 
@@ -186,7 +186,7 @@ void OutOfBoundAnalysis::load(IID, KIND type, KVALUE* src, bool, int, int, int l
 		destLocation->setType(type);
 
 		// sync load
-		bool sync = syncLoad(destLocation, src, type);
+		bool sync = syncLoad(iid, destLocation, src->value.as_ptr, type);
 
 		// sync heap if sync value
 		if (sync) {
@@ -198,7 +198,7 @@ void OutOfBoundAnalysis::load(IID, KIND type, KVALUE* src, bool, int, int, int l
 		destLocation->setLength(0);
 
 		// sync load
-		bool sync = syncLoad(destLocation, src, type);
+		bool sync = syncLoad(iid, destLocation, src->value.as_ptr, type);
 
 		// sync heap if sync value
 		if (sync) {
@@ -214,13 +214,13 @@ void OutOfBoundAnalysis::load(IID, KIND type, KVALUE* src, bool, int, int, int l
 	destLocation->setShadow((void*)shadow);
 	destLocation->setLineNumber(line);
 
-	executionStack.top()[inx] = destLocation;
+	state().executionStack.top().redirect(inx, destLocation);
 
 	return;
 }
 
 void OutOfBoundAnalysis::store(IID, KVALUE* dest, KVALUE* src, int, int line, int) {
-	IValue* destPtrLocation = dest->isGlobal ? globalSymbolTable[dest->inx] : executionStack.top()[dest->inx];
+	IValue* destPtrLocation = dest->isGlobal ? globalSymbolTable[dest->inx] : state().executionStack.top()[dest->inx];
 
 	if (isOutOfBound(destPtrLocation)) {
 		cout << line << " : [BUG WARNING] Potentially invalid memory store!\n" << endl;
@@ -229,7 +229,7 @@ void OutOfBoundAnalysis::store(IID, KVALUE* dest, KVALUE* src, int, int line, in
 
 
 	unsigned destPtrOffset = destPtrLocation->getOffset();
-	IValue* srcLocation = src->inx == -1 ? new IValue(src->kind, src->value) : executionStack.top()[src->inx];
+	IValue* srcLocation = src->inx == -1 ? new IValue(src->kind, src->value) : state().executionStack.top()[src->inx];
 
 	if (src->inx != -1) {
 		destPtrLocation->setShadow(srcLocation->getShadow());
@@ -0,0 +1,114 @@
+/**
+ * @file ShadowMemory.cpp
+ * @brief Direct-mapped shadow memory of the interpreter
+ */
+
+/*
+ * Copyright (c) 2013, UC Berkeley All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. All advertising materials mentioning features or use of this software must
+ * display the following acknowledgement: This product includes software
+ * developed by the UC Berkeley.
+ *
+ * 4. Neither the name of the UC Berkeley nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY UC BERKELEY ''AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL UC BERKELEY BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Author: Cuong Nguyen and Cindy Rubio-Gonzalez
+
+#include "ShadowMemory.h"
+
+#include <cstdlib>
+#include <sys/mman.h>
+
+#include "IValue.h"
+
+ShadowMemory& ShadowMemory::get() {
+	static ShadowMemory memory;
+	return memory;
+}
+
+ShadowMemory::ShadowMemory() {
+	// The directory spans the whole address space but is only backed by
+	// physical memory where pages are actually mapped.
+	size_t size = sizeof(std::atomic<Entry*>) << (ADDRESS_BITS - PAGE_BITS);
+	void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	safe_assert(mem != MAP_FAILED);
+	directory = static_cast<std::atomic<Entry*>*>(mem);
+}
+
+void ShadowMemory::map(uint64_t addr, IValue* cell) {
+	if (addr & GRANULE_MASK || addr >> ADDRESS_BITS) {
+		return;
+	}
+
+	std::atomic<Entry*>& slot = directory[addr >> PAGE_BITS];
+	Entry* page = slot.load(std::memory_order_acquire);
+	if (page == NULL) {
+		Entry* fresh = static_cast<Entry*>(calloc(1ULL << (PAGE_BITS - GRANULE_BITS), sizeof(Entry)));
+		safe_assert(fresh != NULL);
+		if (slot.compare_exchange_strong(page, fresh, std::memory_order_acq_rel)) {
+			page = fresh;
+		} else {
+			free(fresh);  // another thread installed the page first
+		}
+	}
+	page[(addr & PAGE_MASK) >> GRANULE_BITS].store(cell, std::memory_order_release);
+}
+
+void ShadowMemory::unmap(uint64_t addr, const IValue* cell) {
+	if (addr & GRANULE_MASK || addr >> ADDRESS_BITS) {
+		return;
+	}
+	Entry* page = directory[addr >> PAGE_BITS].load(std::memory_order_acquire);
+	if (page == NULL) {
+		return;
+	}
+	IValue* expected = const_cast<IValue*>(cell);
+	page[(addr & PAGE_MASK) >> GRANULE_BITS].compare_exchange_strong(expected, NULL);
+}
+
+bool ShadowMemory::mappable(const IValue& cell) {
+	// bit-fields share their byte with other cells
+	return cell.getType() != INT1_KIND && cell.getBitOffset() == 0;
+}
+
+void ShadowMemory::mapBlock(uint64_t base, IValue* cells, unsigned count) {
+	for (unsigned i = 0; i < count; i++) {
+		if (mappable(cells[i])) {
+			map(base + cells[i].getFirstByte(), &cells[i]);
+		}
+	}
+}
+
+void ShadowMemory::unmapBlock(uint64_t base, const IValue* cells, unsigned count) {
+	for (unsigned i = 0; i < count; i++) {
+		if (mappable(cells[i])) {
+			unmap(base + cells[i].getFirstByte(), &cells[i]);
+		}
+	}
+}
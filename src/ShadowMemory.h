@@ -0,0 +1,125 @@
+/**
+ * @file ShadowMemory.h
+ * @brief Direct-mapped shadow memory of the interpreter
+ */
+
+/*
+ * Copyright (c) 2013, UC Berkeley All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. All advertising materials mentioning features or use of this software must
+ * display the following acknowledgement: This product includes software
+ * developed by the UC Berkeley.
+ *
+ * 4. Neither the name of the UC Berkeley nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY UC BERKELEY ''AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL UC BERKELEY BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Author: Cuong Nguyen and Cindy Rubio-Gonzalez
+
+#ifndef SHADOW_MEMORY_H_
+#define SHADOW_MEMORY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class IValue;
+
+/**
+ * Map from concrete address to the IValue that shadows the memory at that
+ * address, organized as a two-level page table: a directory indexed by the
+ * high address bits, and lazily allocated pages with one entry per 4-byte
+ * granule. A lookup is two loads, independent of how the address was
+ * computed.
+ *
+ * Every shadow block (alloca, heap block, global) is mapped when it is
+ * created and unmapped by address when it is released or reallocated, so
+ * for the cells it covers the map is the authority: loads, stores and
+ * getelementptr consult it before the pointer metadata. The map does not own
+ * the cells. Cells that do not start on a granule, and bit-field cells after
+ * the first one of a byte, are not mapped and are reached through the
+ * pointer metadata.
+ */
+class ShadowMemory {
+public:
+	static ShadowMemory& get();
+
+	/**
+	 * Return the cell shadowing addr, or NULL if none is mapped.
+	 */
+	IValue* find(uint64_t addr) const {
+		if (addr & GRANULE_MASK || addr >> ADDRESS_BITS) {
+			return NULL;
+		}
+		Entry* page = directory[addr >> PAGE_BITS].load(std::memory_order_acquire);
+		if (page == NULL) {
+			return NULL;
+		}
+		return page[(addr & PAGE_MASK) >> GRANULE_BITS].load(std::memory_order_acquire);
+	}
+
+	/**
+	 * Record that cell shadows addr, replacing any previous cell. Unaligned
+	 * addresses are ignored.
+	 */
+	void map(uint64_t addr, IValue* cell);
+
+	/**
+	 * Remove the entry of addr if it still refers to cell.
+	 */
+	void unmap(uint64_t addr, const IValue* cell);
+
+	/**
+	 * Map the count cells of a block whose concrete memory starts at base;
+	 * each cell is placed at base plus its first byte.
+	 */
+	void mapBlock(uint64_t base, IValue* cells, unsigned count);
+
+	/**
+	 * Unmap the cells of a block mapped by mapBlock before it is released.
+	 */
+	void unmapBlock(uint64_t base, const IValue* cells, unsigned count);
+
+private:
+	typedef std::atomic<IValue*> Entry;
+
+	static const unsigned ADDRESS_BITS = 48;
+	static const unsigned PAGE_BITS = 22;
+	static const unsigned GRANULE_BITS = 2;
+	static const uint64_t PAGE_MASK = (1ULL << PAGE_BITS) - 1;
+	static const uint64_t GRANULE_MASK = (1ULL << GRANULE_BITS) - 1;
+
+	ShadowMemory();
+	ShadowMemory(const ShadowMemory&) = delete;
+	ShadowMemory& operator=(const ShadowMemory&) = delete;
+
+	static bool mappable(const IValue& cell);
+
+	std::atomic<Entry*>* directory;
+};
+
+#endif // SHADOW_MEMORY_H_
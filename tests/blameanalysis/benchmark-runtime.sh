@@ -0,0 +1,98 @@
+#!/bin/bash
+
+# Compare the slowdown of the analysis runtime linked as a shared library
+# (lib$BA_LIB.so) against the runtime linked into the program as bitcode
+# (lib$BA_LIB.bc, see instrumentfp2-bc.sh).
+#
+# Use: ./benchmark-runtime.sh [test directory ...]    (default: gsl nas)
+#
+# For every program listed in <test directory>/travis-tests.txt, prints the
+# running time of the native program and the slowdown factor of both
+# instrumented versions, followed by the geometric mean of the slowdowns.
+# All versions are compiled with $OPT_LEVEL. The table is also written to
+# $RESULTS (default: benchmark-results.txt), together with the revision and
+# the settings it was measured with, so that runs before and after a change
+# of the runtime can be compared.
+
+export THIS_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+cd "$THIS_DIR"
+
+export CC=$LLVM_BIN_PATH"/clang"
+export LDFLAGS="-L"$INSTRUMENTOR_LIB_PATH" -L"$BLAMEANALYSIS_LIB_PATH""
+export BA_LIB=${BA_LIB:-ba3}
+export OPT_LEVEL=${OPT_LEVEL:--O2}
+export RESULTS=${RESULTS:-$THIS_DIR/benchmark-results.txt}
+
+TIMEFORMAT=%R
+
+# Run the executable and print its wall-clock time in seconds.
+function run_time() {
+	{ time $1 > /dev/null 2>&1 ; } 2>&1
+}
+
+function benchmark_dir() {
+	while read program
+	do
+		cd $program
+
+		# native and shared library versions
+		name=$(basename $program .c)
+		if [ ! -f $name.bc ]
+		then
+			$LLVM_BIN_PATH/clang -emit-llvm -g -Xclang -dwarf-column-info -c $name.c -o $name.bc
+		fi
+		EXCLUDE=""
+		if [ -f exclude.txt ]
+		then
+			EXCLUDE="-exclude exclude.txt"
+		fi
+		$LLVM_BIN_PATH/opt -load $FPPASS_LIB_PATH/FPPass.so -fppass -f -o $name-fp.bc $name.bc $EXCLUDE
+		$CC $OPT_LEVEL $name.bc -o $name-native.out $LDFLAGS -lpthread -lm -lrt -lgmp
+		$CC $OPT_LEVEL $name-fp.bc -o $name-so.out $LDFLAGS -l$BA_LIB -lpthread -lm -lrt -lgmp
+
+		# bitcode version
+		$THIS_DIR/instrumentfp2-bc.sh $program > /dev/null 2>&1
+
+		# analyze from the same starting points and precisions as the tests
+		for version in so bc
+		do
+			for config in point precision ic
+			do
+				if [ -f $name.out.$config ]
+				then
+					cp $name.out.$config $name-$version.out.$config
+				fi
+			done
+		done
+
+		native=$(run_time ./$name-native.out)
+		so=$(run_time ./$name-so.out)
+		bc=$(run_time ./$name-bc.out)
+
+		echo "$1/$program $native $so $bc" | awk '{
+			printf "%-30s native %8.3fs   so %8.2fx   bc %8.2fx\n", $1, $2, $3 / $2, $4 / $2
+		}' | tee -a $RESULTS
+
+		rm -f $name-native.out* $name-so.out* $name-bc.out*
+		cd ..
+	done < travis-tests.txt
+}
+
+echo "# $(date -u '+%Y-%m-%d %H:%M') revision $(git rev-parse --short HEAD 2>/dev/null)" \
+	"lib$BA_LIB $OPT_LEVEL" >> $RESULTS
+start=$(wc -l < $RESULTS)
+
+dirs=${@:-gsl nas}
+for a in $dirs
+do
+	cd $a
+	benchmark_dir $a
+	cd "$THIS_DIR"
+done
+
+# geometric mean of the slowdowns of this run
+tail -n +$((start + 1)) $RESULTS | awk '{
+	so += log($5); bc += log($7); n++
+} END {
+	if (n > 0) printf "%-30s                     so %8.2fx   bc %8.2fx\n", "geomean", exp(so / n), exp(bc / n)
+}' | tee -a $RESULTS
@@ -0,0 +1,128 @@
+// Checks the batched blame search of PrecisionPairs.h (and of the shadow
+// kernels of libba2 when built with -DSHADOW_KERNELS) against the pair by
+// pair search it replaces, on random operands. Built once against the
+// precisions of each runtime, see blame-search-test.sh.
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "BlameUtilities.h"
+#include "PrecisionPairs.h"
+#ifdef SHADOW_KERNELS
+#include "ShadowKernels.h"
+#endif
+
+static const unsigned PAIRS = 100000;
+
+static std::mt19937_64 rng(20161017);
+
+#ifndef SHADOW_KERNELS
+static PairMask blameMask(HIGHPRECISION result, const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op,
+						  PRECISION p) {
+	HIGHPRECISION candidates[PRECISION_NO * PRECISION_NO];
+	pairCandidates(l, r, op, p, candidates);
+	return equalMask(result, candidates, PRECISION_NO * PRECISION_NO, p);
+}
+#endif
+
+static PairMask referenceBlameMask(HIGHPRECISION result, const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op,
+								   PRECISION p) {
+	PairMask mask = 0;
+	for (unsigned i = 0; i < PRECISION_NO; i++) {
+		for (unsigned j = 0; j < PRECISION_NO; j++) {
+			HIGHPRECISION candidate =
+				clearBits(feval<HIGHPRECISION>(l[i], r[j], op), DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]);
+			mask |= PairMask(equalWithinPrecision(result, candidate, p)) << (i * PRECISION_NO + j);
+		}
+	}
+	return mask;
+}
+
+static PairMask referenceFcmpMask(const HIGHPRECISION* l, const HIGHPRECISION* r, CMPOP op, bool truthVal) {
+	PairMask mask = 0;
+	for (unsigned i = 0; i < PRECISION_NO; i++) {
+		for (unsigned j = 0; j < PRECISION_NO; j++) {
+			mask |= PairMask(fcmp_eval<HIGHPRECISION>(l[i], r[j], op) == truthVal) << (i * PRECISION_NO + j);
+		}
+	}
+	return mask;
+}
+
+// A random operand, with the special values and small ranges that make the
+// precisions agree or disagree.
+static HIGHPRECISION randomValue() {
+	switch (rng() % 16) {
+		case 0:
+			return NAN;
+		case 1:
+			return (rng() & 1) ? INFINITY : -INFINITY;
+		case 2:
+			return 0.0;
+		case 3:
+			return 1e-310 * (rng() % 1000);
+		case 4:
+			return (double)(int)(rng() % 64) - 32;
+		default: {
+			std::uniform_real_distribution<double> mantissa(-1.0, 1.0);
+			return std::ldexp(mantissa(rng), (int)(rng() % 80) - 40);
+		}
+	}
+}
+
+// The shadow object of v, as the runtime builds it.
+static void shadow(HIGHPRECISION v, HIGHPRECISION* values) {
+	values[BITS_FLOAT] = (LOWPRECISION)v;
+	for (unsigned p = BITS_FLOAT + 1; p < PRECISION_NO; p++) {
+		values[p] = clearBits(v, DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]);
+	}
+}
+
+// A result near one of the candidates, so that some of the pairs pass.
+static HIGHPRECISION randomResult(const HIGHPRECISION* l, const HIGHPRECISION* r, FBINOP op, PRECISION p) {
+	HIGHPRECISION v = feval<HIGHPRECISION>(l[rng() % PRECISION_NO], r[rng() % PRECISION_NO], op);
+	if (rng() % 4 == 0) {
+		return randomValue();
+	}
+	if (std::isnan(v) || std::isinf(v)) {
+		return v;
+	}
+	uint64_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	bits += (int64_t)(rng() % 5 - 2) << (DOUBLE_MANTISSA_LENGTH - PRECISION_BITS[p]);
+	memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+int main() {
+	unsigned failures = 0;
+	for (unsigned n = 0; n < PAIRS; n++) {
+		HIGHPRECISION l[PRECISION_NO], r[PRECISION_NO];
+		shadow(randomValue(), l);
+		shadow(randomValue(), r);
+
+		FBINOP op = FBINOP(rng() % FBINOP_NO);
+		PRECISION p = PRECISION(rng() % PRECISION_NO);
+		HIGHPRECISION result = randomResult(l, r, op, p);
+		PairMask expected = referenceBlameMask(result, l, r, op, p);
+		PairMask actual = blameMask(result, l, r, op, p);
+		if (actual != expected) {
+			fprintf(stderr, "blameMask(%a, op %d, p %d): %llx instead of %llx\n", result, op, p,
+					(unsigned long long)actual, (unsigned long long)expected);
+			failures++;
+		}
+
+		CMPOP cmp = CMPOP(rng() % CMPOP_NO);
+		bool truthVal = fcmp_eval<HIGHPRECISION>(l[BITS_DOUBLE], r[BITS_DOUBLE], cmp);
+		if (fcmpMask(l, r, cmp, truthVal) != referenceFcmpMask(l, r, cmp, truthVal)) {
+			fprintf(stderr, "fcmpMask(%a, %a, op %d) differs\n", l[BITS_DOUBLE], r[BITS_DOUBLE], cmp);
+			failures++;
+		}
+	}
+
+	if (failures != 0) {
+		fprintf(stderr, "%u of %u pairs differ\n", failures, PAIRS);
+		return 1;
+	}
+	return 0;
+}
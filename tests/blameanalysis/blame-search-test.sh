@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# Check that the batched blame search (PrecisionPairs.h, and the shadow
+# kernels of libba2) finds the same precision pairs as the pair by pair
+# search, on random operands, with the precisions of libba2 and libba3.
+#
+# Use: ./blame-search-test.sh
+
+export THIS_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+cd "$THIS_DIR"
+
+CXX=${CXX:-g++}
+ROOT=../..
+COMMON="-std=c++11 -O2 -I$ROOT/FastBlameAnalysis-Common"
+
+$CXX $COMMON -I$ROOT/FastBlameAnalysis -DSHADOW_KERNELS blame-search-test.cpp \
+	$ROOT/FastBlameAnalysis/ShadowKernels.cpp -o blame-search-ba2.out || exit 1
+$CXX $COMMON -I$ROOT/FastBlameAnalysis2 blame-search-test.cpp -o blame-search-ba3.out || exit 1
+
+for runtime in ba2 ba3
+do
+	echo "Checking the blame search of lib$runtime ..."
+	if ! ./blame-search-$runtime.out
+	then
+		echo "lib$runtime: the batched blame search differs!"
+		exit 1
+	fi
+done
+rm -f blame-search-ba2.out blame-search-ba3.out
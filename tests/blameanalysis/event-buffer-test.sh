@@ -0,0 +1,66 @@
+#!/bin/bash
+
+# Check that the event buffer of libba2 does not change the analysis: every
+# program listed in <test directory>/travis-tests.txt is run with the events
+# processed one by one, buffered (BA_EVENT_BUFFER) and buffered on the
+# analysis thread (BA_ASYNC), and the blame reports of the three runs must be
+# the same.
+#
+# Use: ./event-buffer-test.sh [test directory ...]    (default: regressions)
+
+export THIS_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+cd "$THIS_DIR"
+
+export CC=$LLVM_BIN_PATH"/clang"
+export LDFLAGS="-L"$INSTRUMENTOR_LIB_PATH" -L"$BLAMEANALYSIS_LIB_PATH""
+
+# Run the program in the given mode and keep its reports under that name.
+function run_mode() {
+	env $2 ./$1.out > /dev/null 2>&1
+	for report in ba ba.full trace
+	do
+		sort $1.out.$report > $1.$3.$report
+	done
+}
+
+function test_dir() {
+	while read program
+	do
+		cd $program
+		name=$(basename $program .c)
+		echo "Checking $program ..."
+
+		if [ ! -f $name.bc ]
+		then
+			$LLVM_BIN_PATH/clang -emit-llvm -g -Xclang -dwarf-column-info -c $name.c -o $name.bc
+		fi
+		$LLVM_BIN_PATH/opt -load $FPPASS_LIB_PATH/FPPass.so -fppass -f -o $name-fp.bc $name.bc
+		$CC $name-fp.bc -o $name.out $LDFLAGS -lba2 -lpthread -lm -lrt -lgmp
+
+		run_mode $name "" direct
+		run_mode $name BA_EVENT_BUFFER=1 buffered
+		run_mode $name BA_ASYNC=1 async
+
+		for report in ba ba.full trace
+		do
+			for mode in buffered async
+			do
+				if ! diff -q $name.direct.$report $name.$mode.$report > /dev/null
+				then
+					echo "$program: $mode .$report differs from the unbuffered run!"
+					exit 1
+				fi
+			done
+		done
+		rm -f $name.out* $name.direct.* $name.buffered.* $name.async.* $name-fp.bc
+		cd ..
+	done < travis-tests.txt
+}
+
+dirs=${@:-regressions}
+for a in $dirs
+do
+	cd $a
+	test_dir
+	cd "$THIS_DIR"
+done
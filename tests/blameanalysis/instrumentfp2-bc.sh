@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Same as instrumentfp2.sh, but links the analysis runtime into the
+# instrumented bitcode (from $BLAMEANALYSIS_LIB_PATH/lib$BA_LIB.bc) and
+# optimizes the whole module before code generation, so that the callbacks
+# are inlined at each call site.
+#
+# Use: ../../instrumentfp2-bc.sh program (from within the program directory)
+
+export CC=$LLVM_BIN_PATH"/clang"
+export LDFLAGS="-L"$INSTRUMENTOR_LIB_PATH" -L"$BLAMEANALYSIS_LIB_PATH""
+
+BA_LIB=${BA_LIB:-ba3}
+OPT_LEVEL=${OPT_LEVEL:--O2}
+
+name=$(basename $1 .c)
+
+# Compile into bitcode, unless the program provides its own (e.g. gsl)
+if [ ! -f $name.bc ]
+then
+	$LLVM_BIN_PATH/clang -emit-llvm -g -Xclang -dwarf-column-info -c $name.c -o $name.bc
+fi
+
+EXCLUDE=""
+if [ -f exclude.txt ]
+then
+	EXCLUDE="-exclude exclude.txt"
+fi
+
+# Instrument the bitcode
+$LLVM_BIN_PATH/opt -load $FPPASS_LIB_PATH/FPPass.so -fppass -f -o $name-fp.bc $name.bc $EXCLUDE
+
+# Link the runtime into the instrumented module and inline it
+$LLVM_BIN_PATH/llvm-link -o $name-fp-rt.bc $name-fp.bc $BLAMEANALYSIS_LIB_PATH/lib$BA_LIB.bc
+$LLVM_BIN_PATH/opt $OPT_LEVEL -f -o $name-fp-rt-opt.bc $name-fp-rt.bc
+
+# Create executable for instrumented bitcode file
+$CC $OPT_LEVEL $name-fp-rt-opt.bc -o $name-bc.out $LDFLAGS -lstdc++ -lpthread -lm -lrt -lgmp
+
+# Clean temporary files
+rm $name-fp-rt.bc
+rm $name-fp-rt-opt.bc
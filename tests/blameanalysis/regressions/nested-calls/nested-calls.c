@@ -0,0 +1,42 @@
+#include <stdio.h>
+
+// Defined first, so that IID 0, the default starting point, has no debug
+// information, as in the other references.
+__attribute__((nodebug)) double identity(double x) {
+  return x;
+}
+
+double square(double x) {
+  return x * x;
+}
+
+// Nested calls: square is called while the frame of norm is open.
+double norm(double a, double b) {
+  return square(a) + square(b);
+}
+
+// Recursive calls: every level has its own argument and return binding.
+double power(double x, int n) {
+  if (n == 0)
+    return 1.0;
+  return x * power(x, n - 1);
+}
+
+// Indirect call: the return of square binds to the frame pushed for f.
+double apply(double (*f)(double), double x) {
+  return f(x);
+}
+
+int main() {
+  int i;
+  double x;
+  double result = 0.0;
+
+  for (i = 1; i <= 10; i++) {
+    x = identity(1.0 + i / 16.0);
+    result += norm(power(x, i), apply(square, x));
+  }
+
+  printf("result: %.10f\n", result);
+  return 0;
+}
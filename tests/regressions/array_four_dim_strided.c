@@ -0,0 +1,25 @@
+#include <stdio.h>
+
+int main() {
+  double x[3][4][5][6];
+
+  for(int i = 0; i < 3; i++) {
+    for(int j = 0; j < 4; j++) {
+      for(int k = 0; k < 5; k++) {
+        for(int l = 0; l < 6; l++) {
+          x[i][j][k][l] = i + j*0.5 + k*0.25 + l*0.125;
+        }
+      }
+    }
+  }
+
+  // strided walk mixing constant and dynamic indices
+  double y = 0.0;
+  for(int j = 0; j < 4; j += 2) {
+    for(int l = 1; l < 6; l += 3) {
+      y += x[2][j][4][l] - x[1][j][0][l-1];
+    }
+  }
+
+  return (int) y;
+}
@@ -0,0 +1,18 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+int main() {
+  float* a = (float*) calloc(6, sizeof(float));
+
+  // elements are zero before the first store
+  float b = a[4];
+
+  for(unsigned i = 0; i < 6; i++) {
+    a[i] = a[i] + i*1.5f;
+  }
+
+  float c = a[5] + b;
+  free(a);
+
+  return (int) c;
+}
@@ -0,0 +1,22 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+int main() {
+  long* a = (long*) malloc(sizeof(long)*5);
+
+  for(unsigned i = 0; i < 5; i++) {
+    a[i] = i*3;
+  }
+  long b = a[4];
+  free(a);
+
+  // the freed block may be handed out again with another kind
+  double* c = (double*) malloc(sizeof(double)*5);
+  for(unsigned i = 0; i < 5; i++) {
+    c[i] = i / 2.0;
+  }
+  double d = c[4];
+  free(c);
+
+  return (int) (b + d);
+}
@@ -0,0 +1,31 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+int main() {
+  double* a = (double*) malloc(sizeof(double)*4);
+
+  for(unsigned i = 0; i < 4; i++) {
+    a[i] = i + 0.5;
+  }
+
+  // grow: the old elements must keep their shadow values
+  a = (double*) realloc(a, sizeof(double)*8);
+  for(unsigned i = 4; i < 8; i++) {
+    a[i] = a[i-4] * 2.0;
+  }
+
+  // shrink: only the first two elements survive
+  a = (double*) realloc(a, sizeof(double)*2);
+  double b = a[0] + a[1];
+
+  // kind change: the block is reused with a different element type
+  int* c = (int*) realloc(a, sizeof(int)*6);
+  for(unsigned i = 0; i < 6; i++) {
+    c[i] = i+1;
+  }
+
+  int d = c[5] + (int) b;
+  free(c);
+
+  return d;
+}
@@ -0,0 +1,32 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Run with slice mode: ./instrument.sh sync10 -fpSliceOnly
+ *
+ * Expected number of syncs: 0
+ *
+ * The loop index and the element addresses are computed natively, so every
+ * load and store gets its pointer through llvm_sync_register. The pointers
+ * must land on the cells of the local and heap arrays; loads through them
+ * read the values stored by the previous loop and need no sync.
+ */
+int main() {
+  double a[10];
+  double* h = (double*) malloc(10*sizeof(double));
+  double sum = 0.0;
+  int i;
+
+  for (i = 0; i < 10; i++) {
+    a[i] = i*0.5;
+    h[i] = a[i] + 1.0;
+  }
+
+  for (i = 0; i < 10; i++) {
+    sum += a[i] * h[i]; // no sync here
+  }
+
+  free(h);
+  printf("%f\n", sum);
+  return 0;
+}